@@ -0,0 +1,3 @@
+/* Generated by tests/Makefile.inc, do not edit */
+#undef CONFIG_AZALIA_CORB_RIRB
+#define CONFIG_AZALIA_CORB_RIRB 1
@@ -0,0 +1,3 @@
+/* Generated by tests/Makefile.inc, do not edit */
+#undef CONFIG_DRIVERS_I2C_DESIGNWARE_CLOCK_MHZ
+#define CONFIG_DRIVERS_I2C_DESIGNWARE_CLOCK_MHZ 120
@@ -0,0 +1 @@
+/* Generated by tests/Makefile.inc, do not edit */
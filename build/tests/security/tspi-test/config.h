@@ -0,0 +1,11 @@
+/* Generated by tests/Makefile.inc, do not edit */
+#undef CONFIG_TPM1
+#define CONFIG_TPM1 0
+#undef CONFIG_TPM2
+#define CONFIG_TPM2 1
+#undef CONFIG_TPM_MEASURED_BOOT
+#define CONFIG_TPM_MEASURED_BOOT 1
+#undef CONFIG_TPM_MEASURED_BOOT_QUEUE
+#define CONFIG_TPM_MEASURED_BOOT_QUEUE 1
+#undef CONFIG_TPM_TIS_ASYNC
+#define CONFIG_TPM_TIS_ASYNC 1
@@ -5,6 +5,7 @@
  * Reference: ARM Architecture Reference Manual, ARMv8-A edition
  */
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #include <arch/cache.h>
@@ -86,14 +87,27 @@ void dcache_invalidate_by_mva(void const *addr, size_t len)
 
 /*
  * For each segment of a program loaded this function is called
- * to invalidate caches for the addresses of the loaded segment
+ * to invalidate caches for the addresses of the loaded segment.
+ *
+ * Walking a large segment line by line by VA costs far more than a single
+ * set/way pass over the whole cache, so switch to the latter above the
+ * configured threshold (like armv7 always does).
  */
 void arch_segment_loaded(uintptr_t start, size_t size, int flags)
 {
 	uint32_t sctlr = raw_read_sctlr_el3();
-	if (sctlr & SCTLR_C)
-		dcache_clean_by_mva((void *)start, size);
-	else if (sctlr & SCTLR_I)
-		dcache_clean_invalidate_by_mva((void *)start, size);
+	bool whole_cache = size >= CONFIG_ARM64_CACHE_SET_WAY_THRESHOLD;
+
+	if (sctlr & SCTLR_C) {
+		if (whole_cache)
+			dcache_clean_all();
+		else
+			dcache_clean_by_mva((void *)start, size);
+	} else if (sctlr & SCTLR_I) {
+		if (whole_cache)
+			dcache_clean_invalidate_all();
+		else
+			dcache_clean_invalidate_by_mva((void *)start, size);
+	}
 	icache_invalidate_all();
 }
@@ -15,6 +15,11 @@
  * value on stage transition, so we still need to check it for UNUSED_DESC. */
 static uint64_t *next_free_table = (void *)_ttb;
 
+/* Nesting depth of mmu_config_begin()/mmu_config_commit() pairs. While it is
+ * non-zero, mmu_config_range() only updates the tables and leaves the TLB
+ * invalidation to the outermost mmu_config_commit(). */
+static int config_batch_depth;
+
 static void print_tag(int level, uint64_t tag)
 {
 	printk(level, tag & MA_MEM_NC ? "non-cacheable | " :
@@ -201,6 +206,19 @@ static void assert_correct_ttb_mapping(void *addr)
 	       == BLOCK_INDEX_MEM_NORMAL && !(pte & BLOCK_NS));
 }
 
+/* Func : mmu_config_commit_tlb
+ * Desc : Make page table updates visible to the table walker and drop any
+ * stale translations.
+ */
+static void mmu_config_commit_tlb(void)
+{
+	/* ARMv8 MMUs snoop L1 data cache, no need to flush it. */
+	dsb();
+	tlbiall_el3();
+	dsb();
+	isb();
+}
+
 /* Func : mmu_config_range
  * Desc : This function repeatedly calls init_xlat_table with the base
  * address. Based on size returned from init_xlat_table, base_addr is updated
@@ -222,11 +240,30 @@ void mmu_config_range(void *start, size_t size, uint64_t tag)
 		temp_size -= init_xlat_table(base_addr + (size - temp_size),
 					     temp_size, tag);
 
-	/* ARMv8 MMUs snoop L1 data cache, no need to flush it. */
-	dsb();
-	tlbiall_el3();
-	dsb();
-	isb();
+	if (!config_batch_depth)
+		mmu_config_commit_tlb();
+}
+
+/* Func : mmu_config_begin
+ * Desc : Start a batch of mmu_config_range() calls. The TLB is not invalidated
+ * until the matching mmu_config_commit(), so code must not rely on any of the
+ * batched mappings taking effect before then. Batches may be nested.
+ */
+void mmu_config_begin(void)
+{
+	config_batch_depth++;
+}
+
+/* Func : mmu_config_commit
+ * Desc : Finish a batch started with mmu_config_begin(). The outermost commit
+ * performs a single TLB invalidation for all ranges configured in the batch.
+ */
+void mmu_config_commit(void)
+{
+	assert(config_batch_depth > 0);
+
+	if (--config_batch_depth == 0)
+		mmu_config_commit_tlb();
 }
 
 /* Func : mmu_init
@@ -292,6 +329,7 @@ void mmu_restore_context(const struct mmu_context *mmu_context)
 
 void mmu_enable(void)
 {
+	assert(!config_batch_depth);
 	assert_correct_ttb_mapping(_ttb);
 	assert_correct_ttb_mapping(_ettb - 1);
 
@@ -148,6 +148,9 @@ void mmu_save_context(struct mmu_context *mmu_context);
 void mmu_restore_context(const struct mmu_context *mmu_context);
 /* Change a memory type for a range of bytes at runtime. */
 void mmu_config_range(void *start, size_t size, uint64_t tag);
+/* Batch mmu_config_range() calls, invalidating the TLB only once on commit. */
+void mmu_config_begin(void);
+void mmu_config_commit(void);
 /* Enable the MMU (need previous mmu_init() and configured ranges!). */
 void mmu_enable(void);
 /* Disable the MMU (which also disables dcache but not icache). */
@@ -3,6 +3,8 @@
 #ifndef _RISCV_SMP_H
 #define _RISCV_SMP_H
 
+#include <stddef.h>
+
 /*
  * This function is used to pause smp. Only the hart with hartid equal
  * to working_hartid can be returned from smp_pause, other harts will
@@ -17,4 +19,16 @@ void smp_pause(int working_hartid);
  */
 void smp_resume(void (*fn)(void *), void *arg);
 
+/*
+ * Run fn on count harts at once (clamped to CONFIG_MAX_CPUS): on the calling
+ * working hart as index 0 and on count - 1 harts halted in smp_pause() as
+ * index 1 to count - 1. Returns once every hart has finished. The other harts
+ * run fn with interrupts off on their small machine stack, so keep it simple.
+ */
+void smp_run_parallel(void (*fn)(void *arg, int index, int count), void *arg,
+		      int count);
+
+/* memset() split across all harts with smp_run_parallel() for large sizes. */
+void smp_memset(void *s, int c, size_t n);
+
 #endif
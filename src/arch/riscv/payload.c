@@ -5,9 +5,16 @@
 #include <arch/boot.h>
 #include <arch/encoding.h>
 #include <arch/smp/atomic.h>
+#include <arch/smp/smp.h>
 #include <console/console.h>
 #include <vm.h>
 
+/* Payload BSS can be large, let all harts clear it. */
+void payload_arch_clear_segment(void *start, size_t size)
+{
+	smp_memset(start, 0, size);
+}
+
 /* Run OpenSBI and let OpenSBI hand over control to the payload */
 void run_payload_opensbi(struct prog *prog, void *fdt, struct prog *opensbi, int payload_mode)
 {
@@ -1,10 +1,43 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
+#include <arch/barrier.h>
 #include <arch/encoding.h>
 #include <arch/smp/smp.h>
 #include <arch/smp/spinlock.h>
+#include <commonlib/helpers.h>
 #include <mcall.h>
 #include <console/console.h>
+#include <string.h>
+
+/* Work handed to parked harts by smp_run_parallel(). */
+static struct {
+	void (*fn)(void *arg, int index, int count);
+	void *arg;
+	int count;
+	/* Number of parked harts that haven't finished their share yet. */
+	atomic_t remaining;
+	/* Per hart: index + 1 of the work posted to it, 0 if there is none. */
+	atomic_t slot[CONFIG_MAX_CPUS];
+} hart_work;
+
+/*
+ * Run the work posted to this hart, if any. Returns 0 if the wakeup was
+ * not for smp_run_parallel() but for smp_resume().
+ */
+static int smp_run_posted_work(int hartid)
+{
+	int slot = atomic_swap(&hart_work.slot[hartid], 0);
+
+	if (!slot)
+		return 0;
+
+	mb();
+	hart_work.fn(hart_work.arg, slot - 1, hart_work.count);
+	mb();
+	atomic_dec(&hart_work.remaining);
+
+	return 1;
+}
 
 void smp_pause(int working_hartid)
 {
@@ -25,11 +58,14 @@ void smp_pause(int working_hartid)
 		/* count how many cores enter the halt */
 		atomic_add(&SYNCB, 1);
 
+		/* Serve smp_run_parallel() until smp_resume() comes along. */
 		do {
-			barrier();
-			__asm__ volatile ("wfi");
-		} while ((read_csr(mip) & MIP_MSIP) == 0);
-		set_msip(hartid, 0);
+			do {
+				barrier();
+				__asm__ volatile ("wfi");
+			} while ((read_csr(mip) & MIP_MSIP) == 0);
+			set_msip(hartid, 0);
+		} while (smp_run_posted_work(hartid));
 		HLS()->entry.fn(HLS()->entry.arg);
 	} else {
 		/* Initialize the counter and
@@ -71,3 +107,90 @@ void smp_resume(void (*fn)(void *), void *arg)
 
 	HLS()->entry.fn(HLS()->entry.arg);
 }
+
+void smp_run_parallel(void (*fn)(void *arg, int index, int count), void *arg,
+		      int count)
+{
+	int hartid = read_csr(mhartid);
+	int index = 1;
+
+	if (fn == NULL)
+		die("must pass a non-null function pointer\n");
+
+	count = MAX(1, MIN(count, CONFIG_MAX_CPUS));
+
+	hart_work.fn = fn;
+	hart_work.arg = arg;
+	hart_work.count = count;
+	atomic_set(&hart_work.remaining, count - 1);
+
+	for (int i = 0; i < CONFIG_MAX_CPUS && index < count; i++) {
+		if (i == hartid)
+			continue;
+		atomic_set(&hart_work.slot[i], index + 1);
+		/* Publish the work before the IPI can wake the hart up. */
+		mb();
+		set_msip(i, 1);
+		index++;
+	}
+
+	fn(arg, 0, count);
+
+	while (atomic_read(&hart_work.remaining) != 0)
+		barrier();
+	mb();
+}
+
+/* Clears below this size are not worth waking up the other harts for. */
+#define SMP_MEMSET_MIN_SIZE	(64 * KiB)
+
+struct smp_memset_args {
+	uint8_t *s;
+	int c;
+	size_t n;
+};
+
+/*
+ * Start of chunk 'index' of 'count'. The boundaries between chunks are
+ * aligned to cache lines in the address space, so no two harts write the
+ * same line; only the first and the last chunk get the unaligned ends.
+ */
+static uintptr_t smp_memset_boundary(const struct smp_memset_args *args,
+				     int index, int count)
+{
+	const uintptr_t start = (uintptr_t)args->s;
+	const uintptr_t end = start + args->n;
+	uintptr_t boundary;
+
+	if (index == 0)
+		return start;
+	if (index == count)
+		return end;
+
+	boundary = ALIGN_UP(start + args->n / count * index, 64);
+	return MIN(boundary, end);
+}
+
+static void smp_memset_chunk(void *arg, int index, int count)
+{
+	const struct smp_memset_args *args = arg;
+	uintptr_t start = smp_memset_boundary(args, index, count);
+	uintptr_t end = smp_memset_boundary(args, index + 1, count);
+
+	if (start >= end)
+		return;
+
+	memset((void *)start, args->c, end - start);
+}
+
+void smp_memset(void *s, int c, size_t n)
+{
+	struct smp_memset_args args = { .s = s, .c = c, .n = n };
+
+	if (CONFIG_MAX_CPUS == 1 || n < SMP_MEMSET_MIN_SIZE) {
+		memset(s, c, n);
+		return;
+	}
+
+	smp_run_parallel(smp_memset_chunk, &args, CONFIG_MAX_CPUS);
+}
@@ -9,6 +9,7 @@
 #include <fallback.h>
 #include <timestamp.h>
 #include <romstage_handoff.h>
+#include <sampling_profiler.h>
 
 #if ENV_RAMSTAGE || ENV_POSTCAR
 
@@ -79,6 +80,8 @@ void __noreturn acpi_resume(void *wake_vec)
 	/* Call mainboard resume handler first, if defined. */
 	mainboard_suspend_resume();
 
+	sampling_profiler_stop();
+
 	post_code(POST_OS_RESUME);
 	acpi_jump_to_wakeup(wake_vec);
 
@@ -7,6 +7,7 @@
 #include <console/streams.h>
 #include <cpu/x86/cr.h>
 #include <cpu/x86/lapic.h>
+#include <sampling_profiler.h>
 #include <stdint.h>
 #include <string.h>
 
@@ -377,6 +378,17 @@ void x86_exception(struct eregs *info);
 
 void x86_exception(struct eregs *info)
 {
+#if ENV_SAMPLING_PROFILER
+	if (info->vector == SAMPLING_PROFILER_VECTOR) {
+#if ENV_X86_64
+		sampling_profiler_tick(info->rip);
+#else
+		sampling_profiler_tick(info->eip);
+#endif
+		return;
+	}
+#endif
+
 #if CONFIG(GDB_STUB)
 	int signo;
 	memcpy(gdb_stub_registers, info, 8*sizeof(uint32_t));
@@ -581,6 +593,7 @@ struct intr_gate {
 extern u8 vec0[], vec1[], vec2[], vec3[], vec4[], vec5[], vec6[], vec7[];
 extern u8 vec8[], vec9[], vec10[], vec11[], vec12[], vec13[], vec14[], vec15[];
 extern u8 vec16[], vec17[], vec18[], vec19[];
+extern u8 vec_profiler[];
 
 static const uintptr_t intr_entries[] = {
 	(uintptr_t)vec0, (uintptr_t)vec1, (uintptr_t)vec2, (uintptr_t)vec3,
@@ -588,6 +601,9 @@ static const uintptr_t intr_entries[] = {
 	(uintptr_t)vec8, (uintptr_t)vec9, (uintptr_t)vec10, (uintptr_t)vec11,
 	(uintptr_t)vec12, (uintptr_t)vec13, (uintptr_t)vec14, (uintptr_t)vec15,
 	(uintptr_t)vec16, (uintptr_t)vec17, (uintptr_t)vec18, (uintptr_t)vec19,
+#if ENV_SAMPLING_PROFILER
+	[SAMPLING_PROFILER_VECTOR] = (uintptr_t)vec_profiler,
+#endif
 };
 
 static struct intr_gate idt[ARRAY_SIZE(intr_entries)] __aligned(8);
@@ -646,6 +662,9 @@ asmlinkage void exception_init(void)
 
 	/* Initialize IDT. */
 	for (i = 0; i < ARRAY_SIZE(idt); i++) {
+		/* Unused vectors are left not present. */
+		if (!intr_entries[i])
+			continue;
 		idt[i].offset_0 = intr_entries[i];
 		idt[i].segsel = segment;
 		idt[i].flags = IGATE_FLAGS;
@@ -35,7 +35,9 @@
 #define CBMEM_ID_NONE		0x00000000
 #define CBMEM_ID_PIRQ		0x49525154
 #define CBMEM_ID_POWER_STATE	0x50535454
+#define CBMEM_ID_PROFILE	0x50524f46
 #define CBMEM_ID_RAM_OOPS	0x05430095
+#define CBMEM_ID_RAMDETECT	0x52414d44
 #define CBMEM_ID_RAMSTAGE	0x9a357a9e
 #define CBMEM_ID_RAMSTAGE_CACHE	0x9a3ca54e
 #define CBMEM_ID_REFCODE	0x04efc0de
@@ -55,10 +57,13 @@
 #define CBMEM_ID_TCPA_TCG_LOG	0x54445041
 #define CBMEM_ID_TIMESTAMP	0x54494d45
 #define CBMEM_ID_TPM2_TCG_LOG	0x54504d32
+#define CBMEM_ID_TRACE		0x42545243
 #define CBMEM_ID_VBOOT_HANDOFF	0x780074f0  /* deprecated */
 #define CBMEM_ID_VBOOT_SEL_REG	0x780074f1  /* deprecated */
 #define CBMEM_ID_VBOOT_WORKBUF	0x78007343
 #define CBMEM_ID_VPD		0x56504420
+#define CBMEM_ID_VPD_INDEX	0x56504449
+#define CBMEM_ID_WARM_CACHE	0x5741524d
 #define CBMEM_ID_WIFI_CALIBRATION 0x57494649
 #define CBMEM_ID_EC_HOSTEVENT	0x63ccbbc3  /* deprecated */
 #define CBMEM_ID_EXT_VBT	0x69866684
@@ -100,7 +105,9 @@
 	{ CBMEM_ID_MTC,			"MTC        " }, \
 	{ CBMEM_ID_PIRQ,		"IRQ TABLE  " }, \
 	{ CBMEM_ID_POWER_STATE,		"POWER STATE" }, \
+	{ CBMEM_ID_PROFILE,		"PROFILE    " }, \
 	{ CBMEM_ID_RAM_OOPS,		"RAMOOPS    " }, \
+	{ CBMEM_ID_RAMDETECT,		"RAMDETECT  " }, \
 	{ CBMEM_ID_RAMSTAGE_CACHE,	"RAMSTAGE $ " }, \
 	{ CBMEM_ID_RAMSTAGE,		"RAMSTAGE   " }, \
 	{ CBMEM_ID_REFCODE_CACHE,	"REFCODE $  " }, \
@@ -117,10 +124,13 @@
 	{ CBMEM_ID_TCPA_TCG_LOG,	"TCPA TCGLOG" }, \
 	{ CBMEM_ID_TIMESTAMP,		"TIME STAMP " }, \
 	{ CBMEM_ID_TPM2_TCG_LOG,	"TPM2 TCGLOG" }, \
+	{ CBMEM_ID_TRACE,		"FUNC TRACE " }, \
 	{ CBMEM_ID_VBOOT_HANDOFF,	"VBOOT      " }, \
 	{ CBMEM_ID_VBOOT_SEL_REG,	"VBOOT SEL  " }, \
 	{ CBMEM_ID_VBOOT_WORKBUF,	"VBOOT WORK " }, \
 	{ CBMEM_ID_VPD,			"VPD        " }, \
+	{ CBMEM_ID_VPD_INDEX,		"VPD INDEX  " }, \
+	{ CBMEM_ID_WARM_CACHE,		"WARM CACHE " }, \
 	{ CBMEM_ID_WIFI_CALIBRATION,	"WIFI CLBR  " }, \
 	{ CBMEM_ID_EC_HOSTEVENT,	"EC HOSTEVENT"}, \
 	{ CBMEM_ID_EXT_VBT,		"EXT VBT"}, \
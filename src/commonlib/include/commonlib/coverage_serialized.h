@@ -0,0 +1,71 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef __COVERAGE_SERIALIZED_H__
+#define __COVERAGE_SERIALIZED_H__
+
+#include <stdint.h>
+
+#define COVERAGE_STREAM_MAGIC	0x53564f43	/* "COVS" */
+#define COVERAGE_STREAM_VERSION	2
+
+/* Number of gcov counter types, GCOV_COUNTERS in gcov-io.h. */
+#define COVERAGE_COUNTER_TYPES	8
+
+/* Set in coverage_function.flags when the function has counters. */
+#define COVERAGE_FUNCTION_PRESENT	(1 << 0)
+
+/*
+ * CBMEM_ID_COVERAGE layout when CONFIG_COVERAGE_STREAM is enabled: this
+ * header followed by `used` bytes of records, one per instrumented object
+ * file. Every field is a 32-bit little endian word, so the stream can be
+ * turned into .gcda files on the host without any knowledge of the firmware
+ * word size. Summaries and merging with earlier runs are left to the host.
+ * The stream is emptied on every boot, including S3 resume, and gets a new
+ * boot_id, so that the host can tell whether it already merged a stream.
+ */
+struct coverage_stream {
+	uint32_t	magic;
+	uint32_t	version;
+	/* GCOV_VERSION of the compiler that instrumented the firmware. */
+	uint32_t	gcov_version;
+	/* Changes on every boot that writes the stream. */
+	uint32_t	boot_id;
+	/* Bytes available for records. */
+	uint32_t	size;
+	/* Bytes of records written. */
+	uint32_t	used;
+	/* Object files that did not fit. */
+	uint32_t	dropped;
+	uint32_t	records[0];
+} __packed;
+
+/*
+ * One object file: this header, the NUL terminated .gcda path padded to a
+ * multiple of 4 bytes, then n_functions struct coverage_function. A present
+ * function is followed by one counter array for each bit set in
+ * counter_mask, in counter type order: a word with the number of counters,
+ * then the counters as pairs of words, low word first.
+ */
+struct coverage_object {
+	/* Size of the whole record in bytes. */
+	uint32_t	length;
+	uint32_t	stamp;
+	uint32_t	n_functions;
+	uint32_t	counter_mask;
+	/* Size of the padded path in bytes. */
+	uint32_t	filename_size;
+} __packed;
+
+struct coverage_function {
+	uint32_t	ident;
+	uint32_t	lineno_checksum;
+	uint32_t	cfg_checksum;
+	uint32_t	flags;
+} __packed;
+
+static inline uint32_t coverage_filename_size(uint32_t len)
+{
+	return (len + 1 + 3) & ~3;
+}
+
+#endif
@@ -0,0 +1,53 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef __PROFILE_SERIALIZED_H__
+#define __PROFILE_SERIALIZED_H__
+
+#include <stdint.h>
+
+#define PROFILE_BUFFER_MAGIC	0x464f5250	/* "PROF" */
+#define PROFILE_BUFFER_VERSION	1
+
+enum profile_stage {
+	PROFILE_STAGE_ROMSTAGE,
+	PROFILE_STAGE_POSTCAR,
+	PROFILE_STAGE_RAMSTAGE,
+	PROFILE_STAGE_COUNT,
+};
+
+/* One histogram bucket. A bucket with count 0 is free. */
+struct profile_entry {
+	uint64_t	ip;
+	uint32_t	count;
+	uint16_t	stage;
+	uint16_t	reserved;
+} __packed;
+
+/*
+ * CBMEM_ID_PROFILE layout: this header followed by capacity struct
+ * profile_entry, which form an open addressed hash table keyed by
+ * (ip, stage). stage_base holds the run time address of _program for each
+ * stage, so that samples can be matched against the stage ELF even when
+ * the stage was relocated.
+ */
+struct profile_buffer {
+	uint32_t	magic;
+	uint32_t	version;
+	uint32_t	capacity;
+	uint32_t	used;
+	uint32_t	rate_hz;
+	/* Samples lost because the table was full. */
+	uint32_t	dropped;
+	uint64_t	stage_base[PROFILE_STAGE_COUNT];
+	uint64_t	stage_samples[PROFILE_STAGE_COUNT];
+	struct profile_entry entries[0];
+} __packed;
+
+static inline uint32_t profile_hash(uint64_t ip, uint16_t stage)
+{
+	uint64_t h = (ip ^ ((uint64_t)stage << 56)) * 0x9e3779b97f4a7c15ULL;
+
+	return h >> 32;
+}
+
+#endif
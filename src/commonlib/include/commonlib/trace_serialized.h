@@ -0,0 +1,54 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef __TRACE_SERIALIZED_H__
+#define __TRACE_SERIALIZED_H__
+
+#include <stdint.h>
+
+#define TRACE_BUFFER_MAGIC	0x43525442	/* "BTRC" */
+#define TRACE_BUFFER_VERSION	1
+
+/* Set in trace_record.flags for function exits, clear for entries. */
+#define TRACE_RECORD_EXIT	(1 << 0)
+
+struct trace_record {
+	uint64_t	tsc;
+	uint64_t	func;
+	uint64_t	callsite;
+	uint32_t	flags;
+	uint32_t	cpu;
+} __packed;
+
+/*
+ * Each CPU only writes its own ring, so no locking is needed. Record n of a
+ * CPU is stored in slot n % records_per_cpu, so once count exceeds
+ * records_per_cpu the ring holds the newest records.
+ */
+struct trace_ring {
+	uint32_t	count;
+	/* Set while the CPU is recording, to ignore calls made by the tracer. */
+	uint32_t	busy;
+} __packed;
+
+/*
+ * CBMEM_ID_TRACE layout: this header, then num_cpus struct trace_ring, then
+ * records_per_cpu struct trace_record for each CPU in turn.
+ */
+struct trace_buffer {
+	uint32_t	magic;
+	uint32_t	version;
+	uint32_t	num_cpus;
+	uint32_t	records_per_cpu;
+	uint32_t	tick_freq_mhz;
+	uint32_t	reserved;
+	struct trace_ring rings[0];
+} __packed;
+
+static inline struct trace_record *trace_buffer_records(struct trace_buffer *buf,
+							unsigned int cpu)
+{
+	return (struct trace_record *)&buf->rings[buf->num_cpus] +
+		(uint64_t)cpu * buf->records_per_cpu;
+}
+
+#endif
@@ -6,7 +6,11 @@
 #include <types.h>
 
 void set_vmx_and_lock(void);
-void set_feature_ctrl_vmx(void);
+/*
+ * Returns < 0 if IA32_FEATURE_CONTROL was already locked with VMX set
+ * differently from ENABLE_VMX.
+ */
+int set_feature_ctrl_vmx(void);
 void set_feature_ctrl_lock(void);
 
 /*
@@ -12,7 +12,7 @@ void set_vmx_and_lock(void)
 	set_feature_ctrl_lock();
 }
 
-void set_feature_ctrl_vmx(void)
+int set_feature_ctrl_vmx(void)
 {
 	msr_t msr;
 	uint32_t feature_flag;
@@ -22,7 +22,7 @@ void set_feature_ctrl_vmx(void)
 	/* Check that the VMX is supported before reading or writing the MSR. */
 	if (!((feature_flag & CPUID_VMX) || (feature_flag & CPUID_SMX))) {
 		printk(BIOS_DEBUG, "CPU doesn't support VMX; exiting\n");
-		return;
+		return 0;
 	}
 
 	msr = rdmsr(IA32_FEATURE_CONTROL);
@@ -34,7 +34,12 @@ void set_feature_ctrl_vmx(void)
 		/* IA32_FEATURE_CONTROL locked. If we set it again we get an
 		 * illegal instruction
 		 */
-		return;
+		if (!!(msr.lo & (1 << 2)) != enable) {
+			printk(BIOS_ERR, "VMX can't be %s, IA32_FEATURE_CONTROL is locked\n",
+			       enable ? "enabled" : "disabled");
+			return -1;
+		}
+		return 0;
 	}
 
 	/* The IA32_FEATURE_CONTROL MSR may initialize with random values.
@@ -57,6 +62,8 @@ void set_feature_ctrl_vmx(void)
 
 	printk(BIOS_DEBUG, "VMX status: %s\n",
 		enable ? "enabled" : "disabled");
+
+	return 0;
 }
 void set_feature_ctrl_lock(void)
 {
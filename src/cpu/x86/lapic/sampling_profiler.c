@@ -0,0 +1,205 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <arch/exception.h>
+#include <arch/io.h>
+#include <cbmem.h>
+#include <commonlib/profile_serialized.h>
+#include <console/console.h>
+#include <cpu/x86/lapic.h>
+#include <delay.h>
+#include <pc80/i8259.h>
+#include <sampling_profiler.h>
+#include <stdbool.h>
+#include <string.h>
+#include <symbols.h>
+
+/*
+ * Statistical profiler. The local APIC timer of the BSP interrupts the stage
+ * CONFIG_SAMPLING_PROFILER_HZ times per second and the interrupted
+ * instruction pointer is counted in the CBMEM_ID_PROFILE histogram. Sampling
+ * starts once CBMEM is up and stops in prog_run(), so the histogram covers
+ * romstage after memory init, postcar and ramstage. `cbmem -P` prints it.
+ */
+
+#if ENV_ROMSTAGE
+#define PROFILE_STAGE	PROFILE_STAGE_ROMSTAGE
+#elif ENV_POSTCAR
+#define PROFILE_STAGE	PROFILE_STAGE_POSTCAR
+#else
+#define PROFILE_STAGE	PROFILE_STAGE_RAMSTAGE
+#endif
+
+/* Buckets probed before a sample is dropped. */
+#define PROFILE_MAX_PROBES	32
+#define CALIBRATION_US		1000
+
+static struct profile_buffer *profile;
+static uint32_t timer_initial_count;
+static int pause_depth;
+/* 8259 interrupt masks found when sampling started. */
+static uint8_t saved_pic_mask[2];
+
+static void timer_start(void)
+{
+	lapic_write(LAPIC_TDCR, LAPIC_TDR_DIV_1);
+	lapic_write(LAPIC_LVTT, LAPIC_LVT_TIMER_PERIODIC | SAMPLING_PROFILER_VECTOR);
+	lapic_write(LAPIC_TMICT, timer_initial_count);
+}
+
+static void timer_stop(void)
+{
+	lapic_write(LAPIC_LVTT, LAPIC_LVT_MASKED);
+	lapic_write(LAPIC_TMICT, 0);
+}
+
+/* Returns the number of timer ticks per sampling period. */
+static uint32_t timer_calibrate(void)
+{
+	uint32_t start, ticks;
+
+	lapic_write(LAPIC_LVTT, LAPIC_LVT_MASKED);
+	lapic_write(LAPIC_TDCR, LAPIC_TDR_DIV_1);
+	lapic_write(LAPIC_TMICT, 0xffffffff);
+	start = lapic_read(LAPIC_TMCCT);
+	udelay(CALIBRATION_US);
+	ticks = start - lapic_read(LAPIC_TMCCT);
+	lapic_write(LAPIC_TMICT, 0);
+
+	/* ticks is per millisecond, avoid 64-bit division. */
+	if (ticks > UINT32_MAX / 1000)
+		return ticks / CONFIG_SAMPLING_PROFILER_HZ * 1000;
+	return ticks * 1000 / CONFIG_SAMPLING_PROFILER_HZ;
+}
+
+void sampling_profiler_tick(uintptr_t ip)
+{
+	struct profile_buffer *buf = profile;
+	uint32_t i;
+	int n;
+
+	if (buf != NULL) {
+		i = profile_hash(ip, PROFILE_STAGE) % buf->capacity;
+		for (n = 0; n < PROFILE_MAX_PROBES; n++) {
+			struct profile_entry *e = &buf->entries[i];
+
+			if (e->count == 0) {
+				e->ip = ip;
+				e->stage = PROFILE_STAGE;
+				buf->used++;
+			}
+			if (e->ip == ip && e->stage == PROFILE_STAGE) {
+				e->count++;
+				buf->stage_samples[PROFILE_STAGE]++;
+				break;
+			}
+			if (++i == buf->capacity)
+				i = 0;
+		}
+		if (n == PROFILE_MAX_PROBES)
+			buf->dropped++;
+	}
+
+	lapic_write(LAPIC_EOI, 0);
+}
+
+static bool profile_valid(const struct profile_buffer *buf)
+{
+	return buf->magic == PROFILE_BUFFER_MAGIC && buf->version == PROFILE_BUFFER_VERSION &&
+	       buf->capacity == CONFIG_SAMPLING_PROFILER_ENTRIES &&
+	       buf->rate_hz == CONFIG_SAMPLING_PROFILER_HZ;
+}
+
+static void sampling_profiler_start(int is_recovery)
+{
+	const size_t size = sizeof(struct profile_buffer) +
+		CONFIG_SAMPLING_PROFILER_ENTRIES * sizeof(struct profile_entry);
+	struct profile_buffer *buf;
+
+	buf = cbmem_add(CBMEM_ID_PROFILE, size);
+	if (buf == NULL) {
+		printk(BIOS_ERR, "Sampling profiler: no room in CBMEM\n");
+		return;
+	}
+
+	/* Romstage starts a new profile, later stages add to it. */
+	if (ENV_ROMSTAGE || !profile_valid(buf)) {
+		memset(buf, 0, size);
+		buf->magic = PROFILE_BUFFER_MAGIC;
+		buf->version = PROFILE_BUFFER_VERSION;
+		buf->capacity = CONFIG_SAMPLING_PROFILER_ENTRIES;
+		buf->rate_hz = CONFIG_SAMPLING_PROFILER_HZ;
+	}
+	buf->stage_base[PROFILE_STAGE] = (uintptr_t)_program;
+
+	timer_initial_count = timer_calibrate();
+	if (timer_initial_count == 0) {
+		printk(BIOS_ERR, "Sampling profiler: LAPIC timer is not running\n");
+		return;
+	}
+
+	/* Only the timer may interrupt us. */
+	saved_pic_mask[0] = inb(MASTER_PIC_OCW1);
+	saved_pic_mask[1] = inb(SLAVE_PIC_OCW1);
+	outb(ALL_IRQS, SLAVE_PIC_OCW1);
+	outb(ALL_IRQS, MASTER_PIC_OCW1);
+
+	enable_lapic();
+	lapic_write(LAPIC_SPIV, lapic_read(LAPIC_SPIV) | LAPIC_SPIV_ENABLE);
+
+	/* Memory init may have replaced the IDT. */
+	exception_init();
+
+	printk(BIOS_DEBUG, "Sampling profiler: %d Hz, %u timer ticks\n",
+	       CONFIG_SAMPLING_PROFILER_HZ, timer_initial_count);
+
+	profile = buf;
+	pause_depth = 0;
+	timer_start();
+	asm volatile ("sti" ::: "memory");
+}
+
+ROMSTAGE_CBMEM_INIT_HOOK(sampling_profiler_start)
+POSTCAR_CBMEM_INIT_HOOK(sampling_profiler_start)
+RAMSTAGE_CBMEM_INIT_HOOK(sampling_profiler_start)
+
+void sampling_profiler_pause(void)
+{
+	if (profile == NULL || pause_depth++ > 0)
+		return;
+
+	asm volatile ("cli" ::: "memory");
+	timer_stop();
+}
+
+void sampling_profiler_resume(void)
+{
+	if (profile == NULL || --pause_depth > 0)
+		return;
+
+	/* The code that ran in between may have loaded its own IDT. */
+	exception_init();
+	timer_start();
+	asm volatile ("sti" ::: "memory");
+}
+
+void sampling_profiler_stop(void)
+{
+	struct profile_buffer *buf = profile;
+
+	if (buf == NULL)
+		return;
+
+	asm volatile ("cli" ::: "memory");
+	timer_stop();
+	profile = NULL;
+
+	/* Unless the 8259 was set up since, e.g. by setup_i8259(), unmask it again. */
+	if (inb(MASTER_PIC_OCW1) == ALL_IRQS && inb(SLAVE_PIC_OCW1) == ALL_IRQS) {
+		outb(saved_pic_mask[1], SLAVE_PIC_OCW1);
+		outb(saved_pic_mask[0], MASTER_PIC_OCW1);
+	}
+
+	printk(BIOS_DEBUG, "Sampling profiler: %llu samples, %u buckets used, %u dropped\n",
+	       (unsigned long long)buf->stage_samples[PROFILE_STAGE], buf->used,
+	       buf->dropped);
+}
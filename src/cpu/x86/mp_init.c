@@ -33,7 +33,6 @@
 struct mp_callback {
 	void (*func)(void *);
 	void *arg;
-	int logical_cpu_number;
 };
 
 static char processor_name[49];
@@ -870,34 +869,40 @@ static void trigger_smm_relocation(void)
 	mp_state.ops.per_cpu_smm_trigger();
 }
 
-static struct mp_callback *ap_callbacks[CONFIG_MAX_CPUS];
-
-static struct mp_callback *read_callback(struct mp_callback **slot)
+/*
+ * Each AP owns a mailbox: a small ring of callbacks that only the BSP posts to
+ * and only that AP consumes, so no locking is needed. The counters are
+ * sequence numbers that only ever increase. The BSP may queue up to
+ * MP_MAILBOX_SLOTS jobs ahead of an AP without waiting for it.
+ */
+#define MP_MAILBOX_SLOTS 8
+
+struct mp_mailbox {
+	struct mp_callback slots[MP_MAILBOX_SLOTS];
+	/* Number of jobs posted. Only written by the BSP. */
+	atomic_t posted;
+	/* Number of jobs taken out of the ring. Only written by the AP. */
+	atomic_t accepted;
+	/* Number of jobs that returned. Only written by the AP. */
+	atomic_t completed;
+} __aligned(CACHELINE_SIZE);	/* Keep the APs off each other's cache lines. */
+
+static struct mp_mailbox ap_mailboxes[CONFIG_MAX_CPUS];
+
+/* Sequence numbers wrap, so compare them by distance. */
+static inline int seq_reached(atomic_t *counter, uint32_t seq)
 {
-	struct mp_callback *ret;
-
-	asm volatile ("mov	%1, %0\n"
-		: "=r" (ret)
-		: "m" (*slot)
-		: "memory"
-	);
-	return ret;
+	return (int32_t)((uint32_t)atomic_read(counter) - seq) >= 0;
 }
 
-static void store_callback(struct mp_callback **slot, struct mp_callback *val)
+static inline int expired(struct stopwatch *sw, long expire_us)
 {
-	asm volatile ("mov	%1, %0\n"
-		: "=m" (*slot)
-		: "r" (val)
-		: "memory"
-	);
+	return expire_us > 0 && stopwatch_expired(sw);
 }
 
-static int run_ap_work(struct mp_callback *val, long expire_us)
+/* Returns the BSP CPU index, or < 0 if the caller may not post work. */
+static int mp_work_cpu(void)
 {
-	int i;
-	int cpus_accepted;
-	struct stopwatch sw;
 	int cur_cpu;
 
 	if (!CONFIG(PARALLEL_MP_AP_WORK)) {
@@ -912,41 +917,100 @@ static int run_ap_work(struct mp_callback *val, long expire_us)
 		return -1;
 	}
 
-	/* Signal to all the APs to run the func. */
-	for (i = 0; i < ARRAY_SIZE(ap_callbacks); i++) {
-		if (cur_cpu == i)
-			continue;
-		store_callback(&ap_callbacks[i], val);
+	return cur_cpu;
+}
+
+static int is_ap_target(int cpu, int cur_cpu)
+{
+	return cpu != cur_cpu && cpu <= global_num_aps && cpu < CONFIG_MAX_CPUS;
+}
+
+/* Queue a callback on the given AP. Returns its sequence number or < 0 on timeout. */
+static int post_callback(int cpu, const struct mp_callback *cb, struct stopwatch *sw,
+			 long expire_us)
+{
+	struct mp_mailbox *mb = &ap_mailboxes[cpu];
+	uint32_t seq = atomic_read(&mb->posted);
+
+	/* Wait for a free slot if the AP is still busy with earlier work. */
+	while (!seq_reached(&mb->accepted, seq - MP_MAILBOX_SLOTS + 1)) {
+		if (expired(sw, expire_us))
+			return -1;
+		asm ("pause");
 	}
+
+	mb->slots[seq % MP_MAILBOX_SLOTS] = *cb;
+	/* Publish the slot contents before the new sequence number. */
 	mfence();
+	atomic_set(&mb->posted, seq + 1);
+
+	return (seq + 1) & INT32_MAX;
+}
+
+static int run_ap_work(const struct mp_callback *val, int logical_cpu_num, long expire_us)
+{
+	int i;
+	int cpus_accepted = 0;
+	int cpus_targeted = 0;
+	uint32_t seqs[CONFIG_MAX_CPUS];
+	struct stopwatch sw;
+	int cur_cpu;
+
+	cur_cpu = mp_work_cpu();
+	if (cur_cpu < 0)
+		return -1;
+
+	if (logical_cpu_num != MP_RUN_ON_ALL_CPUS && !is_ap_target(logical_cpu_num, cur_cpu)) {
+		printk(BIOS_ERR, "Invalid AP number %d.\n", logical_cpu_num);
+		return -1;
+	}
 
-	/* Wait for all the APs to signal back that call has been accepted. */
 	if (expire_us > 0)
 		stopwatch_init_usecs_expire(&sw, expire_us);
 
+	/* Post the func to the mailbox of every targeted AP. */
+	for (i = 0; i < CONFIG_MAX_CPUS; i++) {
+		int seq;
+
+		if (!is_ap_target(i, cur_cpu))
+			continue;
+		if (logical_cpu_num != MP_RUN_ON_ALL_CPUS && i != logical_cpu_num)
+			continue;
+
+		seq = post_callback(i, val, &sw, expire_us);
+		if (seq < 0)
+			goto expired;
+		seqs[i] = seq;
+		cpus_targeted++;
+	}
+
+	/* Wait for the APs to signal back that the call has been accepted. */
 	do {
 		cpus_accepted = 0;
 
-		for (i = 0; i < ARRAY_SIZE(ap_callbacks); i++) {
-			if (cur_cpu == i)
+		for (i = 0; i < CONFIG_MAX_CPUS; i++) {
+			if (!is_ap_target(i, cur_cpu))
+				continue;
+			if (logical_cpu_num != MP_RUN_ON_ALL_CPUS && i != logical_cpu_num)
 				continue;
-			if (read_callback(&ap_callbacks[i]) == NULL)
+			if (seq_reached(&ap_mailboxes[i].accepted, seqs[i]))
 				cpus_accepted++;
 		}
 
-		if (cpus_accepted == global_num_aps)
+		if (cpus_accepted == cpus_targeted)
 			return 0;
-	} while (expire_us <= 0 || !stopwatch_expired(&sw));
+	} while (!expired(&sw, expire_us));
 
+expired:
 	printk(BIOS_CRIT, "CRITICAL ERROR: AP call expired. %d/%d CPUs accepted.\n",
-		cpus_accepted, global_num_aps);
+		cpus_accepted, cpus_targeted);
 	return -1;
 }
 
 static void ap_wait_for_instruction(void)
 {
 	struct mp_callback lcb;
-	struct mp_callback **per_cpu_slot;
+	struct mp_mailbox *mb;
 	int cur_cpu;
 
 	if (!CONFIG(PARALLEL_MP_AP_WORK))
@@ -959,34 +1023,99 @@ static void ap_wait_for_instruction(void)
 		return;
 	}
 
-	per_cpu_slot = &ap_callbacks[cur_cpu];
+	mb = &ap_mailboxes[cur_cpu];
 
 	while (1) {
-		struct mp_callback *cb = read_callback(per_cpu_slot);
+		uint32_t seq = atomic_read(&mb->accepted);
 
-		if (cb == NULL) {
+		if ((uint32_t)atomic_read(&mb->posted) == seq) {
 			asm ("pause");
 			continue;
 		}
 
 		/* Copy to local variable before signaling consumption. */
-		memcpy(&lcb, cb, sizeof(lcb));
 		mfence();
-		store_callback(per_cpu_slot, NULL);
-		if (lcb.logical_cpu_number && (cur_cpu !=
-				lcb.logical_cpu_number))
-			continue;
-		else
-			lcb.func(lcb.arg);
+		memcpy(&lcb, &mb->slots[seq % MP_MAILBOX_SLOTS], sizeof(lcb));
+		mfence();
+		atomic_set(&mb->accepted, seq + 1);
+
+		lcb.func(lcb.arg);
+
+		mfence();
+		atomic_set(&mb->completed, seq + 1);
 	}
 }
 
 int mp_run_on_aps(void (*func)(void *), void *arg, int logical_cpu_num,
 		long expire_us)
 {
-	struct mp_callback lcb = { .func = func, .arg = arg,
-				.logical_cpu_number = logical_cpu_num};
-	return run_ap_work(&lcb, expire_us);
+	struct mp_callback lcb = { .func = func, .arg = arg };
+	return run_ap_work(&lcb, logical_cpu_num, expire_us);
+}
+
+int mp_post_work(int logical_cpu_num, void (*func)(void *), void *arg, long expire_us)
+{
+	struct mp_callback lcb = { .func = func, .arg = arg };
+	struct stopwatch sw;
+	int cur_cpu;
+	int seq;
+
+	cur_cpu = mp_work_cpu();
+	if (cur_cpu < 0)
+		return -1;
+
+	if (!is_ap_target(logical_cpu_num, cur_cpu)) {
+		printk(BIOS_ERR, "Invalid AP number %d.\n", logical_cpu_num);
+		return -1;
+	}
+
+	if (expire_us > 0)
+		stopwatch_init_usecs_expire(&sw, expire_us);
+
+	seq = post_callback(logical_cpu_num, &lcb, &sw, expire_us);
+	if (seq < 0)
+		printk(BIOS_ERR, "AP %d mailbox full.\n", logical_cpu_num);
+
+	return seq;
+}
+
+int mp_work_done(int logical_cpu_num, int seq)
+{
+	if (logical_cpu_num < 0 || logical_cpu_num >= CONFIG_MAX_CPUS)
+		return 0;
+
+	return seq_reached(&ap_mailboxes[logical_cpu_num].completed, seq);
+}
+
+int mp_wait_all(long expire_us)
+{
+	struct stopwatch sw;
+	int cur_cpu;
+	int i;
+
+	cur_cpu = mp_work_cpu();
+	if (cur_cpu < 0)
+		return -1;
+
+	if (expire_us > 0)
+		stopwatch_init_usecs_expire(&sw, expire_us);
+
+	for (i = 0; i < CONFIG_MAX_CPUS; i++) {
+		struct mp_mailbox *mb = &ap_mailboxes[i];
+
+		if (!is_ap_target(i, cur_cpu))
+			continue;
+
+		while (!seq_reached(&mb->completed, atomic_read(&mb->posted))) {
+			if (expired(&sw, expire_us)) {
+				printk(BIOS_ERR, "AP %d did not finish its work.\n", i);
+				return -1;
+			}
+			asm ("pause");
+		}
+	}
+
+	return 0;
 }
 
 int mp_run_on_all_cpus(void (*func)(void *), void *arg)
@@ -998,6 +1127,120 @@ int mp_run_on_all_cpus(void (*func)(void *), void *arg)
 	return mp_run_on_aps(func, arg, MP_RUN_ON_ALL_CPUS, 1000 * USECS_PER_MSEC);
 }
 
+struct mp_recipe {
+	const struct mp_init_step *steps;
+	size_t count;
+	long expire_us;
+	/* Number of CPUs running the recipe. */
+	atomic_t cpus;
+	/* Barrier arrivals of all CPUs, over all barriers of the recipe. */
+	atomic_t arrived;
+};
+
+/* Failed steps per CPU, collected by the BSP after the join. */
+static int recipe_failures[CONFIG_MAX_CPUS];
+
+/* Wait for all CPUs to reach barrier number n (from 1). Returns < 0 on timeout. */
+static int recipe_barrier(struct mp_recipe *recipe, int n)
+{
+	struct stopwatch sw;
+
+	if (recipe->expire_us > 0)
+		stopwatch_init_usecs_expire(&sw, recipe->expire_us);
+
+	mfence();
+	atomic_inc(&recipe->arrived);
+
+	while (atomic_read(&recipe->arrived) < n * atomic_read(&recipe->cpus)) {
+		if (expired(&sw, recipe->expire_us))
+			return -1;
+		asm ("pause");
+	}
+
+	mfence();
+	return 0;
+}
+
+static void run_recipe(void *arg)
+{
+	struct mp_recipe *recipe = arg;
+	int cpu = cpu_index();
+	int failures = 0;
+	int barriers = 0;
+
+	for (size_t i = 0; i < recipe->count; i++) {
+		const struct mp_init_step *step = &recipe->steps[i];
+
+		if (step->type == MP_INIT_STEP_CALL) {
+			if (step->func() < 0)
+				failures++;
+			continue;
+		}
+
+		/* The steps after the barrier may rely on the other CPUs, skip them. */
+		if (recipe_barrier(recipe, ++barriers) < 0) {
+			failures += recipe->count - i;
+			break;
+		}
+	}
+
+	if (cpu >= 0 && cpu < CONFIG_MAX_CPUS)
+		recipe_failures[cpu] = failures;
+}
+
+int mp_run_recipe(const struct mp_init_step *steps, size_t count,
+		  long expire_us)
+{
+	/* Static so that APs that miss the deadline do not read a stale stack. */
+	static struct mp_recipe recipe;
+	int cur_cpu;
+	int ret = 0;
+	int i;
+
+	recipe.steps = steps;
+	recipe.count = count;
+	recipe.expire_us = expire_us;
+	atomic_set(&recipe.cpus, 1);
+	atomic_set(&recipe.arrived, 0);
+	memset(recipe_failures, 0, sizeof(recipe_failures));
+
+	/* Like mp_run_on_all_cpus(), the BSP does its part even if the APs can't. */
+	cur_cpu = mp_work_cpu();
+	if (cur_cpu < 0) {
+		run_recipe(&recipe);
+		return -1;
+	}
+
+	for (i = 0; i < CONFIG_MAX_CPUS; i++) {
+		if (is_ap_target(i, cur_cpu))
+			atomic_inc(&recipe.cpus);
+	}
+	mfence();
+
+	for (i = 0; i < CONFIG_MAX_CPUS; i++) {
+		if (!is_ap_target(i, cur_cpu) || mp_post_work(i, run_recipe, &recipe,
+							      expire_us) >= 0)
+			continue;
+		/* This AP never reaches the barriers, don't wait for it. */
+		atomic_dec(&recipe.cpus);
+		ret = -1;
+	}
+
+	run_recipe(&recipe);
+
+	if (mp_wait_all(expire_us) < 0)
+		ret = -1;
+
+	for (i = 0; i < CONFIG_MAX_CPUS; i++) {
+		if (!recipe_failures[i])
+			continue;
+		printk(BIOS_ERR, "CPU %d: %d init step(s) failed.\n", i, recipe_failures[i]);
+		ret = -1;
+	}
+
+	return ret;
+}
+
 int mp_park_aps(void)
 {
 	struct stopwatch sw;
@@ -3,6 +3,7 @@
 #include <console/console.h>
 #include <device/device.h>
 #include <device/pci.h>
+#include <device/pci_ops.h>
 #include <device/azalia_device.h>
 #include <device/mmio.h>
 #include <delay.h>
@@ -156,6 +157,194 @@ static int wait_for_valid(u8 *base)
 	return -1;
 }
 
+/*
+ * Command Outbound Ring Buffer (CORB) and Response Inbound Ring Buffer (RIRB)
+ * of 256 entries each. The controller fetches verbs from the CORB and sends
+ * one in every link frame, and writes the responses to the RIRB, so a whole
+ * verb table is submitted at once and the responses are checked in bulk.
+ */
+#define HDA_RING_ENTRIES	256
+/* Verbs queued at once; the RIRB has to hold all responses. */
+#define HDA_RING_BATCH		(HDA_RING_ENTRIES - 1)
+/* Per verb, as for the immediate command interface */
+#define HDA_RING_TIMEOUT_US	50
+
+static volatile u32 corb[HDA_RING_ENTRIES] __aligned(128);
+static volatile u64 rirb[HDA_RING_ENTRIES] __aligned(128);
+static u8 corb_wp;
+static u8 rirb_rp;
+
+static int wait_for_bits8(u8 *port, u8 mask, u8 val)
+{
+	int timeout = 1000;
+
+	while ((read8(port) & mask) != val) {
+		if (!timeout--)
+			return -1;
+		udelay(1);
+	}
+	return 0;
+}
+
+static int wait_for_bits16(u8 *port, u16 mask, u16 val)
+{
+	int timeout = 1000;
+
+	while ((read16(port) & mask) != val) {
+		if (!timeout--)
+			return -1;
+		udelay(1);
+	}
+	return 0;
+}
+
+static int ring_stop(u8 *base)
+{
+	write8(base + HDA_CORBCTL_REG, 0);
+	write8(base + HDA_RIRBCTL_REG, 0);
+
+	if (wait_for_bits8(base + HDA_CORBCTL_REG, HDA_CORBCTL_RUN, 0) ||
+	    wait_for_bits8(base + HDA_RIRBCTL_REG, HDA_RIRBCTL_RUN, 0))
+		return -1;
+	return 0;
+}
+
+static int ring_set_size(u8 *port)
+{
+	u8 reg8 = read8(port);
+
+	if (!(reg8 & HDA_RINGSIZE_CAP_256))
+		return -1;
+
+	write8(port, (reg8 & ~HDA_RINGSIZE_MASK) | HDA_RINGSIZE_256);
+	return 0;
+}
+
+static int ring_start(u8 *base)
+{
+	if (ring_stop(base))
+		return -1;
+
+	if (ring_set_size(base + HDA_CORBSIZE_REG) ||
+	    ring_set_size(base + HDA_RIRBSIZE_REG))
+		return -1;
+
+	write32(base + HDA_CORBLBASE_REG, (uintptr_t)corb);
+	write32(base + HDA_CORBUBASE_REG, (u64)(uintptr_t)corb >> 32);
+	write32(base + HDA_RIRBLBASE_REG, (uintptr_t)rirb);
+	write32(base + HDA_RIRBUBASE_REG, (u64)(uintptr_t)rirb >> 32);
+
+	/* Not every controller reads the reset bit back as set. */
+	write16(base + HDA_CORBRP_REG, HDA_CORBRP_RST);
+	wait_for_bits16(base + HDA_CORBRP_REG, HDA_CORBRP_RST, HDA_CORBRP_RST);
+	write16(base + HDA_CORBRP_REG, 0);
+	if (wait_for_bits16(base + HDA_CORBRP_REG, HDA_CORBRP_RST, 0))
+		return -1;
+
+	corb_wp = 0;
+	write16(base + HDA_CORBWP_REG, corb_wp);
+	rirb_rp = 0;
+	write16(base + HDA_RIRBWP_REG, HDA_RIRBWP_RST);
+	write16(base + HDA_RINTCNT_REG, HDA_RING_BATCH);
+	write8(base + HDA_RIRBSTS_REG, HDA_RIRBSTS_RINTFL | HDA_RIRBSTS_RIRBOIS);
+
+	write8(base + HDA_RIRBCTL_REG, HDA_RIRBCTL_RUN);
+	write8(base + HDA_CORBCTL_REG, HDA_CORBCTL_RUN);
+	if (wait_for_bits8(base + HDA_CORBCTL_REG, HDA_CORBCTL_RUN,
+			   HDA_CORBCTL_RUN) ||
+	    wait_for_bits8(base + HDA_RIRBCTL_REG, HDA_RIRBCTL_RUN,
+			   HDA_RIRBCTL_RUN))
+		return -1;
+
+	return 0;
+}
+
+/*
+ * Queue up to HDA_RING_BATCH verbs and wait for all of their responses.
+ * Unsolicited responses, which the verbs may have just enabled, are skipped.
+ * Returns the number of verbs answered, in order, which is less than 'count'
+ * on failure.
+ */
+static u32 ring_send_batch(u8 *base, int addr, const u32 *verb, u32 count)
+{
+	u32 timeout = count * HDA_RING_TIMEOUT_US;
+	u32 received = 0;
+	u32 resp_ex;
+	u8 rirb_wp;
+	u32 i;
+
+	for (i = 0; i < count; i++)
+		corb[++corb_wp] = verb[i];
+	write16(base + HDA_CORBWP_REG, corb_wp);
+
+	while (received < count) {
+		rirb_wp = read16(base + HDA_RIRBWP_REG);
+		while (rirb_rp != rirb_wp) {
+			resp_ex = rirb[++rirb_rp] >> 32;
+			if (resp_ex & HDA_RIRB_EX_UNSOL)
+				continue;
+			if ((resp_ex & HDA_RIRB_EX_CODEC_MASK) != addr) {
+				printk(BIOS_DEBUG, "  response from codec #%d.\n",
+				       resp_ex & HDA_RIRB_EX_CODEC_MASK);
+				return received;
+			}
+			received++;
+		}
+
+		if (received < count) {
+			if (!timeout--)
+				return received;
+			udelay(1);
+		}
+	}
+
+	write8(base + HDA_RIRBSTS_REG, HDA_RIRBSTS_RINTFL | HDA_RIRBSTS_RIRBOIS);
+	return count;
+}
+
+/*
+ * Returns the number of verbs from the start of the table that went out on the
+ * link. The rest is left to the immediate command interface.
+ */
+static u32 ring_send_verbs(u8 *base, int addr, const u32 *verb, u32 verb_size)
+{
+	u32 count, sent, fetched;
+	u32 done = 0;
+	u8 start;
+
+	if (ring_start(base)) {
+		printk(BIOS_DEBUG, "  CORB/RIRB not available.\n");
+		ring_stop(base);
+		return 0;
+	}
+
+	do {
+		start = corb_wp;
+		count = MIN(verb_size - done, HDA_RING_BATCH);
+		sent = ring_send_batch(base, addr, verb + done, count);
+		if (sent < count)
+			break;
+		done += sent;
+	} while (done < verb_size);
+
+	/* The immediate command interface only works with the rings stopped. */
+	if (ring_stop(base))
+		printk(BIOS_DEBUG, "  CORB/RIRB still running.\n");
+
+	if (sent < count) {
+		/*
+		 * Verbs the controller fetched were sent to the codec even if
+		 * their responses are missing, don't send them again. Stopping
+		 * the DMA engine leaves the CORB read pointer as it was.
+		 */
+		fetched = (u8)(read16(base + HDA_CORBRP_REG) - start);
+		done += MIN(MAX(sent, fetched), count);
+		printk(BIOS_DEBUG, "  CORB/RIRB timeout after %u verbs.\n", done);
+	}
+
+	return done;
+}
+
 static void codec_init(struct device *dev, u8 *base, int addr)
 {
 	u32 reg32;
@@ -191,7 +380,11 @@ static void codec_init(struct device *dev, u8 *base, int addr)
 	printk(BIOS_DEBUG, "azalia_audio: verb_size: %d\n", verb_size);
 
 	/* 3 */
-	for (i = 0; i < verb_size; i++) {
+	i = 0;
+	if (CONFIG(AZALIA_CORB_RIRB))
+		i = ring_send_verbs(base, addr, verb, verb_size);
+
+	for (; i < verb_size; i++) {
 		if (wait_for_ready(base) == -1)
 			return;
 
@@ -218,6 +411,7 @@ void azalia_audio_init(struct device *dev)
 	u8 *base;
 	struct resource *res;
 	u32 codec_mask;
+	u16 command = 0;
 
 	res = find_resource(dev, PCI_BASE_ADDRESS_0);
 	if (!res)
@@ -231,7 +425,18 @@ void azalia_audio_init(struct device *dev)
 
 	if (codec_mask) {
 		printk(BIOS_DEBUG, "azalia_audio: codec_mask = %02x\n", codec_mask);
+
+		/* The CORB/RIRB rings are read and written by DMA. */
+		if (CONFIG(AZALIA_CORB_RIRB)) {
+			command = pci_read_config16(dev, PCI_COMMAND);
+			pci_write_config16(dev, PCI_COMMAND,
+					   command | PCI_COMMAND_MASTER);
+		}
+
 		codecs_init(dev, base, codec_mask);
+
+		if (CONFIG(AZALIA_CORB_RIRB))
+			pci_write_config16(dev, PCI_COMMAND, command);
 	}
 }
 
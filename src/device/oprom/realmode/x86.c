@@ -10,6 +10,8 @@
 #include <device/pci_ids.h>
 #include <pc80/i8259.h>
 #include <pc80/i8254.h>
+#include <sampling_profiler.h>
+#include <security/tpm/tspi.h>
 #include <string.h>
 #include <vbe.h>
 
@@ -227,8 +229,11 @@ static void vbe_get_ctrl_info(vbe_info_block *info)
 	char *buffer = PTR_TO_REAL_MODE(__realmode_buffer);
 	u16 buffer_seg = (((unsigned long)buffer) >> 4) & 0xff00;
 	u16 buffer_adr = ((unsigned long)buffer) & 0xffff;
+	tpm_flush_pcr_extends();
+	sampling_profiler_pause();
 	X86_EAX = realmode_interrupt(0x10, VESA_GET_INFO, 0x0000, 0x0000,
 			0x0000, buffer_seg, buffer_adr);
+	sampling_profiler_resume();
 	/* If the VBE function completed successfully, 0x0 is returned in AH */
 	if (X86_AH)
 		die("\nError: In %s function\n", __func__);
@@ -306,8 +311,11 @@ static u8 vbe_get_mode_info(vbe_mode_info_t * mi)
 	char *buffer = PTR_TO_REAL_MODE(__realmode_buffer);
 	u16 buffer_seg = (((unsigned long)buffer) >> 4) & 0xff00;
 	u16 buffer_adr = ((unsigned long)buffer) & 0xffff;
+	tpm_flush_pcr_extends();
+	sampling_profiler_pause();
 	X86_EAX = realmode_interrupt(0x10, VESA_GET_MODE_INFO, 0x0000,
 			mi->video_mode, 0x0000, buffer_seg, buffer_adr);
+	sampling_profiler_resume();
 	if (vbe_check_for_failure(X86_AH))
 		die("\nError: In %s function\n", __func__);
 	memcpy(mi->mode_info_block, buffer, sizeof(mi->mode_info_block));
@@ -322,8 +330,11 @@ static u8 vbe_set_mode(vbe_mode_info_t * mi)
 	mi->video_mode |= (1 << 14);
 	// request clearing of framebuffer
 	mi->video_mode &= ~(1 << 15);
+	tpm_flush_pcr_extends();
+	sampling_profiler_pause();
 	X86_EAX = realmode_interrupt(0x10, VESA_SET_MODE, mi->video_mode,
 			0x0000, 0x0000, 0x0000, 0x0000);
+	sampling_profiler_resume();
 	if (vbe_check_for_failure(X86_AH))
 		die("\nError: In %s function\n", __func__);
 	return 0;
@@ -356,8 +367,11 @@ void vbe_set_graphics(void)
 void vbe_textmode_console(void)
 {
 	delay(2);
+	tpm_flush_pcr_extends();
+	sampling_profiler_pause();
 	X86_EAX = realmode_interrupt(0x10, 0x0003, 0x0000, 0x0000,
 				0x0000, 0x0000, 0x0000);
+	sampling_profiler_resume();
 	if (vbe_check_for_failure(X86_AH))
 		die("\nError: In %s function\n", __func__);
 }
@@ -418,7 +432,10 @@ void run_bios(struct device *dev, unsigned long addr)
 	printk(BIOS_DEBUG, "Calling Option ROM...\n");
 	/* TODO ES:DI Pointer to System BIOS PnP Installation Check Structure */
 	/* Option ROM entry point is at OPROM start + 3 */
+	tpm_flush_pcr_extends();
+	sampling_profiler_pause();
 	realmode_call(addr + 0x0003, num_dev, 0xffff, 0x0000, 0xffff, 0x0, 0x0);
+	sampling_profiler_resume();
 	printk(BIOS_DEBUG, "... Option ROM returned.\n");
 
 #if CONFIG(FRAMEBUFFER_SET_VESA_MODE)
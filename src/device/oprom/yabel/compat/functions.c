@@ -37,6 +37,7 @@
 
 #include <types.h>
 #include <device/device.h>
+#include <security/tpm/tspi.h>
 #include "../debug.h"
 #include "../biosemu.h"
 #include <vbe.h>
@@ -60,6 +61,7 @@ void run_bios(struct device * dev, unsigned long addr)
 {
 	biosmem = vmem;
 
+	tpm_flush_pcr_extends();
 	biosemu(vmem, VMEM_SIZE, dev, addr);
 
 #if CONFIG(FRAMEBUFFER_SET_VESA_MODE)
@@ -5,6 +5,8 @@
 #include <acpi/acpi.h>
 #include <bootstate.h>
 #include <cbfs.h>
+#include <sampling_profiler.h>
+#include <security/tpm/tspi.h>
 #include <timestamp.h>
 
 #include <northbridge/amd/agesa/state_machine.h>
@@ -62,6 +64,7 @@ AGESA_STATUS module_dispatch(AGESA_STRUCT_NAME func,
 	AMD_CONFIG_PARAMS *StdHeader)
 {
 	MODULE_ENTRY dispatcher;
+	AGESA_STATUS status;
 
 #if CONFIG(CPU_AMD_AGESA_OPENSOURCE)
 	dispatcher = AmdAgesaDispatcher;
@@ -73,7 +76,12 @@ AGESA_STATUS module_dispatch(AGESA_STRUCT_NAME func,
 #endif
 
 	StdHeader->Func = func;
-	return dispatcher(StdHeader);
+	tpm_flush_pcr_extends();
+	sampling_profiler_pause();
+	status = dispatcher(StdHeader);
+	sampling_profiler_resume();
+
+	return status;
 }
 
 static AGESA_STATUS amd_create_struct(AMD_INTERFACE_PARAMS *aip,
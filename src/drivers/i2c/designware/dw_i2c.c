@@ -68,6 +68,13 @@ enum {
 	STATUS_SLAVE_ACTIVITY		= (1 << 6),
 };
 
+/* Component parameter 1 register definitions */
+enum {
+	COMP_PARAM1_RX_DEPTH_SHIFT	= 8,
+	COMP_PARAM1_TX_DEPTH_SHIFT	= 16,
+	COMP_PARAM1_DEPTH_MASK		= 0xff,
+};
+
 /* Enable register definitions */
 enum {
 	ENABLE_CONTROLLER		= (1 << 0),
@@ -307,42 +314,127 @@ static int dw_i2c_wait_for_bus_idle(struct dw_i2c_regs *regs)
 	return -1;
 }
 
-/* Transfer one byte of one segment, sending stop bit if requested */
-static int dw_i2c_transfer_byte(struct dw_i2c_regs *regs,
-				  const struct i2c_msg *segment,
-				  size_t byte, int send_stop)
+/*
+ * Usable depth of the FIFOs, from the smaller of the TX and RX FIFO. The
+ * controller only reports it with IC_ADD_ENCODED_PARAMS, without that the
+ * driver moves one byte at a time.
+ */
+static unsigned int dw_i2c_fifo_depth(struct dw_i2c_regs *regs)
+{
+	uint32_t param = read32(&regs->comp_param1);
+	unsigned int tx_depth, rx_depth;
+
+	if (!param)
+		return 1;
+
+	tx_depth = ((param >> COMP_PARAM1_TX_DEPTH_SHIFT) &
+		    COMP_PARAM1_DEPTH_MASK) + 1;
+	rx_depth = ((param >> COMP_PARAM1_RX_DEPTH_SHIFT) &
+		    COMP_PARAM1_DEPTH_MASK) + 1;
+	return MIN(tx_depth, rx_depth);
+}
+
+/* Wait for one of the raw interrupt bits in mask, fail if the transfer aborts */
+static int dw_i2c_wait_for_intr(struct dw_i2c_regs *regs, uint32_t mask,
+				const char *what)
 {
 	struct stopwatch sw;
-	uint32_t cmd = CMD_DATA_CMD; /* Read op */
+	uint32_t stat;
 
 	stopwatch_init_usecs_expire(&sw, DW_I2C_TIMEOUT_US);
+	while (1) {
+		stat = read32(&regs->raw_intr_stat);
+		if (stat & INTR_STAT_TX_ABORT) {
+			printk(BIOS_ERR, "I2C %s aborted, source 0x%x\n", what,
+			       read32(&regs->tx_abort_source));
+			return -1;
+		}
+		if (stat & mask)
+			return 0;
+		if (stopwatch_expired(&sw)) {
+			printk(BIOS_ERR, "I2C %s timeout\n", what);
+			return -1;
+		}
+	}
+}
 
-	if (!(segment->flags & I2C_M_RD)) {
-		/* Write op only: Wait for FIFO not full */
-		while (!(read32(&regs->status) & STATUS_TX_FIFO_NOT_FULL)) {
-			if (stopwatch_expired(&sw)) {
-				printk(BIOS_ERR, "I2C transmit timeout\n");
-				return -1;
-			}
+/*
+ * Write one segment, sending stop bit after the last byte if requested.
+ * The TX FIFO is refilled whenever it is down to the TX threshold.
+ */
+static int dw_i2c_write_segment(struct dw_i2c_regs *regs, unsigned int depth,
+				const struct i2c_msg *segment, int send_stop)
+{
+	unsigned int room;
+	size_t byte = 0;
+	uint32_t cmd;
+
+	while (byte < segment->len) {
+		if (dw_i2c_wait_for_intr(regs, INTR_STAT_TX_EMPTY, "transmit"))
+			return -1;
+
+		room = depth - read32(&regs->tx_level);
+		for (; room && byte < segment->len; room--, byte++) {
+			cmd = segment->buf[byte];
+			if (send_stop && byte == segment->len - 1)
+				cmd |= CMD_DATA_STOP;
+			write32(&regs->cmd_data, cmd);
 		}
-		cmd = segment->buf[byte];
 	}
 
-	/* Send stop on last byte, if desired */
-	if (send_stop && byte == segment->len - 1)
-		cmd |= CMD_DATA_STOP;
+	return 0;
+}
 
-	write32(&regs->cmd_data, cmd);
+/*
+ * Read one segment, sending stop bit after the last byte if requested.
+ * Read commands are queued as long as the RX FIFO can hold all their data.
+ * The RX threshold is set to half of the outstanding bytes, so the TX FIFO
+ * gets refilled before the controller runs out of commands, and everything
+ * received by then is drained at once.
+ */
+static int dw_i2c_read_segment(struct dw_i2c_regs *regs, unsigned int depth,
+			       const struct i2c_msg *segment, int send_stop)
+{
+	/* Bytes of a previous write segment may still be in the TX FIFO. */
+	unsigned int queued = read32(&regs->tx_level);
+	unsigned int thresh = ~0;
+	unsigned int outstanding;
+	unsigned int level;
+	size_t issued = 0;
+	size_t received = 0;
+	uint32_t cmd;
+
+	while (received < segment->len) {
+		outstanding = issued - received;
+		for (; outstanding + queued < depth && issued < segment->len;
+		     outstanding++, issued++) {
+			cmd = CMD_DATA_CMD;
+			if (send_stop && issued == segment->len - 1)
+				cmd |= CMD_DATA_STOP;
+			write32(&regs->cmd_data, cmd);
+		}
+		queued = 0;
 
-	if (segment->flags & I2C_M_RD) {
-		/* Read op only: Wait for FIFO data and store it */
-		while (!(read32(&regs->status) & STATUS_RX_FIFO_NOT_EMPTY)) {
-			if (stopwatch_expired(&sw)) {
-				printk(BIOS_ERR, "I2C receive timeout\n");
+		/* TX FIFO still full of write data, wait for room */
+		if (!outstanding) {
+			if (dw_i2c_wait_for_intr(regs, INTR_STAT_TX_EMPTY,
+						 "transmit"))
 				return -1;
-			}
+			queued = read32(&regs->tx_level);
+			continue;
+		}
+
+		/* RX_FULL is set once rx_level is above rx_thresh. */
+		if (thresh != (outstanding + 1) / 2 - 1) {
+			thresh = (outstanding + 1) / 2 - 1;
+			write32(&regs->rx_thresh, thresh);
 		}
-		segment->buf[byte] = read32(&regs->cmd_data);
+		if (dw_i2c_wait_for_intr(regs, INTR_STAT_RX_FULL, "receive"))
+			return -1;
+
+		level = read32(&regs->rx_level);
+		for (; level && received < issued; level--, received++)
+			segment->buf[received] = read32(&regs->cmd_data);
 	}
 
 	return 0;
@@ -353,8 +445,9 @@ static int _dw_i2c_transfer(unsigned int bus, const struct i2c_msg *segments,
 {
 	struct stopwatch sw;
 	struct dw_i2c_regs *regs;
-	size_t byte;
+	unsigned int depth;
 	int ret = -1;
+	int err;
 
 	regs = (struct dw_i2c_regs *)dw_i2c_base_address(bus);
 	if (!regs) {
@@ -369,6 +462,13 @@ static int _dw_i2c_transfer(unsigned int bus, const struct i2c_msg *segments,
 	/* Set target slave address */
 	write32(&regs->target_addr, segments->slave);
 
+	/* Refill the TX FIFO once it is half empty */
+	depth = dw_i2c_fifo_depth(regs);
+	write32(&regs->tx_thresh, depth / 2);
+
+	/* Don't fail on an abort left over from before */
+	read32(&regs->clear_tx_abrt_intr);
+
 	dw_i2c_enable(regs);
 
 	/* Process each segment */
@@ -380,21 +480,23 @@ static int _dw_i2c_transfer(unsigned int bus, const struct i2c_msg *segments,
 			       segments->len);
 		}
 
-		/* Read or write each byte in segment */
-		for (byte = 0; byte < segments->len; byte++) {
-			/*
-			 * Set stop condition on final segment only.
-			 * Repeated start will be automatically generated
-			 * by the controller on R->W or W->R switch.
-			 */
-			if (dw_i2c_transfer_byte(regs, segments, byte,
-						   count == 0) < 0) {
-				printk(BIOS_ERR, "I2C %s failed: bus %u "
-				       "addr 0x%02x\n",
-				       (segments->flags & I2C_M_RD) ?
-				       "read" : "write", bus, segments->slave);
-				goto out;
-			}
+		/*
+		 * Set stop condition on final segment only.
+		 * Repeated start will be automatically generated
+		 * by the controller on R->W or W->R switch.
+		 */
+		if (segments->flags & I2C_M_RD)
+			err = dw_i2c_read_segment(regs, depth, segments,
+						  count == 0);
+		else
+			err = dw_i2c_write_segment(regs, depth, segments,
+						   count == 0);
+		if (err < 0) {
+			printk(BIOS_ERR, "I2C %s failed: bus %u "
+			       "addr 0x%02x\n",
+			       (segments->flags & I2C_M_RD) ?
+			       "read" : "write", bus, segments->slave);
+			goto out;
 		}
 
 		if (CONFIG(DRIVERS_I2C_DESIGNWARE_DEBUG)) {
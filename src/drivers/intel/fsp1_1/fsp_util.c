@@ -6,6 +6,8 @@
 #include <console/console.h>
 #include <console/streams.h>
 #include <fsp/util.h>
+#include <sampling_profiler.h>
+#include <security/tpm/tspi.h>
 #include <timestamp.h>
 
 /* Locate the FSP binary in the coreboot filesystem */
@@ -141,7 +143,10 @@ void fsp_notify(u32 phase)
 		post_code(POST_FSP_NOTIFY_BEFORE_ENUMERATE);
 	}
 
+	tpm_flush_pcr_extends();
+	sampling_profiler_pause();
 	status = notify_phase_proc(&notify_phase_params);
+	sampling_profiler_resume();
 
 	timestamp_add_now(phase == EnumInitPhaseReadyToBoot ?
 		TS_FSP_AFTER_FINALIZE : TS_FSP_AFTER_ENUMERATE);
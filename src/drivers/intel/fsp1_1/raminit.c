@@ -9,6 +9,7 @@
 #include <fsp/romstage.h>
 #include <fsp/util.h>
 #include <lib.h> /* hexdump */
+#include <security/tpm/tspi.h>
 #include <string.h>
 #include <timestamp.h>
 
@@ -108,6 +109,7 @@ void raminit(struct romstage_params *params)
 
 	timestamp_add_now(TS_FSP_MEMORY_INIT_START);
 	post_code(POST_FSP_MEMORY_INIT);
+	tpm_flush_pcr_extends();
 	status = fsp_memory_init(&fsp_memory_init_params);
 	mainboard_after_memory_init();
 	post_code(0x37);
@@ -6,6 +6,8 @@
 #include <fsp/ramstage.h>
 #include <fsp/util.h>
 #include <lib.h>
+#include <sampling_profiler.h>
+#include <security/tpm/tspi.h>
 #include <stage_cache.h>
 #include <string.h>
 #include <timestamp.h>
@@ -100,7 +102,10 @@ void fsp_run_silicon_init(FSP_INFO_HEADER *fsp_info_header, int is_s3_wakeup)
 	printk(BIOS_DEBUG, "Calling FspSiliconInit(%p) at %p\n",
 		&silicon_init_params, fsp_silicon_init);
 	post_code(POST_FSP_SILICON_INIT);
+	tpm_flush_pcr_extends();
+	sampling_profiler_pause();
 	status = fsp_silicon_init(&silicon_init_params);
+	sampling_profiler_resume();
 	timestamp_add_now(TS_FSP_SILICON_INIT_END);
 	printk(BIOS_DEBUG, "FspSiliconInit returned 0x%08x\n", status);
 
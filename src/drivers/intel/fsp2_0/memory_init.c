@@ -306,6 +306,7 @@ static void do_fsp_memory_init(const struct fspm_context *context, bool s3wake)
 
 	post_code(POST_FSP_MEMORY_INIT);
 	timestamp_add_now(TS_FSP_MEMORY_INIT_START);
+	tpm_flush_pcr_extends();
 	status = fsp_raminit(&fspm_upd, fsp_get_hob_list_ptr());
 	post_code(POST_FSP_MEMORY_EXIT);
 	timestamp_add_now(TS_FSP_MEMORY_INIT_END);
@@ -4,6 +4,8 @@
 #include <console/console.h>
 #include <cpu/x86/mtrr.h>
 #include <fsp/util.h>
+#include <sampling_profiler.h>
+#include <security/tpm/tspi.h>
 #include <timestamp.h>
 
 static void fsp_notify(enum fsp_notify_phase phase)
@@ -30,7 +32,10 @@ static void fsp_notify(enum fsp_notify_phase phase)
 		post_code(POST_FSP_NOTIFY_BEFORE_END_OF_FIRMWARE);
 	}
 
+	tpm_flush_pcr_extends();
+	sampling_profiler_pause();
 	ret = fspnotify(&notify_params);
+	sampling_profiler_resume();
 
 	if (phase == AFTER_PCI_ENUM) {
 		timestamp_add_now(TS_FSP_AFTER_ENUMERATE);
@@ -8,6 +8,8 @@
 #include <fsp/api.h>
 #include <fsp/util.h>
 #include <program_loading.h>
+#include <sampling_profiler.h>
+#include <security/tpm/tspi.h>
 #include <soc/intel/common/vbt.h>
 #include <stage_cache.h>
 #include <string.h>
@@ -117,7 +119,10 @@ static void do_silicon_init(struct fsp_header *hdr)
 
 	timestamp_add_now(TS_FSP_SILICON_INIT_START);
 	post_code(POST_FSP_SILICON_INIT);
+	tpm_flush_pcr_extends();
+	sampling_profiler_pause();
 	status = silicon_init(upd);
+	sampling_profiler_resume();
 	timestamp_add_now(TS_FSP_SILICON_INIT_END);
 	post_code(POST_FSP_SILICON_EXIT);
 
@@ -152,7 +157,10 @@ static void do_silicon_init(struct fsp_header *hdr)
 	multi_phase_params.multi_phase_action = GET_NUMBER_OF_PHASES;
 	multi_phase_params.phase_index = 0;
 	multi_phase_params.multi_phase_param_ptr = &multi_phase_get_number;
+	tpm_flush_pcr_extends();
+	sampling_profiler_pause();
 	status = multi_phase_si_init(&multi_phase_params);
+	sampling_profiler_resume();
 	fsps_return_value_handler(FSP_MULTI_PHASE_SI_INIT_GET_NUMBER_OF_PHASES_API, status);
 
 	/* Execute Multi Phase Execution */
@@ -167,7 +175,10 @@ static void do_silicon_init(struct fsp_header *hdr)
 		multi_phase_params.multi_phase_action = EXECUTE_PHASE;
 		multi_phase_params.phase_index = i;
 		multi_phase_params.multi_phase_param_ptr = NULL;
+		tpm_flush_pcr_extends();
+		sampling_profiler_pause();
 		status = multi_phase_si_init(&multi_phase_params);
+		sampling_profiler_resume();
 		fsps_return_value_handler(FSP_MULTI_PHASE_SI_INIT_EXECUTE_PHASE_API, status);
 	}
 	timestamp_add_now(TS_FSP_MULTI_PHASE_SI_INIT_END);
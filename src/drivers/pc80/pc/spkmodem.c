@@ -5,6 +5,9 @@
 
 #define SPEAKER_PIT_FREQUENCY		0x1234dd
 
+/* Tone lengths are counted in half periods, 5 ms for a bit at speed 1. */
+#define TONE_LENGTH(n)			((n) / CONFIG_SPKMODEM_SPEED)
+
 
 enum {
 	PIT_COUNTER_0 = 0x40,
@@ -86,13 +89,13 @@ void spkmodem_tx_byte(unsigned char c)
 {
 	int i;
 
-	make_tone(SPEAKER_PIT_FREQUENCY / 200, 4);
+	make_tone(SPEAKER_PIT_FREQUENCY / 200, TONE_LENGTH(4));
 	for (i = 7; i >= 0; i--) {
 		if ((c >> i) & 1)
-			make_tone(SPEAKER_PIT_FREQUENCY / 2000, 20);
+			make_tone(SPEAKER_PIT_FREQUENCY / 2000, TONE_LENGTH(20));
 		else
-			make_tone(SPEAKER_PIT_FREQUENCY / 4000, 40);
-		make_tone(SPEAKER_PIT_FREQUENCY / 1000, 10);
+			make_tone(SPEAKER_PIT_FREQUENCY / 4000, TONE_LENGTH(40));
+		make_tone(SPEAKER_PIT_FREQUENCY / 1000, TONE_LENGTH(10));
 	}
 	make_tone(SPEAKER_PIT_FREQUENCY / 200, 0);
 }
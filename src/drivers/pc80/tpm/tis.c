@@ -10,9 +10,11 @@
  * Infineon slb9635), so this driver provides access to locality 0 only.
  */
 
+#include <commonlib/endian.h>
 #include <commonlib/helpers.h>
 #include <string.h>
 #include <delay.h>
+#include <timer.h>
 #include <device/mmio.h>
 #include <acpi/acpi.h>
 #include <acpi/acpigen.h>
@@ -55,6 +57,7 @@
 #define TIS_REG_STS                    0x18
 #define TIS_REG_BURST_COUNT            0x19
 #define TIS_REG_DATA_FIFO              0x24
+#define TIS_REG_XDATA_FIFO             0x80
 #define TIS_REG_DID_VID                0xf00
 #define TIS_REG_RID                    0xf04
 
@@ -74,6 +77,13 @@
 #define TIS_ACCESS_REQUEST_USE         (1 << 1) /* 0x02 */
 #define TIS_ACCESS_TPM_ESTABLISHMENT   (1 << 0) /* 0x01 */
 
+#define TIS_CAP_TRANSFER_SIZE_SHIFT    9
+#define TIS_CAP_TRANSFER_SIZE_MASK     0x3
+#define  TIS_CAP_TRANSFER_LEGACY       0
+#define TIS_CAP_VERSION_SHIFT          28
+#define TIS_CAP_VERSION_MASK           0x7
+#define  TIS_CAP_VERSION_PTP           3 /* TPM 2.0 FIFO interface */
+
 /*
  * Error value returned if a tpm register does not enter the expected state
  * after continuous polling. No actual TPM register reading ever returns ~0,
@@ -152,6 +162,14 @@ static const struct vendor_name vendor_names[] = {
  */
 static u32 vendor_dev_id;
 
+/*
+ * FIFO register and access width in bytes. TPMs that report a data transfer
+ * size in the interface capability accept 32-bit FIFO accesses, and TPM 2.0
+ * parts also have the extended FIFO. Everything else is fed byte by byte.
+ */
+static u16 fifo_reg = TIS_REG_DATA_FIFO;
+static u8 fifo_width = 1;
+
 static inline u8 tpm_read_status(int locality)
 {
 	u8 value = read8(TIS_REG(locality, TIS_REG_STS));
@@ -178,13 +196,66 @@ static inline void tpm_write_data(u8 data, int locality)
 	write8(TIS_REG(locality, TIS_REG_DATA_FIFO), data);
 }
 
+/*
+ * Reads the FIFO register window in as few accesses as the TPM supports,
+ * 32 bits at a time and the remainder byte by byte.
+ */
+static void tpm_read_fifo(u8 *data, size_t len, int locality)
+{
+	void *fifo = TIS_REG(locality, fifo_reg);
+
+	if (fifo_width == sizeof(u32)) {
+		for (; len >= sizeof(u32); len -= sizeof(u32)) {
+			write_le32(data, read32(fifo));
+			TPM_DEBUG_IO_READ(fifo_reg, read_le32(data));
+			data += sizeof(u32);
+		}
+	}
+	while (len--)
+		*data++ = tpm_read_data(locality);
+}
+
+static void tpm_write_fifo(const u8 *data, size_t len, int locality)
+{
+	void *fifo = TIS_REG(locality, fifo_reg);
+
+	if (fifo_width == sizeof(u32)) {
+		for (; len >= sizeof(u32); len -= sizeof(u32)) {
+			TPM_DEBUG_IO_WRITE(fifo_reg, read_le32(data));
+			write32(fifo, read_le32(data));
+			data += sizeof(u32);
+		}
+	}
+	while (len--)
+		tpm_write_data(*data++, locality);
+}
+
+/*
+ * Reads the status register together with the burst count in the bytes
+ * above it, one access instead of three.
+ */
+static inline u32 tpm_read_status_burst(int locality)
+{
+	u32 value = read32(TIS_REG(locality, TIS_REG_STS));
+	TPM_DEBUG_IO_READ(TIS_REG_STS, value);
+	return value;
+}
+
+static inline u16 tis_burst_count(u32 status_burst)
+{
+	return (status_burst >> 8) & 0xffff;
+}
+
 static inline u16 tpm_read_burst_count(int locality)
 {
-	u16 count;
-	count = read8(TIS_REG(locality, TIS_REG_BURST_COUNT));
-	count |= read8(TIS_REG(locality, TIS_REG_BURST_COUNT + 1)) << 8;
-	TPM_DEBUG_IO_READ(TIS_REG_BURST_COUNT, count);
-	return count;
+	return tis_burst_count(tpm_read_status_burst(locality));
+}
+
+static inline u32 tpm_read_intf_capability(int locality)
+{
+	u32 value = read32(TIS_REG(locality, TIS_REG_INTF_CAPABILITY));
+	TPM_DEBUG_IO_READ(TIS_REG_INTF_CAPABILITY, value);
+	return value;
 }
 
 static inline u8 tpm_read_access(int locality)
@@ -237,6 +308,25 @@ static inline u32 tpm_read_int_polarity(int locality)
 	return value;
 }
 
+/*
+ * Polls run for up to MAX_DELAY_US without delays in between. Without a
+ * monotonic timer, 1 us delays are counted in the stopwatch instead.
+ */
+static inline void tis_timeout_init(struct stopwatch *sw)
+{
+	stopwatch_init_usecs_expire(sw, MAX_DELAY_US);
+}
+
+static int tis_timeout_expired(struct stopwatch *sw)
+{
+	if (CONFIG(HAVE_MONOTONIC_TIMER))
+		return stopwatch_expired(sw);
+
+	udelay(1);
+	mono_time_add_usecs(&sw->current, 1);
+	return !mono_time_before(&sw->current, &sw->expires);
+}
+
 /*
  * tis_wait_sts()
  *
@@ -251,43 +341,39 @@ static inline u32 tpm_read_int_polarity(int locality)
  */
 static int tis_wait_sts(int locality, u8 mask, u8 expected)
 {
-	u32 time_us = MAX_DELAY_US;
-	while (time_us > 0) {
+	struct stopwatch sw;
+
+	tis_timeout_init(&sw);
+	do {
 		u8 value = tpm_read_status(locality);
 		if ((value & mask) == expected)
 			return 0;
-		udelay(1); /* 1 us */
-		time_us--;
-	}
+	} while (!tis_timeout_expired(&sw));
 	return TPM_TIMEOUT_ERR;
 }
 
-static inline int tis_wait_ready(int locality)
-{
-	return tis_wait_sts(locality, TIS_STS_COMMAND_READY,
-	                    TIS_STS_COMMAND_READY);
-}
-
-static inline int tis_wait_valid(int locality)
-{
-	return tis_wait_sts(locality, TIS_STS_VALID, TIS_STS_VALID);
-}
-
-static inline int tis_wait_valid_data(int locality)
+/*
+ * Like tis_wait_sts(), but reads the burst count along with the status and
+ * returns both in @status_burst.
+ */
+static int tis_wait_sts_burst(int locality, u8 mask, u8 expected,
+			      u32 *status_burst)
 {
-	const u8 has_data = TIS_STS_DATA_AVAILABLE | TIS_STS_VALID;
-	return tis_wait_sts(locality, has_data, has_data);
-}
+	struct stopwatch sw;
 
-static inline int tis_has_valid_data(int locality)
-{
-	const u8 has_data = TIS_STS_DATA_AVAILABLE | TIS_STS_VALID;
-	return (tpm_read_status(locality) & has_data) == has_data;
+	tis_timeout_init(&sw);
+	do {
+		*status_burst = tpm_read_status_burst(locality);
+		if ((*status_burst & mask) == expected)
+			return 0;
+	} while (!tis_timeout_expired(&sw));
+	return TPM_TIMEOUT_ERR;
 }
 
-static inline int tis_expect_data(int locality)
+static inline int tis_wait_ready(int locality)
 {
-	return !!(tpm_read_status(locality) & TIS_STS_EXPECT);
+	return tis_wait_sts(locality, TIS_STS_COMMAND_READY,
+	                    TIS_STS_COMMAND_READY);
 }
 
 /*
@@ -304,14 +390,14 @@ static inline int tis_expect_data(int locality)
  */
 static int tis_wait_access(int locality, u8 mask, u8 expected)
 {
-	u32 time_us = MAX_DELAY_US;
-	while (time_us > 0) {
+	struct stopwatch sw;
+
+	tis_timeout_init(&sw);
+	do {
 		u8 value = tpm_read_access(locality);
 		if ((value & mask) == expected)
 			return 0;
-		udelay(1); /* 1 us */
-		time_us--;
-	}
+	} while (!tis_timeout_expired(&sw));
 	return TPM_TIMEOUT_ERR;
 }
 
@@ -386,7 +472,7 @@ static u32 tis_probe(void)
 	const char *device_name = "unknown";
 	const char *vendor_name = device_name;
 	const struct device_name *dev;
-	u32 didvid;
+	u32 didvid, cap;
 	u16 vid, did;
 	int i;
 
@@ -401,6 +487,15 @@ static u32 tis_probe(void)
 
 	vendor_dev_id = didvid;
 
+	cap = tpm_read_intf_capability(0);
+	if (((cap >> TIS_CAP_TRANSFER_SIZE_SHIFT) & TIS_CAP_TRANSFER_SIZE_MASK) !=
+	    TIS_CAP_TRANSFER_LEGACY) {
+		fifo_width = sizeof(u32);
+		if (((cap >> TIS_CAP_VERSION_SHIFT) & TIS_CAP_VERSION_MASK) ==
+		    TIS_CAP_VERSION_PTP)
+			fifo_reg = TIS_REG_XDATA_FIFO;
+	}
+
 	vid = didvid & 0xffff;
 	did = (didvid >> 16) & 0xffff;
 	for (i = 0; i < ARRAY_SIZE(vendor_names); i++) {
@@ -440,9 +535,10 @@ static u32 tis_probe(void)
  */
 static u32 tis_senddata(const u8 *const data, u32 len)
 {
+	struct stopwatch sw;
 	u32 offset = 0;
+	u32 status;
 	u16 burst = 0;
-	u32 max_cycles = 0;
 	u8 locality = 0;
 
 	if (tis_wait_ready(locality)) {
@@ -456,18 +552,18 @@ static u32 tis_senddata(const u8 *const data, u32 len)
 		unsigned int count;
 
 		/* Wait till the device is ready to accept more data. */
-		while (!burst) {
-			if (max_cycles++ == MAX_DELAY_US) {
-				printf("%s:%d failed to feed %d bytes of %d\n",
-				       __FILE__, __LINE__, len - offset, len);
-				return TPM_DRIVER_ERR;
-			}
-			udelay(1);
-			burst = tpm_read_burst_count(locality);
+		if (!burst) {
+			tis_timeout_init(&sw);
+			do {
+				if (tis_timeout_expired(&sw)) {
+					printf("%s:%d failed to feed %d bytes of %d\n",
+					       __FILE__, __LINE__, len - offset, len);
+					return TPM_DRIVER_ERR;
+				}
+				burst = tpm_read_burst_count(locality);
+			} while (!burst);
 		}
 
-		max_cycles = 0;
-
 		/*
 		 * Calculate number of bytes the TPM is ready to accept in one
 		 * shot.
@@ -478,16 +574,18 @@ static u32 tis_senddata(const u8 *const data, u32 len)
 		 * FIFO.
 		 */
 		count = MIN(burst, len - offset - 1);
-		while (count--)
-			tpm_write_data(data[offset++], locality);
+		tpm_write_fifo(data + offset, count, locality);
+		offset += count;
 
-		if (tis_wait_valid(locality) || !tis_expect_data(locality)) {
+		/* The status read also tells how much more fits. */
+		if (tis_wait_sts_burst(locality, TIS_STS_VALID, TIS_STS_VALID,
+				       &status) || !(status & TIS_STS_EXPECT)) {
 			printf("%s:%d TPM command feed overflow\n",
 			       __FILE__, __LINE__);
 			return TPM_DRIVER_ERR;
 		}
 
-		burst = tpm_read_burst_count(locality);
+		burst = tis_burst_count(status);
 		if ((offset == (len - 1)) && burst)
 			/*
 			 * We need to be able to send the last byte to the
@@ -504,9 +602,10 @@ static u32 tis_senddata(const u8 *const data, u32 len)
 	 * Verify that TPM does not expect any more data as part of this
 	 * command.
 	 */
-	if (tis_wait_valid(locality) || tis_expect_data(locality)) {
+	if (tis_wait_sts_burst(locality, TIS_STS_VALID, TIS_STS_VALID, &status) ||
+	    (status & TIS_STS_EXPECT)) {
 		printf("%s:%d unexpected TPM status 0x%x\n",
-		       __FILE__, __LINE__, tpm_read_status(locality));
+		       __FILE__, __LINE__, status & 0xff);
 		return TPM_DRIVER_ERR;
 	}
 
@@ -530,32 +629,44 @@ static u32 tis_senddata(const u8 *const data, u32 len)
  */
 static u32 tis_readresponse(u8 *buffer, size_t *len)
 {
+	const u8 has_data = TIS_STS_DATA_AVAILABLE | TIS_STS_VALID;
+	struct stopwatch sw;
 	u16 burst_count;
 	u32 offset = 0;
 	u8 locality = 0;
 	u32 expected_count = *len;
-	int max_cycles = 0;
+	u32 status;
 
 	/* Wait for the TPM to process the command */
-	if (tis_wait_valid_data(locality)) {
+	if (tis_wait_sts_burst(locality, has_data, has_data, &status)) {
 		printf("%s:%d failed processing command\n", __FILE__, __LINE__);
 		return TPM_DRIVER_ERR;
 	}
 
 	do {
-		while ((burst_count = tpm_read_burst_count(locality)) == 0) {
-			if (max_cycles++ == MAX_DELAY_US) {
-				printf("%s:%d TPM stuck on read\n",
-				       __FILE__, __LINE__);
-				return TPM_DRIVER_ERR;
-			}
-			udelay(1);
+		burst_count = tis_burst_count(status);
+		if (!burst_count) {
+			tis_timeout_init(&sw);
+			do {
+				if (tis_timeout_expired(&sw)) {
+					printf("%s:%d TPM stuck on read\n",
+					       __FILE__, __LINE__);
+					return TPM_DRIVER_ERR;
+				}
+				burst_count = tpm_read_burst_count(locality);
+			} while (!burst_count);
 		}
 
-		max_cycles = 0;
+		while (burst_count && (offset < expected_count)) {
+			/* Stop after the header to learn the response size. */
+			u32 count = MIN(burst_count, expected_count - offset);
+			if (offset < 6)
+				count = MIN(count, 6 - offset);
+
+			tpm_read_fifo(buffer + offset, count, locality);
+			offset += count;
+			burst_count -= count;
 
-		while (burst_count-- && (offset < expected_count)) {
-			buffer[offset++] = tpm_read_data(locality);
 			if (offset == 6) {
 				/*
 				 * We got the first six bytes of the reply,
@@ -581,7 +692,8 @@ static u32 tis_readresponse(u8 *buffer, size_t *len)
 		}
 
 		/* Wait for the next portion */
-		if (tis_wait_valid(locality)) {
+		if (tis_wait_sts_burst(locality, TIS_STS_VALID, TIS_STS_VALID,
+				       &status)) {
 			printf("%s:%d failed to read response\n",
 			       __FILE__, __LINE__);
 			return TPM_DRIVER_ERR;
@@ -591,20 +703,22 @@ static u32 tis_readresponse(u8 *buffer, size_t *len)
 			break;	/* We got all we need */
 
 		/*
-		 * Certain TPMs seem to need some delay between tis_wait_valid()
-		 * and tis_has_valid_data(), or some race-condition-related
+		 * Certain TPMs seem to need some delay between stsValid and
+		 * checking for more data, or some race-condition-related
 		 * issue will occur.
 		 */
-		if (CONFIG(TPM_RDRESP_NEED_DELAY))
+		if (CONFIG(TPM_RDRESP_NEED_DELAY)) {
 			udelay(10);
+			status = tpm_read_status_burst(locality);
+		}
 
-	} while (tis_has_valid_data(locality));
+	} while ((status & has_data) == has_data);
 
 	/* * Make sure we indeed read all there was. */
-	if (tis_has_valid_data(locality)) {
+	if ((status & has_data) == has_data) {
 		printf("%s:%d wrong receive status: %x %d bytes left\n",
-		       __FILE__, __LINE__, tpm_read_status(locality),
-	               tpm_read_burst_count(locality));
+		       __FILE__, __LINE__, status & 0xff,
+		       tis_burst_count(status));
 		return TPM_DRIVER_ERR;
 	}
 
@@ -699,6 +813,14 @@ int tis_close(void)
  */
 int tis_sendrecv(const uint8_t *sendbuf, size_t send_size,
 		 uint8_t *recvbuf, size_t *recv_len)
+{
+	if (tis_send(sendbuf, send_size))
+		return TPM_DRIVER_ERR;
+
+	return tis_recv(recvbuf, recv_len);
+}
+
+int tis_send(const uint8_t *sendbuf, size_t send_size)
 {
 	if (tis_senddata(sendbuf, send_size)) {
 		printf("%s:%d failed sending data to TPM\n",
@@ -706,6 +828,18 @@ int tis_sendrecv(const uint8_t *sendbuf, size_t send_size,
 		return TPM_DRIVER_ERR;
 	}
 
+	return 0;
+}
+
+int tis_response_ready(void)
+{
+	const u8 has_data = TIS_STS_DATA_AVAILABLE | TIS_STS_VALID;
+
+	return (tpm_read_status(0) & has_data) == has_data;
+}
+
+int tis_recv(uint8_t *recvbuf, size_t *recv_len)
+{
 	return tis_readresponse(recvbuf, recv_len);
 }
 
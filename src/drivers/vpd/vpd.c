@@ -4,6 +4,7 @@
 #include <console/console.h>
 #include <cbmem.h>
 #include <fmap.h>
+#include <lib.h>
 #include <program_loading.h>
 #include <string.h>
 #include <timestamp.h>
@@ -16,6 +17,7 @@
 enum {
 	CROSVPD_CBMEM_MAGIC = 0x43524f53,
 	CROSVPD_CBMEM_VERSION = 0x0001,
+	CROSVPD_INDEX_MAGIC = 0x56504449,
 };
 
 struct vpd_cbmem {
@@ -29,6 +31,32 @@ struct vpd_cbmem {
 	 */
 };
 
+/*
+ * Hash table of the keys in the CBMEM VPD copy, so that lookups don't have to
+ * decode the whole blob. It has a power of two number of buckets for each
+ * region, RO buckets first. Offsets are relative to vpd_cbmem.blob.
+ */
+struct vpd_index_entry {
+	uint32_t hash;	/* 0 for a free bucket */
+	uint32_t key_offset;
+	uint32_t key_len;
+	uint32_t value_offset;
+	uint32_t value_len;
+};
+
+struct vpd_index {
+	uint32_t magic;
+	uint32_t num_buckets[2];	/* Indexed by VPD_RO and VPD_RW. */
+	struct vpd_index_entry entries[0];
+};
+
+struct vpd_index_arg {
+	const uint8_t *blob;
+	struct vpd_index_entry *buckets;
+	uint32_t num_buckets;
+	uint32_t count;
+};
+
 struct vpd_gets_arg {
 	const uint8_t *key;
 	const uint8_t *value;
@@ -37,6 +65,8 @@ struct vpd_gets_arg {
 };
 
 static struct region_device ro_vpd, rw_vpd;
+static const struct vpd_index *vpd_index;
+static const uint8_t *vpd_blob;
 
 /*
  * Initializes a region_device to represent the requested VPD 2.0 formatted
@@ -90,6 +120,38 @@ fail:
 	memset(rdev, 0, sizeof(*rdev));
 }
 
+static uint32_t vpd_key_hash(const uint8_t *key, uint32_t key_len)
+{
+	uint32_t hash = 2166136261;
+
+	while (key_len--)
+		hash = (hash ^ *key++) * 16777619;
+
+	/* 0 marks free buckets. */
+	return hash ? hash : 1;
+}
+
+static void init_vpd_index_from_cbmem(const struct vpd_cbmem *cbmem)
+{
+	const struct cbmem_entry *entry = cbmem_entry_find(CBMEM_ID_VPD_INDEX);
+	const struct vpd_index *index;
+	size_t num_buckets;
+
+	vpd_index = NULL;
+	if (!entry || cbmem_entry_size(entry) < sizeof(*index))
+		return;
+
+	index = cbmem_entry_start(entry);
+	num_buckets = index->num_buckets[VPD_RO] + index->num_buckets[VPD_RW];
+	if (index->magic != CROSVPD_INDEX_MAGIC ||
+	    sizeof(*index) + num_buckets * sizeof(index->entries[0]) >
+	    cbmem_entry_size(entry))
+		return;
+
+	vpd_index = index;
+	vpd_blob = cbmem->blob;
+}
+
 static int init_vpd_rdevs_from_cbmem(void)
 {
 	if (!cbmem_possibly_online())
@@ -104,6 +166,8 @@ static int init_vpd_rdevs_from_cbmem(void)
 	rdev_chain(&rw_vpd, &addrspace_32bit.rdev,
 		   (uintptr_t)cbmem->blob + cbmem->ro_size, cbmem->rw_size);
 
+	init_vpd_index_from_cbmem(cbmem);
+
 	return 0;
 }
 
@@ -122,6 +186,99 @@ static void init_vpd_rdevs(void)
 	done = true;
 }
 
+static int vpd_count_callback(const uint8_t *key, uint32_t key_len,
+			      const uint8_t *value, uint32_t value_len,
+			      void *arg)
+{
+	((struct vpd_index_arg *)arg)->count++;
+	return VPD_DECODE_OK;
+}
+
+static int vpd_index_callback(const uint8_t *key, uint32_t key_len,
+			      const uint8_t *value, uint32_t value_len,
+			      void *arg)
+{
+	struct vpd_index_arg *index = arg;
+	const uint32_t hash = vpd_key_hash(key, key_len);
+	const uint32_t mask = index->num_buckets - 1;
+	struct vpd_index_entry *e;
+	uint32_t i;
+
+	for (i = hash & mask; index->buckets[i].hash; i = (i + 1) & mask) {
+		e = &index->buckets[i];
+		/* Like a linear search, the first entry of a key wins. */
+		if (e->hash == hash && e->key_len == key_len &&
+		    memcmp(index->blob + e->key_offset, key, key_len) == 0)
+			return VPD_DECODE_OK;
+	}
+
+	e = &index->buckets[i];
+	e->hash = hash;
+	e->key_offset = key - index->blob;
+	e->key_len = key_len;
+	e->value_offset = value - index->blob;
+	e->value_len = value_len;
+
+	return VPD_DECODE_OK;
+}
+
+static void vpd_decode_all(const uint8_t *data, uint32_t size,
+			   vpd_decode_callback callback, void *arg)
+{
+	uint32_t consumed = 0;
+
+	while (vpd_decode_string(size, data, &consumed, callback, arg) ==
+	       VPD_DECODE_OK) {
+	/* Iterate until no more entries. */
+	}
+}
+
+/* Decodes the CBMEM VPD copy once and stores its keys in CBMEM_ID_VPD_INDEX. */
+static void cbmem_add_vpd_index(struct vpd_cbmem *cbmem)
+{
+	const uint32_t offsets[] = { [VPD_RO] = 0, [VPD_RW] = cbmem->ro_size };
+	const uint32_t sizes[] = { [VPD_RO] = cbmem->ro_size,
+				   [VPD_RW] = cbmem->rw_size };
+	uint32_t num_buckets[ARRAY_SIZE(sizes)];
+	struct vpd_index_arg arg = { .blob = cbmem->blob };
+	struct vpd_index *index;
+	size_t total = 0, size, i;
+
+	for (i = 0; i < ARRAY_SIZE(sizes); i++) {
+		arg.count = 0;
+		vpd_decode_all(cbmem->blob + offsets[i], sizes[i],
+			       vpd_count_callback, &arg);
+		/* Keep the table at most half full. */
+		num_buckets[i] = arg.count ? 1 << log2_ceil(arg.count * 2) : 0;
+		total += num_buckets[i];
+	}
+
+	size = sizeof(*index) + total * sizeof(index->entries[0]);
+	index = cbmem_add(CBMEM_ID_VPD_INDEX, size);
+	if (!index) {
+		printk(BIOS_ERR, "%s: Failed to allocate CBMEM (%zu).\n",
+			__func__, size);
+		return;
+	}
+	/* On resume the entry from the previous boot may be too small. */
+	if (cbmem_entry_size(cbmem_entry_find(CBMEM_ID_VPD_INDEX)) < size) {
+		index->magic = 0;
+		return;
+	}
+
+	memset(index, 0, size);
+	arg.buckets = index->entries;
+	for (i = 0; i < ARRAY_SIZE(sizes); i++) {
+		index->num_buckets[i] = num_buckets[i];
+		arg.num_buckets = num_buckets[i];
+		if (arg.num_buckets)
+			vpd_decode_all(cbmem->blob + offsets[i], sizes[i],
+				       vpd_index_callback, &arg);
+		arg.buckets += num_buckets[i];
+	}
+	index->magic = CROSVPD_INDEX_MAGIC;
+}
+
 static void cbmem_add_cros_vpd(int is_recovery)
 {
 	struct vpd_cbmem *cbmem;
@@ -166,6 +323,8 @@ static void cbmem_add_cros_vpd(int is_recovery)
 		timestamp_add_now(TS_END_COPYVPD_RW);
 	}
 
+	cbmem_add_vpd_index(cbmem);
+
 	init_vpd_rdevs_from_cbmem();
 }
 
@@ -186,11 +345,44 @@ static int vpd_gets_callback(const uint8_t *key, uint32_t key_len,
 	return VPD_DECODE_FAIL;
 }
 
-static void vpd_find_in(struct region_device *rdev, struct vpd_gets_arg *arg)
+static void vpd_find_indexed(enum vpd_region region, struct vpd_gets_arg *arg)
+{
+	const uint32_t hash = vpd_key_hash(arg->key, arg->key_len);
+	const uint32_t mask = vpd_index->num_buckets[region] - 1;
+	const struct vpd_index_entry *buckets = vpd_index->entries;
+	uint32_t i;
+
+	if (vpd_index->num_buckets[region] == 0)
+		return;
+
+	if (region == VPD_RW)
+		buckets += vpd_index->num_buckets[VPD_RO];
+
+	for (i = hash & mask; buckets[i].hash; i = (i + 1) & mask) {
+		const struct vpd_index_entry *e = &buckets[i];
+
+		if (e->hash == hash && e->key_len == (uint32_t)arg->key_len &&
+		    memcmp(vpd_blob + e->key_offset, arg->key, arg->key_len) == 0) {
+			arg->matched = 1;
+			arg->value = vpd_blob + e->value_offset;
+			arg->value_len = e->value_len;
+			return;
+		}
+	}
+}
+
+static void vpd_find_in(enum vpd_region region, struct vpd_gets_arg *arg)
 {
+	struct region_device *rdev = region == VPD_RO ? &ro_vpd : &rw_vpd;
+
 	if (region_device_sz(rdev) == 0)
 		return;
 
+	if (vpd_index) {
+		vpd_find_indexed(region, arg);
+		return;
+	}
+
 	uint32_t consumed = 0;
 	void *mapping = rdev_mmap_full(rdev);
 	while (vpd_decode_string(region_device_sz(rdev), mapping,
@@ -210,14 +402,14 @@ const void *vpd_find(const char *key, int *size, enum vpd_region region)
 	init_vpd_rdevs();
 
 	if (region == VPD_RW_THEN_RO)
-		vpd_find_in(&rw_vpd, &arg);
+		vpd_find_in(VPD_RW, &arg);
 
 	if (!arg.matched && (region == VPD_RO || region == VPD_RO_THEN_RW ||
 			region == VPD_RW_THEN_RO))
-		vpd_find_in(&ro_vpd, &arg);
+		vpd_find_in(VPD_RO, &arg);
 
 	if (!arg.matched && (region == VPD_RW || region == VPD_RO_THEN_RW))
-		vpd_find_in(&rw_vpd, &arg);
+		vpd_find_in(VPD_RW, &arg);
 
 	if (!arg.matched)
 		return NULL;
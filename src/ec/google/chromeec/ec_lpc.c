@@ -6,12 +6,28 @@
 #include <delay.h>
 #include <device/pnp.h>
 #include <ec/google/common/mec.h>
+#include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "chip.h"
 #include "ec.h"
 #include "ec_commands.h"
 
+/*
+ * The host command and memory map ranges decode every I/O port as one byte
+ * of EC memory, so a 32-bit access to port n moves the bytes of ports n to
+ * n + 3. Copying four bytes per I/O instruction cuts the number of slow port
+ * accesses to a quarter. The string instructions (insl/outsl) can't be used,
+ * they repeat the access to a single port.
+ */
+
+/* Sum of the four bytes of a little endian word read from or written to LPC */
+static inline u8 csum_u32(u32 word)
+{
+	return word + (word >> 8) + (word >> 16) + (word >> 24);
+}
+
 /*
  * Read bytes from a given LPC-mapped address.
  *
@@ -22,7 +38,9 @@
  */
 static void read_bytes(u16 port, unsigned int length, u8 *dest, u8 *csum)
 {
-	int i;
+	unsigned int i = 0;
+	u8 sum = 0;
+	u32 word;
 
 #if CONFIG(EC_GOOGLE_CHROMEEC_MEC)
 	/* Access desired range though EMI interface */
@@ -36,11 +54,24 @@ static void read_bytes(u16 port, unsigned int length, u8 *dest, u8 *csum)
 	}
 #endif
 
-	for (i = 0; i < length; ++i) {
+	for (; i < length && !IS_ALIGNED(port + i, sizeof(word)); i++) {
 		dest[i] = inb(port + i);
-		if (csum)
-			*csum += dest[i];
+		sum += dest[i];
+	}
+
+	for (; i + sizeof(word) <= length; i += sizeof(word)) {
+		word = inl(port + i);
+		memcpy(&dest[i], &word, sizeof(word));
+		sum += csum_u32(word);
+	}
+
+	for (; i < length; i++) {
+		dest[i] = inb(port + i);
+		sum += dest[i];
 	}
+
+	if (csum)
+		*csum += sum;
 }
 
 /* Read single byte and return byte read */
@@ -59,27 +90,42 @@ static inline u8 read_byte(u16 port)
  * @msg: Write data buffer
  * @csum: Optional parameter, sums data written
  */
-static void write_bytes(u16 port, unsigned int length, u8 *msg, u8 *csum)
+static void write_bytes(u16 port, unsigned int length, const u8 *msg, u8 *csum)
 {
-	int i;
+	unsigned int i = 0;
+	u8 sum = 0;
+	u32 word;
 
 #if CONFIG(EC_GOOGLE_CHROMEEC_MEC)
 	/* Access desired range though EMI interface */
 	if (port >= MEC_EMI_RANGE_START && port <= MEC_EMI_RANGE_END) {
 		u8 ret = mec_io_bytes(MEC_IO_WRITE, MEC_EMI_BASE,
 				     port - MEC_EMI_RANGE_START,
-				     msg, length);
+				     (u8 *)msg, length);
 		if (csum)
 			*csum += ret;
 		return;
 	}
 #endif
 
-	for (i = 0; i < length; ++i) {
+	for (; i < length && !IS_ALIGNED(port + i, sizeof(word)); i++) {
 		outb(msg[i], port + i);
-		if (csum)
-			*csum += msg[i];
+		sum += msg[i];
+	}
+
+	for (; i + sizeof(word) <= length; i += sizeof(word)) {
+		memcpy(&word, &msg[i], sizeof(word));
+		outl(word, port + i);
+		sum += csum_u32(word);
 	}
+
+	for (; i < length; i++) {
+		outb(msg[i], port + i);
+		sum += msg[i];
+	}
+
+	if (csum)
+		*csum += sum;
 }
 
 /* Write single byte and return byte written */
@@ -183,9 +229,7 @@ static int google_chromeec_command_v3(struct chromeec_command *cec_command)
 {
 	struct ec_host_request rq;
 	struct ec_host_response rs;
-	const u8 *d;
 	u8 csum = 0;
-	int i;
 
 	if (cec_command->cmd_size_in + sizeof(rq) > EC_LPC_HOST_PACKET_SIZE) {
 		printk(BIOS_ERR, "EC cannot send %zu bytes\n",
@@ -214,21 +258,16 @@ static int google_chromeec_command_v3(struct chromeec_command *cec_command)
 	rq.reserved = 0;
 	rq.data_len = cec_command->cmd_size_in;
 
-	/* Copy data and start checksum */
+	/* Copy header and data, summing them on the way */
+	write_bytes(EC_LPC_ADDR_HOST_PACKET, sizeof(rq), (u8 *)&rq, &csum);
 	write_bytes(EC_LPC_ADDR_HOST_PACKET + sizeof(rq),
 		    cec_command->cmd_size_in,
-		    (u8*)cec_command->cmd_data_in,
+		    cec_command->cmd_data_in,
 		    &csum);
 
-	/* Finish checksum */
-	for (i = 0, d = (const u8 *)&rq; i < sizeof(rq); i++, d++)
-		csum += *d;
-
 	/* Write checksum field so the entire packet sums to 0 */
-	rq.checksum = -csum;
-
-	/* Copy header */
-	write_bytes(EC_LPC_ADDR_HOST_PACKET, sizeof(rq), (u8*)&rq, NULL);
+	write_byte(-csum, EC_LPC_ADDR_HOST_PACKET +
+		   offsetof(struct ec_host_request, checksum));
 
 	/* Start the command */
 	write_byte(EC_COMMAND_PROTOCOL_3, EC_LPC_ADDR_HOST_CMD);
@@ -244,7 +283,7 @@ static int google_chromeec_command_v3(struct chromeec_command *cec_command)
 	if (cec_command->cmd_code) {
 		printk(BIOS_ERR, "EC returned error result code %d\n",
 			cec_command->cmd_code);
-		return -i;
+		return -1;
 	}
 
 	/* Read back response header and start checksum */
@@ -280,6 +319,7 @@ static int google_chromeec_command_v3(struct chromeec_command *cec_command)
 		printk(BIOS_ERR, "EC response has invalid checksum\n");
 		return -1;
 	}
+	cec_command->cmd_size_out = rs.data_len;
 
 	return 0;
 }
@@ -300,7 +340,7 @@ static int google_chromeec_command_v1(struct chromeec_command *cec_command)
 
 	write_bytes(EC_LPC_ADDR_HOST_PARAM,
 		    cec_command->cmd_size_in,
-		    (u8*)cec_command->cmd_data_in,
+		    cec_command->cmd_data_in,
 		    &csum);
 
 	/* Finalize checksum and write args */
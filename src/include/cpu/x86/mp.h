@@ -128,6 +128,56 @@ int mp_run_on_aps(void (*func)(void *), void *arg, int logical_cpu_num,
 /* Like mp_run_on_aps() but also runs func on BSP. */
 int mp_run_on_all_cpus(void (*func)(void *), void *arg);
 
+/*
+ * Queue func(arg) on AP logical_cpu_num and return without waiting for it to
+ * run, so that different APs can be handed different jobs back to back. Jobs
+ * posted to the same AP run in order. Only waits, for up to expire_us, if the
+ * mailbox of the AP is full. Returns the sequence number of the job, to be
+ * passed to mp_work_done(), or < 0 on error.
+ */
+int mp_post_work(int logical_cpu_num, void (*func)(void *), void *arg,
+		long expire_us);
+
+/* Returns 1 if job seq posted to AP logical_cpu_num has returned, else 0. */
+int mp_work_done(int logical_cpu_num, int seq);
+
+/*
+ * Wait for all work posted to the APs to return. Work that never returns,
+ * like parking the APs, makes this time out.
+ */
+int mp_wait_all(long expire_us);
+
+enum mp_init_step_type {
+	/* Call a function, which returns < 0 on error. */
+	MP_INIT_STEP_CALL,
+	/* Wait until every CPU running the recipe has done the steps before. */
+	MP_INIT_STEP_BARRIER,
+};
+
+/* One step of a per-CPU init recipe. */
+struct mp_init_step {
+	enum mp_init_step_type type;
+	int (*func)(void);
+};
+
+#define MP_STEP_CALL(fn) \
+	{ .type = MP_INIT_STEP_CALL, .func = (fn) }
+#define MP_STEP_BARRIER() \
+	{ .type = MP_INIT_STEP_BARRIER }
+
+/*
+ * Run an init recipe on every CPU in one pass. The BSP and all APs work
+ * through the steps concurrently and are joined once at the end, instead of
+ * meeting after every step. Steps that depend on other CPUs having finished
+ * earlier steps, e.g. because they touch MSRs shared between threads, must be
+ * separated from those by a barrier step. A CPU that times out at a barrier
+ * skips the rest of the recipe. Returns < 0 if a step failed on any CPU or the
+ * APs did not finish within expire_us. Without PARALLEL_MP_AP_WORK only the
+ * BSP runs the steps, and < 0 is returned.
+ */
+int mp_run_recipe(const struct mp_init_step *steps, size_t count,
+		  long expire_us);
+
 /*
  * Park all APs to prepare for OS boot. This is handled automatically
  * by the coreboot infrastructure.
@@ -179,6 +179,8 @@ void run_ramstage(void);
  ***********************/
 
 int payload_arch_usable_ram_quirk(uint64_t start, uint64_t size);
+/* Zero the part of a payload segment that isn't backed by file data. */
+void payload_arch_clear_segment(void *start, size_t size);
 
 /* Load payload into memory in preparation to run. */
 void payload_load(void);
@@ -11,6 +11,8 @@ int probe_mb(const uintptr_t dram_start, const uintptr_t size);
 /*
  * Probe an area if it's read/writable.
  * Primary use case is the detection of DRAM amount on emulators.
+ * The result found in romstage is handed to later stages probing the same
+ * window through CBMEM.
  *
  * @param dram_start Physical address of DRAM start
  * @param probe_size Maximum size in MiB to probe for
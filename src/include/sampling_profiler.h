@@ -0,0 +1,36 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef __SAMPLING_PROFILER_H__
+#define __SAMPLING_PROFILER_H__
+
+/* IDT vector of the profiler timer, above the range used by the legacy PIC. */
+#define SAMPLING_PROFILER_VECTOR	0x30
+
+#define ENV_SAMPLING_PROFILER \
+	(CONFIG(SAMPLING_PROFILER) && (ENV_ROMSTAGE || ENV_POSTCAR || ENV_RAMSTAGE))
+
+#ifndef __ASSEMBLER__
+
+#include <stdint.h>
+
+#if ENV_SAMPLING_PROFILER
+/* Called from the timer interrupt with the interrupted instruction pointer. */
+void sampling_profiler_tick(uintptr_t ip);
+/* Stop sampling for good before leaving the stage. */
+void sampling_profiler_stop(void);
+/*
+ * Stop sampling while running code that installs its own interrupt handlers,
+ * like option ROMs and FSP. Calls may be nested.
+ */
+void sampling_profiler_pause(void);
+void sampling_profiler_resume(void);
+#else
+static inline void sampling_profiler_tick(uintptr_t ip) {}
+static inline void sampling_profiler_stop(void) {}
+static inline void sampling_profiler_pause(void) {}
+static inline void sampling_profiler_resume(void) {}
+#endif
+
+#endif /* __ASSEMBLER__ */
+
+#endif /* __SAMPLING_PROFILER_H__ */
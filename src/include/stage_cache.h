@@ -12,6 +12,7 @@ enum {
 	STAGE_RAMSTAGE,
 	STAGE_REFCODE,
 	STAGE_POSTCAR,
+	STAGE_PAYLOAD,
 };
 
 /* Types of raw data that may be stored in stage cache */
@@ -38,6 +39,41 @@ static inline void stage_cache_get_raw(int stage_id, void **base, size_t *size)
 
 #endif
 
+/* A loaded range of a stage kept in the warm reboot stage cache. */
+struct warm_cache_segment {
+	uint64_t base;
+	uint32_t filesz;
+	uint32_t memsz;
+};
+
+#define WARM_CACHE_MAX_SEGMENTS	8
+
+#if CONFIG(WARM_REBOOT_STAGE_CACHE)
+/*
+ * Cache the segments of a stage that was just loaded from the CBFS file
+ * pointed to by stage. The entry point and argument are taken from stage.
+ */
+void warm_stage_cache_add(int stage_id, struct prog *stage,
+			  const struct warm_cache_segment *segs, size_t count);
+/*
+ * Look up a cached copy of the CBFS file pointed to by stage. Returns the
+ * number of segments and points segs at them, or 0 if there is no usable copy.
+ */
+size_t warm_stage_cache_find(int stage_id, struct prog *stage,
+			     const struct warm_cache_segment **segs);
+/*
+ * Restore the copy found by warm_stage_cache_find() and set the entry point
+ * and argument of stage. Returns 0 on success, < 0 if the copy is damaged.
+ */
+int warm_stage_cache_load(int stage_id, struct prog *stage);
+#else
+static inline void warm_stage_cache_add(int stage_id, struct prog *stage,
+			const struct warm_cache_segment *segs, size_t count) {}
+static inline size_t warm_stage_cache_find(int stage_id, struct prog *stage,
+			const struct warm_cache_segment **segs) { return 0; }
+static inline int warm_stage_cache_load(int stage_id, struct prog *stage) { return -1; }
+#endif
+
 /* Fill in parameters for the external stage cache, if utilized. */
 void stage_cache_external_region(void **base, size_t *size);
 
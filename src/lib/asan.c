@@ -13,6 +13,15 @@
 #include <arch/symbols.h>
 #include <asan.h>
 
+static __always_inline bool asan_is_tracked(unsigned long addr)
+{
+#if ENV_ROMSTAGE
+	return addr >= (uintptr_t)&_car_region_start && addr <= (uintptr_t)&_ebss;
+#elif ENV_RAMSTAGE
+	return addr >= (uintptr_t)&_data && addr <= (uintptr_t)&_eheap;
+#endif
+}
+
 static inline void *asan_mem_to_shadow(const void *addr)
 {
 #if ENV_ROMSTAGE
@@ -72,6 +81,10 @@ static __always_inline bool memory_is_poisoned_2_4_8(unsigned long addr,
 {
 	u8 *shadow_addr = (u8 *)asan_mem_to_shadow((void *)addr);
 
+	/* An aligned 8-byte access is covered by exactly one shadow byte. */
+	if (size == 8 && IS_ALIGNED(addr, ASAN_SHADOW_SCALE_SIZE))
+		return *shadow_addr;
+
 	if (unlikely(((addr + size - 1) & ASAN_SHADOW_MASK) < size - 1))
 		return *shadow_addr || memory_is_poisoned_1(addr + size - 1);
 
@@ -104,30 +117,40 @@ static __always_inline unsigned long bytes_is_nonzero(const u8 *start,
 static __always_inline unsigned long memory_is_nonzero(const void *start,
 						const void *end)
 {
-	unsigned int words;
+	const size_t word = sizeof(unsigned long);
+	const unsigned long *p;
 	unsigned long ret;
-	unsigned int prefix = (unsigned long)start % 8;
+	size_t blocks, words;
+	unsigned int prefix = (unsigned long)start % word;
 
 	if (end - start <= 16)
 		return bytes_is_nonzero(start, end - start);
 
 	if (prefix) {
-		prefix = 8 - prefix;
+		prefix = word - prefix;
 		ret = bytes_is_nonzero(start, prefix);
 		if (unlikely(ret))
 			return ret;
 		start += prefix;
 	}
 
-	words = (end - start) / 8;
-	while (words) {
-		if (unlikely(*(u64 *)start))
-			return bytes_is_nonzero(start, 8);
-		start += 8;
-		words--;
+	/*
+	 * Large ranges, like the ones memset() and memcpy() check, are mostly
+	 * unpoisoned. Test four words per branch and only look at the bytes
+	 * once a block turns out to be poisoned.
+	 */
+	p = start;
+	words = (end - start) / word;
+	for (blocks = words / 4; blocks; blocks--, p += 4) {
+		if (unlikely(p[0] | p[1] | p[2] | p[3]))
+			return bytes_is_nonzero((const u8 *)p, 4 * word);
+	}
+	for (words %= 4; words; words--, p++) {
+		if (unlikely(*p))
+			return bytes_is_nonzero((const u8 *)p, word);
 	}
 
-	return bytes_is_nonzero(start, (end - start) % 8);
+	return bytes_is_nonzero((const u8 *)p, (end - start) % word);
 }
 
 static __always_inline bool memory_is_poisoned_n(unsigned long addr,
@@ -236,15 +259,9 @@ static __always_inline void check_memory_region_inline(unsigned long addr,
 						size_t size, bool write,
 						unsigned long ret_ip)
 {
-#if ENV_ROMSTAGE
-	if (((uintptr_t)addr < (uintptr_t)&_car_region_start) ||
-		((uintptr_t)addr > (uintptr_t)&_ebss))
-		return;
-#elif ENV_RAMSTAGE
-	if (((uintptr_t)addr < (uintptr_t)&_data) ||
-		((uintptr_t)addr > (uintptr_t)&_eheap))
+	if (!asan_is_tracked(addr))
 		return;
-#endif
+
 	if (unlikely(size == 0))
 		return;
 
@@ -369,22 +386,22 @@ DEFINE_ASAN_LOAD_STORE(16);
 
 void __asan_loadN(unsigned long addr, size_t size)
 {
-	check_memory_region(addr, size, false, _RET_IP_);
+	check_memory_region_inline(addr, size, false, _RET_IP_);
 }
 
 void __asan_storeN(unsigned long addr, size_t size)
 {
-	check_memory_region(addr, size, true, _RET_IP_);
+	check_memory_region_inline(addr, size, true, _RET_IP_);
 }
 
 void __asan_loadN_noabort(unsigned long addr, size_t size)
 {
-	check_memory_region(addr, size, false, _RET_IP_);
+	check_memory_region_inline(addr, size, false, _RET_IP_);
 }
 
 void __asan_storeN_noabort(unsigned long addr, size_t size)
 {
-	check_memory_region(addr, size, true, _RET_IP_);
+	check_memory_region_inline(addr, size, true, _RET_IP_);
 }
 
 void __asan_handle_no_return(void)
@@ -79,6 +79,13 @@ void cbmem_initialize_empty_id_size(u32 id, u64 size)
 	if (size)
 		cbmem_add(id, size);
 
+	/*
+	 * The warm reboot stage cache has to land at the same address on every
+	 * boot for its contents to survive, so allocate it right away as well.
+	 */
+	if (CONFIG(WARM_REBOOT_STAGE_CACHE))
+		cbmem_add(CBMEM_ID_WARM_CACHE, CONFIG_WARM_REBOOT_STAGE_CACHE_SIZE);
+
 	/* Complete migration to CBMEM. */
 	cbmem_run_init_hooks(no_recovery);
 
@@ -113,6 +120,13 @@ int cbmem_initialize_id_size(u32 id, u64 size)
 	if (size)
 		cbmem_add(id, size);
 
+	/*
+	 * The warm reboot stage cache has to land at the same address on every
+	 * boot for its contents to survive, so allocate it right away as well.
+	 */
+	if (CONFIG(WARM_REBOOT_STAGE_CACHE))
+		cbmem_add(CBMEM_ID_WARM_CACHE, CONFIG_WARM_REBOOT_STAGE_CACHE_SIZE);
+
 	/* Complete migration to CBMEM. */
 	cbmem_run_init_hooks(recovery);
 
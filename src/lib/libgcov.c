@@ -25,8 +25,10 @@ permissions described in the GCC Runtime Library Exception, version
 #ifdef __COREBOOT__
 #include <stdlib.h>
 #include <string.h>
+#include <commonlib/coverage_serialized.h>
 #include <commonlib/helpers.h>
 #include <console/console.h>
+#include <timestamp.h>
 #include <assert.h>
 typedef s32 pid_t;
 #define gcc_assert(x) ASSERT(x)
@@ -724,6 +726,159 @@ read_fatal:;
 	}
 }
 
+#ifdef __COREBOOT__
+/* Streamed coverage: append the raw counters of every object file to
+   CBMEM and leave summaries and merging to `cbmem -C`.  */
+
+static size_t
+coverage_record_size(const struct gcov_info *gi_ptr)
+{
+	size_t size = sizeof(struct coverage_object)
+		+ coverage_filename_size(strlen(gi_ptr->filename));
+	unsigned int f_ix, t_ix;
+
+	for (f_ix = 0; f_ix != gi_ptr->n_functions; f_ix++) {
+		const struct gcov_fn_info *gfi_ptr = gi_ptr->functions[f_ix];
+		const struct gcov_ctr_info *ci_ptr;
+
+		size += sizeof(struct coverage_function);
+		if (!gfi_ptr || gfi_ptr->key != gi_ptr)
+			continue;
+
+		ci_ptr = gfi_ptr->ctrs;
+		for (t_ix = 0; t_ix != GCOV_COUNTERS; t_ix++) {
+			if (!gi_ptr->merge[t_ix])
+				continue;
+			size += sizeof(uint32_t)
+				+ ci_ptr->num * 2 * sizeof(uint32_t);
+			ci_ptr++;
+		}
+	}
+
+	return size;
+}
+
+static uint32_t *
+coverage_write_record(uint32_t *p, const struct gcov_info *gi_ptr,
+	size_t size)
+{
+	struct coverage_object *obj = (struct coverage_object *)p;
+	unsigned int f_ix, t_ix;
+
+	obj->length = size;
+	obj->stamp = gi_ptr->stamp;
+	obj->n_functions = gi_ptr->n_functions;
+	obj->counter_mask = 0;
+	for (t_ix = 0; t_ix != GCOV_COUNTERS; t_ix++)
+		if (gi_ptr->merge[t_ix])
+			obj->counter_mask |= 1 << t_ix;
+	obj->filename_size = coverage_filename_size(strlen(gi_ptr->filename));
+
+	p = (uint32_t *)&obj[1];
+	memset(p, 0, obj->filename_size);
+	strcpy((char *)p, gi_ptr->filename);
+	p += obj->filename_size / sizeof(*p);
+
+	for (f_ix = 0; f_ix != gi_ptr->n_functions; f_ix++) {
+		const struct gcov_fn_info *gfi_ptr = gi_ptr->functions[f_ix];
+		struct coverage_function *fn = (struct coverage_function *)p;
+		const struct gcov_ctr_info *ci_ptr;
+
+		p = (uint32_t *)&fn[1];
+		if (!gfi_ptr || gfi_ptr->key != gi_ptr) {
+			memset(fn, 0, sizeof(*fn));
+			continue;
+		}
+
+		fn->ident = gfi_ptr->ident;
+		fn->lineno_checksum = gfi_ptr->lineno_checksum;
+		fn->cfg_checksum = gfi_ptr->cfg_checksum;
+		fn->flags = COVERAGE_FUNCTION_PRESENT;
+
+		ci_ptr = gfi_ptr->ctrs;
+		for (t_ix = 0; t_ix != GCOV_COUNTERS; t_ix++) {
+			gcov_unsigned_t c_num;
+
+			if (!gi_ptr->merge[t_ix])
+				continue;
+
+			*p++ = ci_ptr->num;
+			for (c_num = 0; c_num < ci_ptr->num; c_num++) {
+				const uint64_t value = ci_ptr->values[c_num];
+
+				*p++ = (uint32_t)value;
+				*p++ = (uint32_t)(value >> 32);
+			}
+			ci_ptr++;
+		}
+	}
+
+	return p;
+}
+
+static void
+coverage_stream_exit(void)
+{
+	/* Set once the stream has been emptied for this boot.  */
+	static int stream_started;
+	const struct gcov_info *gi_ptr;
+	const struct cbmem_entry *entry;
+	struct coverage_stream *stream;
+	uint32_t boot_id = 0;
+	size_t size = 0;
+
+	for (gi_ptr = gcov_list; gi_ptr; gi_ptr = gi_ptr->next)
+		size += coverage_record_size(gi_ptr);
+
+	/* Later flushes of this boot append to the entry sized by the first
+	   one.  An entry kept in CBMEM across S3 resume holds the records of
+	   an earlier boot: start it over, at the size it already has.  */
+	entry = cbmem_entry_find(CBMEM_ID_COVERAGE);
+	if (!entry)
+		entry = cbmem_entry_add(CBMEM_ID_COVERAGE, sizeof(*stream) + size);
+	if (!entry || cbmem_entry_size(entry) < sizeof(*stream)) {
+		printk(BIOS_ERR, "Coverage: no room in CBMEM for %zu bytes\n",
+			size);
+		return;
+	}
+
+	stream = cbmem_entry_start(entry);
+	if (!stream_started) {
+		/* Mixing in the old value keeps the ID moving on resume.  */
+		if (stream->magic == COVERAGE_STREAM_MAGIC)
+			boot_id = stream->boot_id * 1103515245 + 12345;
+		memset(stream, 0, sizeof(*stream));
+		stream->magic = COVERAGE_STREAM_MAGIC;
+		stream->version = COVERAGE_STREAM_VERSION;
+		stream->gcov_version = GCOV_VERSION;
+		stream->boot_id = boot_id + (uint32_t)timestamp_get();
+		stream->size = cbmem_entry_size(entry) - sizeof(*stream);
+		stream_started = 1;
+	} else if (stream->magic != COVERAGE_STREAM_MAGIC) {
+		printk(BIOS_ERR, "Coverage: CBMEM entry is not a stream\n");
+		return;
+	}
+
+	for (gi_ptr = gcov_list; gi_ptr; gi_ptr = gi_ptr->next) {
+		const size_t rsize = coverage_record_size(gi_ptr);
+		uint32_t *p = (uint32_t *)((uint8_t *)stream->records
+			+ stream->used);
+
+		if (rsize > stream->size - stream->used) {
+			stream->dropped++;
+			continue;
+		}
+		coverage_write_record(p, gi_ptr, rsize);
+		stream->used += rsize;
+	}
+
+#if CONFIG(DEBUG_COVERAGE)
+	printk(BIOS_DEBUG, "Coverage: streamed %u bytes, %u objects dropped\n",
+		stream->used, stream->dropped);
+#endif
+}
+#endif /* __COREBOOT__ */
+
 /* Add a new object file onto the bb chain.  Invoked automatically
    when running an object file's global ctors.  */
 
@@ -759,7 +914,12 @@ __gcov_flush(void)
 {
 	const struct gcov_info *gi_ptr;
 
-	gcov_exit();
+#ifdef __COREBOOT__
+	if (CONFIG(COVERAGE_STREAM))
+		coverage_stream_exit();
+	else
+#endif
+		gcov_exit();
 	for (gi_ptr = gcov_list; gi_ptr; gi_ptr = gi_ptr->next) {
 		unsigned int f_ix;
 
@@ -103,6 +103,50 @@ static int load_relocatable_ramstage(struct prog *ramstage)
 	return rmodule_stage_load(&rmod_ram);
 }
 
+/*
+ * On x86 the ramstage lives in the CBMEM_ID_RAMSTAGE entry, which has to be
+ * allocated at the address the cached copy was taken from.
+ */
+static int load_ramstage_from_warm_cache(struct prog *ramstage)
+{
+	const struct warm_cache_segment *segs;
+	const struct cbmem_entry *e;
+
+	if (!warm_stage_cache_find(STAGE_RAMSTAGE, ramstage, &segs))
+		return -1;
+
+	if (ENV_X86) {
+		e = cbmem_entry_add(CBMEM_ID_RAMSTAGE, segs[0].memsz);
+		if (e == NULL || (uintptr_t)cbmem_entry_start(e) != segs[0].base) {
+			if (e != NULL)
+				cbmem_entry_remove(e);
+			return -1;
+		}
+	}
+
+	return warm_stage_cache_load(STAGE_RAMSTAGE, ramstage);
+}
+
+static void warm_cache_add_ramstage(struct prog *ramstage)
+{
+	struct warm_cache_segment seg = {
+		.base = (uintptr_t)prog_start(ramstage),
+		.filesz = prog_size(ramstage),
+		.memsz = prog_size(ramstage),
+	};
+	const struct cbmem_entry *e;
+
+	if (ENV_X86) {
+		e = cbmem_entry_find(CBMEM_ID_RAMSTAGE);
+		if (e == NULL)
+			return;
+		seg.base = (uintptr_t)cbmem_entry_start(e);
+		seg.filesz = seg.memsz = cbmem_entry_size(e);
+	}
+
+	warm_stage_cache_add(STAGE_RAMSTAGE, ramstage, &seg, 1);
+}
+
 void run_ramstage(void)
 {
 	struct prog ramstage =
@@ -129,6 +173,10 @@ void run_ramstage(void)
 
 	timestamp_add_now(TS_START_COPYRAM);
 
+	if (CONFIG(WARM_REBOOT_STAGE_CACHE) &&
+	    !load_ramstage_from_warm_cache(&ramstage))
+		goto loaded;
+
 	if (ENV_X86) {
 		if (load_relocatable_ramstage(&ramstage))
 			goto fail;
@@ -137,6 +185,10 @@ void run_ramstage(void)
 			goto fail;
 	}
 
+	if (CONFIG(WARM_REBOOT_STAGE_CACHE))
+		warm_cache_add_ramstage(&ramstage);
+
+loaded:
 	stage_cache_add(STAGE_RAMSTAGE, &ramstage);
 
 	timestamp_add_now(TS_END_COPYRAM);
@@ -157,6 +209,30 @@ fail:
 static struct prog global_payload =
 	PROG_INIT(PROG_PAYLOAD, CONFIG_CBFS_PREFIX "/payload");
 
+static int load_payload_from_warm_cache(struct prog *payload)
+{
+	const struct warm_cache_segment *segs;
+	size_t count;
+
+	count = warm_stage_cache_find(STAGE_PAYLOAD, payload, &segs);
+	if (!count)
+		return -1;
+
+	/* The memory map may differ from the boot the copy was taken on. */
+	for (size_t i = 0; i < count; i++) {
+		if (!bootmem_region_targets_type(segs[i].base, segs[i].memsz, BM_MEM_RAM))
+			return -1;
+	}
+
+	if (warm_stage_cache_load(STAGE_PAYLOAD, payload))
+		return -1;
+
+	/* The coreboot tables move around, pass the current ones. */
+	prog_set_arg(payload, cbmem_find(CBMEM_ID_CBTABLE));
+
+	return 0;
+}
+
 void payload_load(void)
 {
 	struct prog *payload = &global_payload;
@@ -166,6 +242,10 @@ void payload_load(void)
 	if (prog_locate(payload))
 		goto out;
 
+	if (CONFIG(WARM_REBOOT_STAGE_CACHE) && prog_cbfs_type(payload) == CBFS_TYPE_SELF &&
+	    !load_payload_from_warm_cache(payload))
+		goto out;
+
 	switch (prog_cbfs_type(payload)) {
 	case CBFS_TYPE_SELF: /* Simple ELF */
 		selfload_check(payload, BM_MEM_RAM);
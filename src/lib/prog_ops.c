@@ -1,6 +1,8 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
 #include <program_loading.h>
+#include <sampling_profiler.h>
+#include <security/tpm/tspi.h>
 
 /* For each segment of a program loaded this function is called*/
 void prog_segment_loaded(uintptr_t start, size_t size, int flags)
@@ -23,6 +25,8 @@ void __weak arch_segment_loaded(uintptr_t start, size_t size,
 
 void prog_run(struct prog *prog)
 {
+	sampling_profiler_stop();
+	tpm_flush_pcr_extends();
 	platform_prog_run(prog);
 	arch_prog_run(prog);
 }
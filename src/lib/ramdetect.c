@@ -2,12 +2,41 @@
 
 #include <types.h>
 #include <symbols.h>
+#include <cbmem.h>
 #include <device/mmio.h>
 #include <ramdetect.h>
 #include <console/console.h>
+#if ENV_ARM64 || ENV_ARMV7
+#include <arch/cache.h>
+#endif
 
 #define OVERLAP(a, b, s, e) ((b) > (s) && (a) < (e))
 
+/*
+ * The size found in one probe window. It's handed on to later stages in
+ * CBMEM, which only take it for the same window.
+ */
+struct ramdetect_result {
+	uint64_t dram_start;
+	uint64_t probe_size;
+	uint64_t size;
+};
+
+static struct ramdetect_result saved_result;
+
+static int result_matches(const struct ramdetect_result *result,
+			  const uintptr_t dram_start, const size_t probe_size)
+{
+	return result->size && result->dram_start == dram_start &&
+		result->probe_size == probe_size;
+}
+
+static int clobbers_program(uintptr_t addr)
+{
+	return OVERLAP(addr, addr + sizeof(uint32_t), (uintptr_t)_program,
+		       (uintptr_t)_eprogram);
+}
+
 int __weak probe_mb(const uintptr_t dram_start, const uintptr_t size)
 {
 	uintptr_t addr = dram_start + (size * MiB) - sizeof(uint32_t);
@@ -19,7 +48,7 @@ int __weak probe_mb(const uintptr_t dram_start, const uintptr_t size)
 	size_t i;
 
 	/* Don't accidentally clober oneself. */
-	if (OVERLAP(addr, addr + sizeof(uint32_t), (uintptr_t)_program, (uintptr_t) _eprogram))
+	if (clobbers_program(addr))
 		return 1;
 
 	uint32_t old = read32(ptr);
@@ -33,6 +62,44 @@ int __weak probe_mb(const uintptr_t dram_start, const uintptr_t size)
 	return i == ARRAY_SIZE(patterns);
 }
 
+/* Write a word and make sure it reached the memory behind the caches. */
+static void write32_flush(void *ptr, uint32_t value)
+{
+	write32(ptr, value);
+#if ENV_ARM64 || ENV_ARMV7
+	dcache_clean_invalidate_by_mva(ptr, sizeof(uint32_t));
+#endif
+}
+
+/*
+ * Memory controllers that don't decode the upper address bits repeat the
+ * RAM in the address space above it. The word at the probed address then
+ * is the same as the one at a lower address, which is modified along.
+ * Writes go through to memory before the lower address is read back, or
+ * both might be served from different cache lines.
+ */
+static int probe_alias(const uintptr_t addr, const uintptr_t lower)
+{
+	void *ptr = (void *)addr;
+	void *lower_ptr = (void *)lower;
+	uint32_t old, old_lower;
+	int alias;
+
+	if (clobbers_program(addr) || clobbers_program(lower))
+		return 0;
+
+	old = read32(ptr);
+	old_lower = read32(lower_ptr);
+
+	write32_flush(lower_ptr, 0xa55aa55a);
+	write32_flush(ptr, 0x5aa55aa5);
+	alias = read32(lower_ptr) != 0xa55aa55a;
+
+	write32_flush(ptr, old);
+	write32_flush(lower_ptr, old_lower);
+	return alias;
+}
+
 /* - 20 as probe_size is in MiB, - 1 as i is signed */
 #define MAX_ADDRESSABLE_SPACE (sizeof(size_t) * 8 - 20 - 1)
 
@@ -42,10 +109,21 @@ size_t probe_ramsize(const uintptr_t dram_start, const size_t probe_size)
 	ssize_t i;
 	size_t msb = 0;
 	size_t discovered = 0;
+	size_t probe, below, top = 0;
+	unsigned int probes = 0;
+	const struct ramdetect_result *cached;
 
-	static size_t saved_result;
-	if (saved_result)
-		return saved_result;
+	if (result_matches(&saved_result, dram_start, probe_size))
+		return saved_result.size;
+
+	/* A previous stage already did the work. */
+	if (cbmem_online()) {
+		cached = cbmem_find(CBMEM_ID_RAMDETECT);
+		if (cached && result_matches(cached, dram_start, probe_size)) {
+			saved_result = *cached;
+			return saved_result.size;
+		}
+	}
 
 	/* Find the MSB + 1. */
 	size_t tmp = probe_size;
@@ -57,11 +135,46 @@ size_t probe_ramsize(const uintptr_t dram_start, const size_t probe_size)
 	msb = MIN(msb, MAX_ADDRESSABLE_SPACE);
 
 	/* Compact binary search.  */
-	for (i = msb; i >= 0; i--)
-		if (probe_mb(dram_start, (discovered | (1ULL << i))))
-			discovered |= (1ULL << i);
+	for (i = msb; i >= 0; i--) {
+		probe = discovered | (1ULL << i);
+		probes++;
+		if (!probe_mb(dram_start, probe))
+			continue;
+
+		/*
+		 * RAM repeating every 'top' MiB maps the probed word onto the one
+		 * 'top' below it. For the first hit, a repetition every half of
+		 * it or less is checked the same way.
+		 */
+		below = discovered ? probe - top : probe / 2;
+		if (below && probe_alias(dram_start + probe * MiB - sizeof(uint32_t),
+					 dram_start + below * MiB - sizeof(uint32_t)))
+			continue;
+
+		if (!discovered)
+			top = probe;
+		discovered = probe;
+	}
 
-	saved_result = discovered;
-	printk(BIOS_DEBUG, "RAMDETECT: Found %zu MiB RAM\n", discovered);
+	saved_result.dram_start = dram_start;
+	saved_result.probe_size = probe_size;
+	saved_result.size = discovered;
+	printk(BIOS_DEBUG, "RAMDETECT: Found %zu MiB RAM in %u probes\n",
+	       discovered, probes);
 	return discovered;
 }
+
+/* Later stages find the size in CBMEM instead of probing again. */
+static void ramdetect_save(int is_recovery)
+{
+	struct ramdetect_result *cached;
+
+	if (!saved_result.size)
+		return;
+
+	cached = cbmem_add(CBMEM_ID_RAMDETECT, sizeof(*cached));
+	if (cached)
+		*cached = saved_result;
+}
+
+ROMSTAGE_CBMEM_INIT_HOOK(ramdetect_save)
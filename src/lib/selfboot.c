@@ -11,6 +11,7 @@
 #include <lib.h>
 #include <bootmem.h>
 #include <program_loading.h>
+#include <stage_cache.h>
 #include <timestamp.h>
 #include <cbmem.h>
 
@@ -46,6 +47,21 @@ static int segment_targets_type(void *dest, unsigned long memsz,
 	return 0;
 }
 
+/* Segments of the payload being loaded, for the warm reboot stage cache. */
+static struct warm_cache_segment loaded_segs[WARM_CACHE_MAX_SEGMENTS];
+static size_t num_loaded_segs;
+
+static void record_segment(uint8_t *dest, size_t len, size_t memsz)
+{
+	if (num_loaded_segs < ARRAY_SIZE(loaded_segs)) {
+		loaded_segs[num_loaded_segs].base = (uintptr_t)dest;
+		loaded_segs[num_loaded_segs].filesz = len;
+		loaded_segs[num_loaded_segs].memsz = memsz;
+	}
+	/* Count past the end so that the caller notices it did not fit. */
+	num_loaded_segs++;
+}
+
 static int load_one_segment(uint8_t *dest,
 			    uint8_t *src,
 			    size_t len,
@@ -91,6 +107,8 @@ static int load_one_segment(uint8_t *dest,
 		}
 		/* Calculate middle after any changes to len. */
 		middle = dest + len;
+		if (CONFIG(WARM_REBOOT_STAGE_CACHE))
+			record_segment(dest, len, memsz);
 		printk(BIOS_SPEW, "[ 0x%08lx, %08lx, 0x%08lx) <- %08lx\n",
 			(unsigned long)dest,
 			(unsigned long)middle,
@@ -105,7 +123,7 @@ static int load_one_segment(uint8_t *dest,
 				(unsigned long)(end - middle));
 
 			/* Zero the extra bytes */
-			memset(middle, 0, end - middle);
+			payload_arch_clear_segment(middle, end - middle);
 		}
 
 		/*
@@ -225,6 +243,11 @@ __weak int payload_arch_usable_ram_quirk(uint64_t start, uint64_t size)
 	return 0;
 }
 
+__weak void payload_arch_clear_segment(void *start, size_t size)
+{
+	memset(start, 0, size);
+}
+
 static void *selfprepare(struct prog *payload)
 {
 	void *data;
@@ -247,6 +270,7 @@ static bool _selfload(struct prog *payload, checker_t f, void *args)
 	if (f && f(cbfssegs, args))
 		goto out;
 
+	num_loaded_segs = 0;
 	if (load_payload_segments(cbfssegs, &entry))
 		goto out;
 
@@ -257,6 +281,10 @@ static bool _selfload(struct prog *payload, checker_t f, void *args)
 	/* Pass cbtables to payload if architecture desires it. */
 	prog_set_entry(payload, (void *)entry, cbmem_find(CBMEM_ID_CBTABLE));
 
+	if (CONFIG(WARM_REBOOT_STAGE_CACHE) && prog_type(payload) == PROG_PAYLOAD &&
+	    num_loaded_segs <= ARRAY_SIZE(loaded_segs))
+		warm_stage_cache_add(STAGE_PAYLOAD, payload, loaded_segs, num_loaded_segs);
+
 	return true;
 out:
 	rdev_munmap(prog_rdev(payload), data);
@@ -234,8 +234,12 @@ static void timestamp_reinit(int is_recovery)
 		timestamp_sync_cache_to_cbmem(ts_cbmem_table);
 
 	/* Seed the timestamp tick frequency in ENV_PAYLOAD_LOADER. */
-	if (ENV_PAYLOAD_LOADER)
+	if (ENV_PAYLOAD_LOADER) {
 		ts_cbmem_table->tick_freq_mhz = timestamp_tick_freq_mhz();
+		if (CONFIG(TIMESTAMPS_ON_CONSOLE))
+			printk(BIOS_INFO, "Timestamp - tick frequency: %u MHz\n",
+			       ts_cbmem_table->tick_freq_mhz);
+	}
 
 	timestamp_table_set(ts_cbmem_table);
 }
@@ -1,16 +1,99 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
+#include <cbmem.h>
+#include <commonlib/trace_serialized.h>
 #include <console/console.h>
+#include <string.h>
+#include <timestamp.h>
 #include <trace.h>
+#if ENV_X86
+#include <arch/cpu.h>
+#include <cpu/x86/tsc.h>
+#endif
 
 int volatile trace_dis = 0;
 
+static struct trace_buffer *trace_buf;
+
+#if CONFIG(TRACE_BINARY)
+/* trace_record() divides by records_per_cpu. */
+_Static_assert(CONFIG_TRACE_BUFFER_SIZE >= sizeof(struct trace_buffer) +
+	       CONFIG_MAX_CPUS * (sizeof(struct trace_ring) + sizeof(struct trace_record)),
+	       "TRACE_BUFFER_SIZE must hold at least one record per CPU");
+
+static void trace_buffer_init(int is_recovery)
+{
+	struct trace_buffer *buf;
+	const size_t rings = CONFIG_MAX_CPUS * sizeof(struct trace_ring);
+
+	buf = cbmem_add(CBMEM_ID_TRACE, CONFIG_TRACE_BUFFER_SIZE);
+	if (buf == NULL) {
+		printk(BIOS_ERR, "Could not allocate the function trace buffer.\n");
+		return;
+	}
+
+	memset(buf, 0, sizeof(*buf) + rings);
+	buf->magic = TRACE_BUFFER_MAGIC;
+	buf->version = TRACE_BUFFER_VERSION;
+	buf->num_cpus = CONFIG_MAX_CPUS;
+	buf->records_per_cpu = (CONFIG_TRACE_BUFFER_SIZE - sizeof(*buf) - rings) /
+		(CONFIG_MAX_CPUS * sizeof(struct trace_record));
+	buf->tick_freq_mhz = timestamp_tick_freq_mhz();
+
+	trace_buf = buf;
+}
+RAMSTAGE_CBMEM_INIT_HOOK(trace_buffer_init)
+#endif
+
+static inline __attribute__((no_instrument_function))
+void trace_record(void *func, void *callsite, uint32_t flags)
+{
+	struct trace_buffer *buf = trace_buf;
+	struct trace_record *rec;
+	struct trace_ring *ring;
+	unsigned int cpu = 0;
+
+	if (buf == NULL)
+		return;
+
+#if ENV_X86
+	cpu = cpu_info()->index;
+	if (cpu >= CONFIG_MAX_CPUS)
+		return;
+#endif
+
+	ring = &buf->rings[cpu];
+	/* Drop calls made while recording, e.g. by a non-inline timestamp_get(). */
+	if (ring->busy)
+		return;
+	ring->busy = 1;
+
+	rec = trace_buffer_records(buf, cpu) + ring->count % buf->records_per_cpu;
+#if ENV_X86
+	rec->tsc = rdtscll();
+#else
+	rec->tsc = timestamp_get();
+#endif
+	rec->func = (uintptr_t)func;
+	rec->callsite = (uintptr_t)callsite;
+	rec->flags = flags;
+	rec->cpu = cpu;
+	ring->count++;
+
+	ring->busy = 0;
+}
+
 void __cyg_profile_func_enter(void *func, void *callsite)
 {
 
 	if (trace_dis)
 		return;
 
+	if (CONFIG(TRACE_BINARY)) {
+		trace_record(func, callsite, 0);
+		return;
+	}
+
 	DISABLE_TRACE
 	printk(BIOS_INFO, "~%p(%p)\n", func, callsite);
 	ENABLE_TRACE
@@ -18,4 +101,6 @@ void __cyg_profile_func_enter(void *func, void *callsite)
 
 void __cyg_profile_func_exit(void *func, void *callsite)
 {
+	if (CONFIG(TRACE_BINARY) && !trace_dis)
+		trace_record(func, callsite, TRACE_RECORD_EXIT);
 }
@@ -0,0 +1,314 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <cbfs.h>
+#include <cbmem.h>
+#include <console/console.h>
+#include <stage_cache.h>
+#include <stdbool.h>
+#include <string.h>
+#include <timestamp.h>
+#include <version.h>
+
+/*
+ * Warm reboot stage cache. The CBMEM_ID_WARM_CACHE entry is allocated first
+ * when CBMEM is created, so it sits at the same address on every boot and its
+ * contents survive a warm reset. It holds a header followed by the loaded
+ * segments of each cached stage.
+ *
+ * A cached stage is only used when the fingerprint of its CBFS file matches
+ * the one taken when the copy was stored, and the data hash, seeded with the
+ * nonce of the current cache generation, is intact. The fingerprint is built
+ * from the file metadata and the build identity only, so a warm boot reads no
+ * file data from the boot media. A reflash that keeps the build identity, the
+ * file layout and the metadata but changes the file contents goes unnoticed
+ * unless the files carry a hash attribute (cbfstool add -A sha256). The hashes
+ * only catch stale or corrupted copies: the OS can rewrite the cache along
+ * with its hashes, which is why the option is not available with verified or
+ * measured boot.
+ */
+
+#define WARM_CACHE_MAGIC	0x4d524157	/* "WARM" */
+#define WARM_CACHE_VERSION	3
+#define WARM_CACHE_MAX_ENTRIES	4
+
+struct warm_cache_entry {
+	uint32_t stage_id;
+	uint32_t num_segs;
+	uint64_t fingerprint;
+	uint64_t entry_addr;
+	uint64_t arg;
+	/* Offset of the segment data from the start of the cache. */
+	uint32_t offset;
+	uint32_t size;
+	uint64_t hash;
+	struct warm_cache_segment segs[WARM_CACHE_MAX_SEGMENTS];
+};
+
+struct warm_cache_header {
+	uint32_t magic;
+	uint32_t version;
+	/* Changed every time the cache is emptied. Seeds all hashes. */
+	uint32_t nonce;
+	/* Number of boots that reused the cached ramstage. */
+	uint32_t boot_count;
+	uint32_t used;
+	uint32_t num_entries;
+	struct warm_cache_entry entries[WARM_CACHE_MAX_ENTRIES];
+	/* Hash of all the fields above. */
+	uint64_t hash;
+};
+
+/* FNV-1a, one 64-bit word at a time. */
+static uint64_t warm_cache_hash(uint64_t seed, const void *data, size_t size)
+{
+	const uint8_t *p = data;
+	uint64_t h = seed ^ 0xcbf29ce484222325ULL;
+	uint64_t v;
+
+	for (; size >= sizeof(v); size -= sizeof(v), p += sizeof(v)) {
+		memcpy(&v, p, sizeof(v));
+		h = (h ^ v) * 0x100000001b3ULL;
+	}
+	while (size--)
+		h = (h ^ *p++) * 0x100000001b3ULL;
+
+	return h;
+}
+
+static uint64_t header_hash(const struct warm_cache_header *hdr)
+{
+	return warm_cache_hash(hdr->nonce, hdr, offsetof(struct warm_cache_header, hash));
+}
+
+/*
+ * Fingerprint of the CBFS file a stage is loaded from. It covers the build
+ * identity of the running stage, which comes from the same image, the location
+ * and size of the file data on the boot media, and the file metadata: header,
+ * name and attributes, including the compression and hash attributes when
+ * cbfstool added them. Only the metadata is read. Returns 0 on success.
+ */
+static int stage_fingerprint(struct prog *stage, uint64_t *fingerprint)
+{
+	const struct region_device *rdev = prog_rdev(stage);
+	struct cbfsf file;
+	uint64_t where[2];
+	void *metadata;
+	uint64_t h;
+
+	if (cbfs_boot_locate(&file, prog_name(stage), NULL))
+		return -1;
+
+	/* The stage must have come from the file that was just located. */
+	if (region_device_offset(&file.data) != region_device_offset(rdev) ||
+	    region_device_sz(&file.data) != region_device_sz(rdev))
+		return -1;
+
+	metadata = rdev_mmap_full(&file.metadata);
+	if (metadata == NULL)
+		return -1;
+
+	h = warm_cache_hash(0, coreboot_build, strlen(coreboot_build));
+	h = warm_cache_hash(h, coreboot_compile_time, strlen(coreboot_compile_time));
+	where[0] = region_device_offset(rdev);
+	where[1] = region_device_sz(rdev);
+	h = warm_cache_hash(h, where, sizeof(where));
+	h = warm_cache_hash(h, metadata, region_device_sz(&file.metadata));
+
+	rdev_munmap(&file.metadata, metadata);
+
+	*fingerprint = h;
+	return 0;
+}
+
+static struct warm_cache_header *warm_cache_header(size_t *size)
+{
+	const struct cbmem_entry *e = cbmem_entry_find(CBMEM_ID_WARM_CACHE);
+
+	if (e == NULL || cbmem_entry_size(e) < sizeof(struct warm_cache_header))
+		return NULL;
+
+	*size = cbmem_entry_size(e);
+	return cbmem_entry_start(e);
+}
+
+static bool header_valid(const struct warm_cache_header *hdr, size_t size)
+{
+	return hdr->magic == WARM_CACHE_MAGIC && hdr->version == WARM_CACHE_VERSION &&
+	       hdr->used >= sizeof(*hdr) && hdr->used <= size &&
+	       hdr->num_entries <= WARM_CACHE_MAX_ENTRIES && hdr->hash == header_hash(hdr);
+}
+
+static void header_reset(struct warm_cache_header *hdr)
+{
+	/* Mixing in the old value keeps the nonce moving even without timestamps. */
+	const uint32_t nonce = hdr->nonce * 1103515245 + 12345 + timestamp_get();
+
+	memset(hdr, 0, sizeof(*hdr));
+	hdr->magic = WARM_CACHE_MAGIC;
+	hdr->version = WARM_CACHE_VERSION;
+	hdr->nonce = nonce;
+	hdr->used = sizeof(*hdr);
+}
+
+static struct warm_cache_entry *lookup(struct warm_cache_header *hdr, int stage_id)
+{
+	for (size_t i = 0; i < hdr->num_entries; i++) {
+		if (hdr->entries[i].stage_id == (uint32_t)stage_id)
+			return &hdr->entries[i];
+	}
+
+	return NULL;
+}
+
+static struct warm_cache_entry *find_entry(int stage_id, struct prog *stage,
+					   struct warm_cache_header **out)
+{
+	uint64_t fingerprint;
+	struct warm_cache_header *hdr;
+	struct warm_cache_entry *entry;
+	size_t size;
+
+	hdr = warm_cache_header(&size);
+	if (hdr == NULL || !header_valid(hdr, size))
+		return NULL;
+
+	if (hdr->boot_count >= CONFIG_WARM_REBOOT_STAGE_CACHE_MAX_REUSE)
+		return NULL;
+
+	entry = lookup(hdr, stage_id);
+	if (entry == NULL || entry->num_segs > WARM_CACHE_MAX_SEGMENTS ||
+	    entry->offset < sizeof(*hdr) || entry->offset > hdr->used ||
+	    entry->size > hdr->used - entry->offset)
+		return NULL;
+
+	if (stage_fingerprint(stage, &fingerprint) || entry->fingerprint != fingerprint)
+		return NULL;
+
+	*out = hdr;
+	return entry;
+}
+
+void warm_stage_cache_add(int stage_id, struct prog *stage,
+			  const struct warm_cache_segment *segs, size_t count)
+{
+	uint64_t fingerprint;
+	struct warm_cache_header *hdr;
+	struct warm_cache_entry *entry;
+	uint8_t *data;
+	size_t size, total = 0;
+
+	hdr = warm_cache_header(&size);
+	if (hdr == NULL)
+		return;
+
+	if (stage_fingerprint(stage, &fingerprint)) {
+		printk(BIOS_ERR, "Warm stage cache: could not fingerprint stage %d\n", stage_id);
+		return;
+	}
+
+	if (!header_valid(hdr, size) ||
+	    hdr->boot_count >= CONFIG_WARM_REBOOT_STAGE_CACHE_MAX_REUSE)
+		header_reset(hdr);
+
+	/* Drop the old copy of this stage and everything stored after it. */
+	entry = lookup(hdr, stage_id);
+	if (entry != NULL) {
+		hdr->used = entry->offset;
+		hdr->num_entries = entry - hdr->entries;
+	}
+
+	for (size_t i = 0; i < count; i++)
+		total += segs[i].filesz;
+
+	if (count > WARM_CACHE_MAX_SEGMENTS || hdr->num_entries == WARM_CACHE_MAX_ENTRIES ||
+	    total > size - hdr->used) {
+		printk(BIOS_DEBUG, "Warm stage cache: no room for stage %d\n", stage_id);
+		hdr->hash = header_hash(hdr);
+		return;
+	}
+
+	entry = &hdr->entries[hdr->num_entries];
+	memset(entry, 0, sizeof(*entry));
+	entry->stage_id = stage_id;
+	entry->num_segs = count;
+	entry->fingerprint = fingerprint;
+	entry->entry_addr = (uintptr_t)prog_entry(stage);
+	entry->arg = (uintptr_t)prog_entry_arg(stage);
+	entry->offset = hdr->used;
+	entry->size = total;
+	memcpy(entry->segs, segs, count * sizeof(*segs));
+
+	data = (uint8_t *)hdr + entry->offset;
+	for (size_t i = 0; i < count; i++) {
+		memcpy(data, (void *)(uintptr_t)segs[i].base, segs[i].filesz);
+		data += segs[i].filesz;
+	}
+	entry->hash = warm_cache_hash(hdr->nonce, (uint8_t *)hdr + entry->offset, total);
+
+	hdr->used += total;
+	hdr->num_entries++;
+	hdr->hash = header_hash(hdr);
+
+	printk(BIOS_DEBUG, "Warm stage cache: stored stage %d, %zu bytes\n", stage_id, total);
+}
+
+size_t warm_stage_cache_find(int stage_id, struct prog *stage,
+			     const struct warm_cache_segment **segs)
+{
+	struct warm_cache_header *hdr;
+	struct warm_cache_entry *entry;
+
+	entry = find_entry(stage_id, stage, &hdr);
+	if (entry == NULL)
+		return 0;
+
+	*segs = entry->segs;
+	return entry->num_segs;
+}
+
+int warm_stage_cache_load(int stage_id, struct prog *stage)
+{
+	struct warm_cache_header *hdr;
+	struct warm_cache_entry *entry;
+	const uint8_t *data;
+
+	entry = find_entry(stage_id, stage, &hdr);
+	if (entry == NULL || entry->num_segs == 0)
+		return -1;
+
+	data = (uint8_t *)hdr + entry->offset;
+	if (entry->hash != warm_cache_hash(hdr->nonce, data, entry->size)) {
+		printk(BIOS_ERR, "Warm stage cache: stage %d is corrupted\n", stage_id);
+		/* Force a refill on this boot. */
+		hdr->magic = 0;
+		return -1;
+	}
+
+	for (size_t i = 0; i < entry->num_segs; i++) {
+		const struct warm_cache_segment *seg = &entry->segs[i];
+		uint8_t *dest = (void *)(uintptr_t)seg->base;
+
+		memcpy(dest, data, seg->filesz);
+		if (seg->memsz > seg->filesz)
+			memset(dest + seg->filesz, 0, seg->memsz - seg->filesz);
+		data += seg->filesz;
+
+		prog_segment_loaded(seg->base, seg->memsz,
+				    i + 1 == entry->num_segs ? SEG_FINAL : 0);
+	}
+
+	prog_set_area(stage, (void *)(uintptr_t)entry->segs[0].base, entry->segs[0].memsz);
+	prog_set_entry(stage, (void *)(uintptr_t)entry->entry_addr,
+		       (void *)(uintptr_t)entry->arg);
+
+	/* The ramstage is the first stage loaded on every boot. */
+	if (stage_id == STAGE_RAMSTAGE) {
+		hdr->boot_count++;
+		hdr->hash = header_hash(hdr);
+	}
+
+	printk(BIOS_DEBUG, "Warm stage cache: restored stage %d, %u bytes\n", stage_id,
+	       entry->size);
+
+	return 0;
+}
@@ -9,6 +9,7 @@ extern u8 _secram[], _esecram[];
 void bootblock_mainboard_init(void)
 {
 	mmu_init();
+	mmu_config_begin();
 
 	/* Everything below DRAM is device memory */
 	mmu_config_range((void *)0, (uintptr_t)_dram, MA_DEV | MA_RW);
@@ -22,5 +23,6 @@ void bootblock_mainboard_init(void)
 
 	mmu_config_range(_secram, REGION_SIZE(secram), MA_MEM | MA_S | MA_RW);
 
+	mmu_config_commit();
 	mmu_enable();
 }
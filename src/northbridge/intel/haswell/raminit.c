@@ -14,6 +14,7 @@
 #include <device/dram/ddr3.h>
 #include <smbios.h>
 #include <spd.h>
+#include <security/tpm/tspi.h>
 #include <security/vboot/vboot_common.h>
 #include <commonlib/region.h>
 #include "raminit.h"
@@ -140,6 +141,7 @@ void sdram_initialize(struct pei_data *pei_data)
 	entry = (unsigned long)rdev_mmap_full(&f.data);
 	if (entry) {
 		int rv;
+		tpm_flush_pcr_extends();
 		asm volatile ("call *%%ecx\n\t"
 			      :"=a" (rv) : "c" (entry), "a" (pei_data));
 
@@ -21,6 +21,7 @@
 #include "pei_data.h"
 #include "sandybridge.h"
 #include "chip.h"
+#include <security/tpm/tspi.h>
 #include <security/vboot/vboot_common.h>
 #include <southbridge/intel/bd82x6x/pch.h>
 
@@ -153,6 +154,7 @@ void sdram_initialize(struct pei_data *pei_data)
 	entry = cbfs_boot_map_with_leak("mrc.bin", CBFS_TYPE_MRC, NULL);
 	if (entry) {
 		int rv;
+		tpm_flush_pcr_extends();
 		rv = entry (pei_data);
 		if (rv) {
 			switch (rv) {
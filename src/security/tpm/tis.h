@@ -75,6 +75,20 @@ int tis_close(void);
 int tis_sendrecv(const u8 *sendbuf, size_t send_size, u8 *recvbuf,
 			size_t *recv_len);
 
+/*
+ * tis_send(), tis_response_ready() and tis_recv()
+ *
+ * The two halves of tis_sendrecv(), for drivers that select TPM_TIS_ASYNC.
+ * The TPM executes the command after tis_send() returns, and tis_recv()
+ * waits for the response. tis_response_ready() returns 1 once tis_recv()
+ * will not have to wait, 0 before that.
+ *
+ * tis_send() and tis_recv() return 0 on success or -1 on failure.
+ */
+int tis_send(const u8 *sendbuf, size_t send_size);
+int tis_response_ready(void);
+int tis_recv(u8 *recvbuf, size_t *recv_len);
+
 /*
  * tis_plat_irq_status()
  *
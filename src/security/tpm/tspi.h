@@ -55,6 +55,18 @@ uint32_t tpm_extend_pcr(int pcr, enum vb2_hash_algorithm digest_algo,
 			uint8_t *digest, size_t digest_len,
 			const char *name);
 
+/**
+ * Wait for all PCR extends queued by tpm_extend_pcr() to be done. Dies if
+ * one of them failed. Called before any measured code runs, be it the next
+ * stage, the OS or a blob like FSP or an option ROM called from this stage,
+ * so that the digests are in the PCRs and no TPM command is in flight then.
+ */
+#if CONFIG(TPM_MEASURED_BOOT_QUEUE) && !ENV_DECOMPRESSOR && !ENV_SMM
+void tpm_flush_pcr_extends(void);
+#else
+static inline void tpm_flush_pcr_extends(void) {}
+#endif
+
 /**
  * Issue a TPM_Clear and reenable/reactivate the TPM.
  * @return TPM_SUCCESS on success. If not a tpm error is returned
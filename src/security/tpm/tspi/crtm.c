@@ -4,6 +4,7 @@
 #include <fmap.h>
 #include <cbfs.h>
 #include "crtm.h"
+#include <stdbool.h>
 #include <string.h>
 
 /*
@@ -102,10 +103,30 @@ static bool is_runtime_data(const char *name)
 	return !strcmp(allowlist, name);
 }
 
+static bool cbfs_type_is_code(uint32_t cbfs_type)
+{
+	switch (cbfs_type) {
+	case CBFS_TYPE_BOOTBLOCK:
+	case CBFS_TYPE_STAGE:
+	case CBFS_TYPE_SELF:
+	case CBFS_TYPE_FIT:
+	case CBFS_TYPE_OPTIONROM:
+	case CBFS_TYPE_VSA:
+	case CBFS_TYPE_FSP:
+	case CBFS_TYPE_MRC:
+	case CBFS_TYPE_MMA:
+	case CBFS_TYPE_EFI:
+		return true;
+	default:
+		return false;
+	}
+}
+
 uint32_t tspi_measure_cbfs_hook(struct cbfsf *fh, const char *name)
 {
 	uint32_t pcr_index;
 	uint32_t cbfs_type;
+	uint32_t result;
 	struct region_device rdev;
 	char tcpa_metadata[TCPA_PCR_HASH_NAME];
 
@@ -146,7 +167,15 @@ uint32_t tspi_measure_cbfs_hook(struct cbfsf *fh, const char *name)
 	if (create_tcpa_metadata(&rdev, name, tcpa_metadata) < 0)
 		return VB2_ERROR_UNKNOWN;
 
-	return tpm_measure_region(&rdev, pcr_index, tcpa_metadata);
+	result = tpm_measure_region(&rdev, pcr_index, tcpa_metadata);
+	if (result != TPM_SUCCESS)
+		return result;
+
+	/* Code may run in this stage, its digest has to be in the PCR by then. */
+	if (cbfs_type_is_code(cbfs_type))
+		tpm_flush_pcr_extends();
+
+	return TPM_SUCCESS;
 }
 
 int tspi_measure_cache_to_pcr(void)
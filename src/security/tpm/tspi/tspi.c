@@ -1,11 +1,15 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
+#include <bootstate.h>
+#include <commonlib/helpers.h>
 #include <console/cbmem_console.h>
 #include <console/console.h>
+#include <console/post_codes.h>
 #include <security/tpm/tspi/crtm.h>
 #include <security/tpm/tspi.h>
 #include <security/tpm/tss.h>
 #include <assert.h>
+#include <string.h>
 #include <security/vboot/misc.h>
 #include <vb2_api.h>
 #include <vb2_sha.h>
@@ -215,6 +219,114 @@ uint32_t tpm_clear_and_reenable(void)
 	return TPM_SUCCESS;
 }
 
+#if CONFIG(TPM_MEASURED_BOOT_QUEUE)
+#define EXTEND_QUEUE_SIZE 8
+
+/*
+ * Digests waiting to be extended, oldest at queue_head. The oldest one may
+ * already be sent to the TPM (queue_in_flight), so that the TPM works on it
+ * while the next file is loaded and hashed. The queue is drained before any
+ * code that could overwrite it or talk to the TPM itself runs.
+ */
+static struct {
+	int pcr;
+	uint8_t digest[TPM_PCR_MAX_LEN];
+} extend_queue[EXTEND_QUEUE_SIZE];
+static size_t queue_head;
+static size_t queue_count;
+static int queue_in_flight;
+static uint32_t queue_result = TPM_SUCCESS;
+
+static void extend_queue_pop(uint32_t result)
+{
+	if (result != TPM_SUCCESS) {
+		printk(BIOS_ERR, "TPM: Extending PCR %d failed (%#x).\n",
+		       extend_queue[queue_head].pcr, result);
+		if (queue_result == TPM_SUCCESS)
+			queue_result = result;
+	}
+
+	queue_in_flight = 0;
+	queue_head = (queue_head + 1) % EXTEND_QUEUE_SIZE;
+	queue_count--;
+}
+
+/* Waits for the oldest extend to be done. */
+static void extend_queue_complete(void)
+{
+	if (queue_in_flight) {
+		extend_queue_pop(tlcl_extend_finish());
+		return;
+	}
+	extend_queue_pop(tlcl_extend(extend_queue[queue_head].pcr,
+				     extend_queue[queue_head].digest, NULL));
+}
+
+/* Sends queued extends and collects finished ones without waiting. */
+static void extend_queue_kick(void)
+{
+	uint32_t result;
+
+	while (queue_count) {
+		if (!queue_in_flight) {
+			result = tlcl_extend_start(extend_queue[queue_head].pcr,
+						   extend_queue[queue_head].digest);
+			if (result != TPM_SUCCESS) {
+				extend_queue_pop(result);
+				continue;
+			}
+			queue_in_flight = 1;
+		}
+		if (!tlcl_extend_ready())
+			return;
+		extend_queue_pop(tlcl_extend_finish());
+	}
+}
+
+static void extend_queue_add(int pcr, const uint8_t *digest, size_t digest_len)
+{
+	size_t tail;
+
+	extend_queue_kick();
+	if (queue_count == EXTEND_QUEUE_SIZE)
+		extend_queue_complete();
+
+	tail = (queue_head + queue_count) % EXTEND_QUEUE_SIZE;
+	extend_queue[tail].pcr = pcr;
+	memset(extend_queue[tail].digest, 0, sizeof(extend_queue[tail].digest));
+	memcpy(extend_queue[tail].digest, digest,
+	       MIN(digest_len, sizeof(extend_queue[tail].digest)));
+	queue_count++;
+
+	extend_queue_kick();
+}
+
+void tpm_flush_pcr_extends(void)
+{
+	uint32_t result;
+
+	while (queue_count)
+		extend_queue_complete();
+
+	/* Every failure is reported once. */
+	result = queue_result;
+	queue_result = TPM_SUCCESS;
+	if (result != TPM_SUCCESS)
+		die_with_post_code(POST_TPM_FAILURE,
+				   "TPM: Queued PCR extend failed (%#x).\n",
+				   result);
+}
+
+static void tpm_flush_pcr_extends_hook(void *unused)
+{
+	tpm_flush_pcr_extends();
+}
+
+/* The OS resume path does not go through prog_run(). */
+BOOT_STATE_INIT_ENTRY(BS_OS_RESUME, BS_ON_ENTRY, tpm_flush_pcr_extends_hook,
+		      NULL);
+#endif
+
 uint32_t tpm_extend_pcr(int pcr, enum vb2_hash_algorithm digest_algo,
 			uint8_t *digest, size_t digest_len, const char *name)
 {
@@ -230,10 +342,15 @@ uint32_t tpm_extend_pcr(int pcr, enum vb2_hash_algorithm digest_algo,
 			return result;
 		}
 
+#if CONFIG(TPM_MEASURED_BOOT_QUEUE)
+		printk(BIOS_DEBUG, "TPM: Queueing digest for %s into PCR %d\n", name, pcr);
+		extend_queue_add(pcr, digest, digest_len);
+#else
 		printk(BIOS_DEBUG, "TPM: Extending digest for %s into PCR %d\n", name, pcr);
 		result = tlcl_extend(pcr, digest, NULL);
 		if (result != TPM_SUCCESS)
 			return result;
+#endif
 	}
 
 	if (CONFIG(TPM_MEASURED_BOOT))
@@ -77,6 +77,17 @@ void *tpm_process_command(TPM_CC command, void *command_body);
 /* Return digest size of hash algorithm */
 uint16_t tlcl_get_hash_size_from_algo(TPMI_ALG_HASH hash_algo);
 
+/*
+ * tlcl_extend() split in two with TPM_TIS_ASYNC: tlcl_extend_start() sends
+ * the command and returns while the TPM works on it. tlcl_extend_ready()
+ * tells whether the TPM is done, and tlcl_extend_finish() waits for that
+ * and returns the TPM error code. Any other command finishes a started
+ * extend first; tlcl_extend_finish() still returns its result.
+ */
+uint32_t tlcl_extend_start(int pcr_num, const uint8_t *in_digest);
+int tlcl_extend_ready(void);
+uint32_t tlcl_extend_finish(void);
+
 #endif
 
 /*****************************************************************************/
@@ -16,6 +16,36 @@
  * TPM2 specification.
  */
 
+#if CONFIG(TPM_TIS_ASYNC)
+/* State of the extend sent by tlcl_extend_start(). */
+static int extend_pending;
+static uint32_t extend_result;
+static uint8_t extend_buffer[TPM_BUFFER_SIZE];
+
+static uint32_t tlcl_extend_complete(void)
+{
+	struct tpm2_response *response;
+	struct ibuf ib;
+	size_t in_size = sizeof(extend_buffer);
+
+	extend_pending = 0;
+	if (tis_recv(extend_buffer, &in_size)) {
+		printk(BIOS_ERR, "tpm transaction failed\n");
+		return TPM_E_IOERROR;
+	}
+
+	ibuf_init(&ib, extend_buffer, in_size);
+	response = tpm_unmarshal_response(TPM2_PCR_Extend, &ib);
+
+	printk(BIOS_INFO, "%s: response is %x\n",
+	       __func__, response ? response->hdr.tpm_code : -1);
+	if (!response || response->hdr.tpm_code)
+		return TPM_E_IOERROR;
+
+	return TPM_SUCCESS;
+}
+#endif
+
 void *tpm_process_command(TPM_CC command, void *command_body)
 {
 	struct obuf ob;
@@ -26,6 +56,12 @@ void *tpm_process_command(TPM_CC command, void *command_body)
 	/* Command/response buffer. */
 	static uint8_t cr_buffer[TPM_BUFFER_SIZE];
 
+#if CONFIG(TPM_TIS_ASYNC)
+	/* The TPM only takes one command at a time. */
+	if (extend_pending)
+		extend_result = tlcl_extend_complete();
+#endif
+
 	obuf_init(&ob, cr_buffer, sizeof(cr_buffer));
 
 	if (tpm_marshal_command(command, command_body, &ob) < 0) {
@@ -144,6 +180,52 @@ uint32_t tlcl_extend(int pcr_num, const uint8_t *in_digest,
 	return TPM_SUCCESS;
 }
 
+#if CONFIG(TPM_TIS_ASYNC)
+uint32_t tlcl_extend_start(int pcr_num, const uint8_t *in_digest)
+{
+	struct tpm2_pcr_extend_cmd pcr_ext_cmd;
+	struct obuf ob;
+	const uint8_t *sendb;
+	size_t out_size;
+
+	if (extend_pending)
+		tlcl_extend_complete();
+
+	pcr_ext_cmd.pcrHandle = HR_PCR + pcr_num;
+	pcr_ext_cmd.digests.count = 1;
+	pcr_ext_cmd.digests.digests[0].hashAlg = TPM_ALG_SHA256;
+	memcpy(pcr_ext_cmd.digests.digests[0].digest.sha256, in_digest,
+	       sizeof(pcr_ext_cmd.digests.digests[0].digest.sha256));
+
+	obuf_init(&ob, extend_buffer, sizeof(extend_buffer));
+	if (tpm_marshal_command(TPM2_PCR_Extend, &pcr_ext_cmd, &ob) < 0)
+		return TPM_E_IOERROR;
+
+	sendb = obuf_contents(&ob, &out_size);
+	if (tis_send(sendb, out_size)) {
+		printk(BIOS_ERR, "tpm transaction failed\n");
+		return TPM_E_IOERROR;
+	}
+
+	extend_pending = 1;
+	extend_result = TPM_SUCCESS;
+	return TPM_SUCCESS;
+}
+
+int tlcl_extend_ready(void)
+{
+	return !extend_pending || tis_response_ready();
+}
+
+uint32_t tlcl_extend_finish(void)
+{
+	if (extend_pending)
+		extend_result = tlcl_extend_complete();
+
+	return extend_result;
+}
+#endif
+
 uint32_t tlcl_finalize_physical_presence(void)
 {
 	/* Nothing needs to be done with tpm2. */
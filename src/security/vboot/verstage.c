@@ -4,6 +4,7 @@
 #include <arch/hlt.h>
 #include <console/console.h>
 #include <program_loading.h>
+#include <security/tpm/tspi.h>
 #include <security/vboot/vboot_common.h>
 
 void __weak verstage_mainboard_init(void)
@@ -19,6 +20,7 @@ void main(void)
 
 	if (CONFIG(VBOOT_RETURN_FROM_VERSTAGE)) {
 		verstage_main();
+		tpm_flush_pcr_extends();
 	} else {
 		run_romstage();
 		hlt();
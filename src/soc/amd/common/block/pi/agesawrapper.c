@@ -2,6 +2,8 @@
 
 #include <acpi/acpi.h>
 #include <console/console.h>
+#include <sampling_profiler.h>
+#include <security/tpm/tspi.h>
 #include <timestamp.h>
 #include <amdblocks/biosram.h>
 #include <amdblocks/s3_resume.h>
@@ -30,12 +32,18 @@ static AGESA_STATUS module_dispatch(AGESA_STRUCT_NAME func,
 	AMD_CONFIG_PARAMS *StdHeader)
 {
 	MODULE_ENTRY dispatcher = agesa_get_dispatcher();
+	AGESA_STATUS status;
 
 	if (!dispatcher)
 		return AGESA_UNSUPPORTED;
 
 	StdHeader->Func = func;
-	return dispatcher(StdHeader);
+	tpm_flush_pcr_extends();
+	sampling_profiler_pause();
+	status = dispatcher(StdHeader);
+	sampling_profiler_resume();
+
+	return status;
 }
 
 static AGESA_STATUS amd_dispatch(void *Params)
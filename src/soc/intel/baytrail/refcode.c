@@ -7,6 +7,8 @@
 #include <cpu/x86/tsc.h>
 #include <program_loading.h>
 #include <rmodule.h>
+#include <sampling_profiler.h>
+#include <security/tpm/tspi.h>
 #include <stage_cache.h>
 
 #include <soc/ramstage.h>
@@ -74,7 +76,10 @@ void baytrail_run_reference_code(void)
 	wrp.tsc_ticks_per_microsecond = tsc_freq_mhz();
 
 	/* Call into reference code. */
+	tpm_flush_pcr_extends();
+	sampling_profiler_pause();
 	ret = entry(&wrp);
+	sampling_profiler_resume();
 
 	if (ret != 0) {
 		printk(BIOS_DEBUG, "Reference code returned %d\n", ret);
@@ -7,6 +7,8 @@
 #include <console/streams.h>
 #include <program_loading.h>
 #include <rmodule.h>
+#include <sampling_profiler.h>
+#include <security/tpm/tspi.h>
 #include <stage_cache.h>
 #include <soc/pei_data.h>
 #include <soc/pei_wrapper.h>
@@ -72,7 +74,10 @@ void broadwell_run_reference_code(void)
 	}
 
 	/* Call into reference code. */
+	tpm_flush_pcr_extends();
+	sampling_profiler_pause();
 	ret = entry(&pei_data);
+	sampling_profiler_resume();
 	if (ret != 0) {
 		printk(BIOS_ERR, "Reference code returned %d\n", ret);
 		return;
@@ -8,6 +8,7 @@
 #include <device/pci_def.h>
 #include <memory_info.h>
 #include <mrc_cache.h>
+#include <security/tpm/tspi.h>
 #include <string.h>
 #if CONFIG(EC_GOOGLE_CHROMEEC)
 #include <ec/google/chromeec/ec.h>
@@ -82,6 +83,7 @@ void raminit(struct pei_data *pei_data)
 
 	printk(BIOS_DEBUG, "Starting Memory Reference Code\n");
 
+	tpm_flush_pcr_extends();
 	ret = entry(pei_data);
 	if (ret < 0)
 		die("pei_data version mismatch\n");
@@ -24,6 +24,7 @@
 #include <soc/pm.h>
 #include <soc/ramstage.h>
 #include <soc/systemagent.h>
+#include <timer.h>
 
 #include "chip.h"
 
@@ -253,20 +254,39 @@ static void per_cpu_smm_trigger(void)
 	smm_relocate();
 }
 
-static void vmx_configure(void *unused)
+static int vmx_configure(void)
 {
-	set_feature_ctrl_vmx();
+	return set_feature_ctrl_vmx();
 }
 
-static void fc_lock_configure(void *unused)
+static int sgx_step(void)
+{
+	if (CONFIG(SOC_INTEL_COMMON_BLOCK_SGX_ENABLE))
+		sgx_configure(NULL);
+	return 0;
+}
+
+static int fc_lock_configure(void)
 {
 	set_feature_ctrl_lock();
+	return 0;
 }
 
+/*
+ * Feature setup every thread runs after SMM relocation. IA32_FEATURE_CONTROL
+ * can be shared by the threads of a core, so no thread may lock it before all
+ * of them have done their VMX and SGX enables.
+ */
+static const struct mp_init_step post_mp_recipe[] = {
+	MP_STEP_CALL(vmx_configure),
+	MP_STEP_BARRIER(),
+	MP_STEP_CALL(sgx_step),
+	MP_STEP_BARRIER(),
+	MP_STEP_CALL(fc_lock_configure),
+};
+
 static void post_mp_init(void)
 {
-	int ret = 0;
-
 	/* Set Max Ratio */
 	cpu_set_max_ratio();
 
@@ -280,14 +300,8 @@ static void post_mp_init(void)
 	if (CONFIG(HAVE_SMI_HANDLER))
 		smm_lock();
 
-	ret |= mp_run_on_all_cpus(vmx_configure, NULL);
-
-	if (CONFIG(SOC_INTEL_COMMON_BLOCK_SGX_ENABLE))
-		ret |= mp_run_on_all_cpus(sgx_configure, NULL);
-
-	ret |= mp_run_on_all_cpus(fc_lock_configure, NULL);
-
-	if (ret)
+	if (mp_run_recipe(post_mp_recipe, ARRAY_SIZE(post_mp_recipe),
+			  1000 * USECS_PER_MSEC))
 		printk(BIOS_CRIT, "CRITICAL ERROR: MP post init failed\n");
 }
 
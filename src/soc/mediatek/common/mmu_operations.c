@@ -10,6 +10,7 @@ __weak void mtk_soc_after_dram(void) { /* do nothing */ }
 void mtk_mmu_init(void)
 {
 	mmu_init();
+	mmu_config_begin();
 
 	/*
 	 * Set 0x0 to 8GB address as device memory. We want to config IO_PHYS
@@ -28,6 +29,7 @@ void mtk_mmu_init(void)
 	mmu_config_range(_dma_coherent, REGION_SIZE(dma_coherent),
 			 SECURE_UNCACHED_MEM);
 
+	mmu_config_commit();
 	mmu_enable();
 }
 
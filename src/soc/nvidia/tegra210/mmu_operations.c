@@ -46,7 +46,9 @@ void tegra210_mmu_init(void)
 	size_t tz_size_mib;
 
 	mmu_init();
+	mmu_config_begin();
 	tegra210_mmu_config();
+	mmu_config_commit();
 	/*
 	 * Page tables are at the end of the trust zone region, but we should
 	 * double-check that memlayout and addressmap.c are in sync.
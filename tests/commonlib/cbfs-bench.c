@@ -0,0 +1,121 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <commonlib/bsd/cbfs_serialized.h>
+#include <commonlib/cbfs.h>
+#include <commonlib/endian.h>
+#include <commonlib/helpers.h>
+#include <commonlib/region.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tests/benchmark.h>
+
+/*
+ * A synthetic 8MiB CBFS with the usual stages behind a bunch of smaller files, roughly like a
+ * typical image. The free space at the end is erased flash, which cbfs_locate() has to walk
+ * through in CBFS_ALIGNMENT steps when a file doesn't exist.
+ */
+#define CBFS_SIZE	(8 * MiB)
+#define NUM_FILLERS	48
+
+struct cbfs_state {
+	uint8_t *image;
+	struct mem_region_device mdev;
+};
+
+static size_t add_file(uint8_t *image, size_t offset, const char *name, size_t len)
+{
+	struct cbfs_file *file = (struct cbfs_file *)(image + offset);
+	size_t header_len = ALIGN_UP(sizeof(*file) + strlen(name) + 1, 16);
+
+	memcpy(file->magic, CBFS_FILE_MAGIC, sizeof(file->magic));
+	write_be32(&file->len, len);
+	write_be32(&file->type, CBFS_TYPE_RAW);
+	write_be32(&file->attributes_offset, 0);
+	write_be32(&file->offset, header_len);
+	memset(image + offset + sizeof(*file), 0, header_len - sizeof(*file));
+	memcpy(image + offset + sizeof(*file), name, strlen(name));
+	memset(image + offset + header_len, 0x5a, len);
+
+	return ALIGN_UP(offset + header_len + len, CBFS_ALIGNMENT);
+}
+
+static int setup_cbfs(void **state)
+{
+	static const char *const stages[] = {
+		"cbfs master header", "fallback/romstage", "cpu_microcode_blob.bin",
+		"fallback/ramstage", "config", "revision", "vbt.bin", "fallback/payload",
+	};
+	struct cbfs_state *s = malloc(sizeof(*s));
+	char name[] = "filler-00";
+	size_t offset = 0;
+
+	if (!s)
+		return -1;
+	s->image = malloc(CBFS_SIZE);
+	if (!s->image)
+		return -1;
+	memset(s->image, 0xff, CBFS_SIZE);
+
+	for (int i = 0; i < NUM_FILLERS; i++) {
+		name[7] = '0' + i / 10;
+		name[8] = '0' + i % 10;
+		offset = add_file(s->image, offset, name, 1 * KiB + i * 512);
+	}
+	for (size_t i = 0; i < ARRAY_SIZE(stages); i++)
+		offset = add_file(s->image, offset, stages[i], 64 * KiB);
+
+	mem_region_device_ro_init(&s->mdev, s->image, CBFS_SIZE);
+
+	struct cbfsf fh;
+	if (cbfs_locate(&fh, &s->mdev.rdev, "fallback/payload", NULL) ||
+	    region_device_sz(&fh.data) != 64 * KiB)
+		return -1;
+
+	*state = s;
+	return 0;
+}
+
+static int teardown_cbfs(void **state)
+{
+	struct cbfs_state *s = *state;
+
+	free(s->image);
+	free(s);
+	return 0;
+}
+
+static void locate(struct cbfs_state *s, const char *name)
+{
+	struct cbfsf fh;
+
+	benchmark_use(cbfs_locate(&fh, &s->mdev.rdev, name, NULL));
+}
+
+static void bench_cbfs_locate_first(void *state)
+{
+	locate(state, "filler-00");
+}
+
+static void bench_cbfs_locate_payload(void *state)
+{
+	locate(state, "fallback/payload");
+}
+
+static void bench_cbfs_locate_missing(void *state)
+{
+	locate(state, "does/not/exist");
+}
+
+int main(void)
+{
+	const struct benchmark benchmarks[] = {
+		benchmark_setup_teardown(bench_cbfs_locate_first, 0, setup_cbfs,
+					 teardown_cbfs),
+		benchmark_setup_teardown(bench_cbfs_locate_payload, 0, setup_cbfs,
+					 teardown_cbfs),
+		benchmark_setup_teardown(bench_cbfs_locate_missing, 0, setup_cbfs,
+					 teardown_cbfs),
+	};
+
+	return run_benchmarks(benchmarks);
+}
@@ -0,0 +1,78 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <console/vtxprintf.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <tests/benchmark.h>
+
+/* Formats typical console lines into a buffer, without any console driver overhead. */
+
+struct out_buf {
+	char buf[256];
+	size_t pos;
+};
+
+static void tx_byte(unsigned char byte, void *data)
+{
+	struct out_buf *out = data;
+
+	if (out->pos < sizeof(out->buf))
+		out->buf[out->pos++] = byte;
+}
+
+static int format(struct out_buf *out, const char *fmt, ...)
+{
+	va_list args;
+	int ret;
+
+	out->pos = 0;
+	va_start(args, fmt);
+	ret = vtxprintf(tx_byte, fmt, args, out);
+	va_end(args);
+
+	return ret;
+}
+
+static void bench_vtxprintf_string(void *state)
+{
+	struct out_buf out;
+
+	benchmark_use(format(&out, "CBFS: Locating '%s'\n", "fallback/ramstage"));
+}
+
+static void bench_vtxprintf_integers(void *state)
+{
+	struct out_buf out;
+
+	benchmark_use(format(&out, "PCI: %02x:%02x.%01x [%04x/%04x] %s, size %d\n", 0, 0x1f, 3,
+			     0x8086, 0x9dc8, "enabled", 4096));
+}
+
+static void bench_vtxprintf_resource(void *state)
+{
+	struct out_buf out;
+
+	benchmark_use(format(&out, "%s %02lx * [0x%llx - 0x%llx] mem\n", "PCI: 00:02.0", 0x18UL,
+			     0x4000000000ULL, 0x400fffffffULL));
+}
+
+static void bench_vtxprintf_pointer(void *state)
+{
+	struct out_buf out;
+
+	benchmark_use(format(&out, "Backing address range [%p:%p)\n", (void *)0x80000000,
+			     (void *)0xc0000000));
+}
+
+int main(void)
+{
+	const struct benchmark benchmarks[] = {
+		benchmark(bench_vtxprintf_string, 0),
+		benchmark(bench_vtxprintf_integers, 0),
+		benchmark(bench_vtxprintf_resource, 0),
+		benchmark(bench_vtxprintf_pointer, 0),
+	};
+
+	return run_benchmarks(benchmarks);
+}
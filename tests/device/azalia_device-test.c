@@ -0,0 +1,475 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <commonlib/helpers.h>
+#include <delay.h>
+#include <device/azalia_device.h>
+#include <device/device.h>
+#include <device/pci_def.h>
+#include <device/resource.h>
+#include <string.h>
+#include <tests/test.h>
+
+/*
+ * Register model of an HD Audio controller with one codec on the link. Time
+ * is counted in microseconds: every register access takes one, and the link
+ * carries one verb per 48 kHz frame in each direction, so a response arrives
+ * in the frame after its verb was sent. The PCI command register is reached
+ * through the configuration ports.
+ */
+
+#define HDA_BASE	0x10000
+#define CODEC_ADDR	2
+#define CODEC_VIDDID	0x10ec0269
+#define FRAME_US	21
+#define MODEL_LOG_SIZE	1024
+#define TABLE_PINS	75
+
+static struct {
+	u16 pci_command;
+	u32 pci_address;
+	u32 gctl;
+	u32 statests;
+	u8 ring_caps;
+	int broken_dma;
+	int unsol_every;
+	/* The CORB stops being fetched after this many verbs */
+	unsigned int ring_stall;
+	unsigned int fetched;
+	/* Responses to the verbs after this many are lost */
+	unsigned int rirb_stall;
+	unsigned int answered;
+	/* Immediate command interface */
+	u32 ic;
+	u32 ir;
+	u32 icii;
+	int ic_sent;
+	u32 ic_resp;
+	/* CORB/RIRB */
+	u32 corb_base[2];
+	u32 rirb_base[2];
+	u8 corb_size;
+	u8 rirb_size;
+	u8 corb_wp;
+	u8 corb_rp;
+	int corb_rp_reset;
+	u8 rirb_wp;
+	u8 corbctl;
+	u8 rirbctl;
+	u8 rirbsts;
+	int rirb_pending;
+	u32 rirb_resp;
+	unsigned int sent;
+	/* Verbs as they went out on the link */
+	u32 log[MODEL_LOG_SIZE];
+	size_t log_len;
+	unsigned long now;
+	unsigned long next_frame;
+	unsigned long first_verb_at;
+} model;
+
+static u32 model_response(u32 verb)
+{
+	assert_int_equal(verb >> 28, CODEC_ADDR);
+	assert_true(model.log_len < MODEL_LOG_SIZE);
+	if (!model.log_len)
+		model.first_verb_at = model.now;
+	model.log[model.log_len++] = verb;
+
+	if ((verb & 0x0fffffff) == 0x000f0000)
+		return CODEC_VIDDID;
+	return verb & 0xff;
+}
+
+static volatile u32 *model_corb(void)
+{
+	return (void *)(uintptr_t)((u64)model.corb_base[1] << 32 |
+				   model.corb_base[0]);
+}
+
+static volatile u64 *model_rirb(void)
+{
+	return (void *)(uintptr_t)((u64)model.rirb_base[1] << 32 |
+				   model.rirb_base[0]);
+}
+
+static void model_rirb_write(u64 entry)
+{
+	model_rirb()[++model.rirb_wp] = entry;
+	model.rirbsts |= HDA_RIRBSTS_RINTFL;
+}
+
+/* One link frame: deliver the last response, send the next verb. */
+static void model_frame(void)
+{
+	if (model.ic_sent) {
+		model.ir = model.ic_resp;
+		model.icii = HDA_ICII_VALID;
+		model.ic_sent = 0;
+	} else if (model.icii & HDA_ICII_BUSY) {
+		model.ic_resp = model_response(model.ic);
+		model.ic_sent = 1;
+	}
+
+	if (!(model.rirbctl & HDA_RIRBCTL_RUN))
+		model.rirb_pending = 0;
+	if (model.rirb_pending && model.rirb_stall &&
+	    model.answered >= model.rirb_stall)
+		model.rirb_pending = 0;
+	if (model.rirb_pending) {
+		model_rirb_write(CODEC_ADDR | (u64)CODEC_ADDR << 32 |
+				 model.rirb_resp);
+		model.rirb_pending = 0;
+		model.answered++;
+		if (model.unsol_every && !(++model.sent % model.unsol_every))
+			model_rirb_write((u64)(HDA_RIRB_EX_UNSOL | CODEC_ADDR) << 32);
+	}
+
+	if ((model.corbctl & HDA_CORBCTL_RUN) && model.corb_rp != model.corb_wp &&
+	    (!model.ring_stall || model.fetched < model.ring_stall)) {
+		assert_int_equal(model.corb_size & HDA_RINGSIZE_MASK,
+				 HDA_RINGSIZE_256);
+		assert_int_equal(model.rirb_size & HDA_RINGSIZE_MASK,
+				 HDA_RINGSIZE_256);
+		/* The rings are fetched and written by DMA. */
+		assert_true(model.pci_command & PCI_COMMAND_MASTER);
+		model.rirb_resp = model_response(model_corb()[++model.corb_rp]);
+		model.rirb_pending = 1;
+		model.fetched++;
+	}
+}
+
+static void model_advance(unsigned long us)
+{
+	model.now += us;
+	while (model.next_frame <= model.now) {
+		model_frame();
+		model.next_frame += FRAME_US;
+	}
+}
+
+static u32 model_reg(const volatile void *addr)
+{
+	u32 reg = (uintptr_t)addr - HDA_BASE;
+
+	assert_true(reg < 0x100);
+	model_advance(1);
+	return reg;
+}
+
+static u32 model_read(const volatile void *addr)
+{
+	switch (model_reg(addr)) {
+	case HDA_GCTL_REG:
+		return model.gctl;
+	case HDA_STATESTS_REG:
+		return model.statests;
+	case HDA_CORBRP_REG:
+		return model.corb_rp | (model.corb_rp_reset ? HDA_CORBRP_RST : 0);
+	case HDA_CORBCTL_REG:
+		return model.broken_dma ? 0 : model.corbctl;
+	case HDA_CORBSIZE_REG:
+		return model.corb_size | model.ring_caps;
+	case HDA_RIRBWP_REG:
+		return model.rirb_wp;
+	case HDA_RIRBCTL_REG:
+		return model.broken_dma ? 0 : model.rirbctl;
+	case HDA_RIRBSTS_REG:
+		return model.rirbsts;
+	case HDA_RIRBSIZE_REG:
+		return model.rirb_size | model.ring_caps;
+	case HDA_IR_REG:
+		return model.ir;
+	case HDA_ICII_REG:
+		return model.icii;
+	default:
+		fail_msg("Unexpected read of register 0x%x",
+			 (u32)((uintptr_t)addr - HDA_BASE));
+		return 0;
+	}
+}
+
+static void model_write(volatile void *addr, u32 value)
+{
+	switch (model_reg(addr)) {
+	case HDA_GCTL_REG:
+		/* The codec reports itself when the link leaves reset. */
+		if (!(model.gctl & HDA_GCTL_CRST) && (value & HDA_GCTL_CRST))
+			model.statests |= 1 << CODEC_ADDR;
+		model.gctl = value;
+		break;
+	case HDA_STATESTS_REG:
+		model.statests &= ~value;
+		break;
+	case HDA_CORBLBASE_REG:
+		assert_int_equal(value % 128, 0);
+		model.corb_base[0] = value;
+		break;
+	case HDA_CORBUBASE_REG:
+		model.corb_base[1] = value;
+		break;
+	case HDA_CORBWP_REG:
+		model.corb_wp = value;
+		break;
+	case HDA_CORBRP_REG:
+		model.corb_rp_reset = !!(value & HDA_CORBRP_RST);
+		if (model.corb_rp_reset)
+			model.corb_rp = 0;
+		break;
+	case HDA_CORBCTL_REG:
+		model.corbctl = value;
+		break;
+	case HDA_CORBSIZE_REG:
+		assert_int_equal(model.corbctl & HDA_CORBCTL_RUN, 0);
+		model.corb_size = value & HDA_RINGSIZE_MASK;
+		break;
+	case HDA_RIRBLBASE_REG:
+		assert_int_equal(value % 128, 0);
+		model.rirb_base[0] = value;
+		break;
+	case HDA_RIRBUBASE_REG:
+		model.rirb_base[1] = value;
+		break;
+	case HDA_RIRBWP_REG:
+		if (value & HDA_RIRBWP_RST)
+			model.rirb_wp = 0;
+		break;
+	case HDA_RINTCNT_REG:
+		break;
+	case HDA_RIRBCTL_REG:
+		model.rirbctl = value;
+		break;
+	case HDA_RIRBSTS_REG:
+		model.rirbsts &= ~value;
+		break;
+	case HDA_RIRBSIZE_REG:
+		assert_int_equal(model.rirbctl & HDA_RIRBCTL_RUN, 0);
+		model.rirb_size = value & HDA_RINGSIZE_MASK;
+		break;
+	case HDA_IC_REG:
+		model.ic = value;
+		break;
+	case HDA_ICII_REG:
+		/* Only usable while the rings are stopped. */
+		assert_int_equal(model.corbctl & HDA_CORBCTL_RUN, 0);
+		if (value & HDA_ICII_VALID)
+			model.icii &= ~HDA_ICII_VALID;
+		if (value & HDA_ICII_BUSY)
+			model.icii |= HDA_ICII_BUSY;
+		break;
+	default:
+		fail_msg("Unexpected write of register 0x%x",
+			 (u32)((uintptr_t)addr - HDA_BASE));
+	}
+}
+
+uint8_t read8(const volatile void *addr)
+{
+	return model_read(addr);
+}
+
+uint16_t read16(const volatile void *addr)
+{
+	return model_read(addr);
+}
+
+uint32_t read32(const volatile void *addr)
+{
+	return model_read(addr);
+}
+
+void write8(volatile void *addr, uint8_t value)
+{
+	model_write(addr, value);
+}
+
+void write16(volatile void *addr, uint16_t value)
+{
+	model_write(addr, value);
+}
+
+void write32(volatile void *addr, uint32_t value)
+{
+	model_write(addr, value);
+}
+
+void outl(uint32_t value, uint16_t port)
+{
+	assert_int_equal(port, 0xcf8);
+	model.pci_address = value;
+}
+
+static u8 model_pci_reg(uint16_t port)
+{
+	assert_int_equal(port & ~3, 0xcfc);
+	assert_true(model.pci_address & 0x80000000);
+	return (model.pci_address & 0xfc) | (port & 3);
+}
+
+uint16_t inw(uint16_t port)
+{
+	assert_int_equal(model_pci_reg(port), PCI_COMMAND);
+	return model.pci_command;
+}
+
+void outw(uint16_t value, uint16_t port)
+{
+	assert_int_equal(model_pci_reg(port), PCI_COMMAND);
+	model.pci_command = value;
+}
+
+void udelay(unsigned int usecs)
+{
+	model_advance(usecs);
+}
+
+void mdelay(unsigned int msecs)
+{
+	model_advance(msecs * 1000);
+}
+
+const char *dev_path(const struct device *dev)
+{
+	return "PCI: 00:1b.0";
+}
+
+static struct bus audio_bus;
+static struct device audio_dev = {
+	.path = { .type = DEVICE_PATH_PCI, .pci = { .devfn = PCI_DEVFN(0x1b, 0) } },
+	.bus = &audio_bus,
+};
+static struct resource audio_bar = {
+	.base = HDA_BASE,
+	.index = PCI_BASE_ADDRESS_0,
+};
+
+/* The driver always gets a device. */
+void pcidev_die(void)
+{
+	fail();
+	__builtin_unreachable();
+}
+
+struct resource *find_resource(const struct device *dev, unsigned int index)
+{
+	assert_ptr_equal(dev, &audio_dev);
+	assert_int_equal(index, PCI_BASE_ADDRESS_0);
+	return &audio_bar;
+}
+
+/* Pin configuration defaults of a large codec, four verbs per pin */
+#define VERB(n, i)	(CODEC_ADDR << 28 | (0x12 + (n)) << 20 | \
+			 (0x71c + (i)) << 8 | (((n) * 4 + (i)) & 0xff))
+#define PIN(n)		VERB(n, 0), VERB(n, 1), VERB(n, 2), VERB(n, 3)
+#define PINS5(n)	PIN(n), PIN(n + 1), PIN(n + 2), PIN(n + 3), PIN(n + 4)
+#define PINS25(n)	PINS5(n), PINS5(n + 5), PINS5(n + 10), PINS5(n + 15), \
+			PINS5(n + 20)
+
+const u32 cim_verb_data[] = {
+	CODEC_VIDDID, 0x10280000, TABLE_PINS,
+	PINS25(0), PINS25(25), PINS25(50),
+};
+const u32 cim_verb_data_size = sizeof(cim_verb_data);
+const u32 pc_beep_verbs[] = {};
+const u32 pc_beep_verbs_size = 0;
+
+static int setup_model(void **state)
+{
+	memset(&model, 0, sizeof(model));
+	model.pci_command = PCI_COMMAND_MEMORY;
+	model.ring_caps = HDA_RINGSIZE_CAP_256;
+	return 0;
+}
+
+/*
+ * Runs the verb table through the driver, returns the time from the first
+ * verb on. Codec detection before that only waits on the link reset.
+ */
+static unsigned long load_table(void)
+{
+	const size_t verbs = 4 * TABLE_PINS;
+
+	azalia_audio_init(&audio_dev);
+
+	/* The vendor ID read, then the table, in order. */
+	assert_int_equal(model.log_len, 1 + verbs);
+	assert_memory_equal(&model.log[1], &cim_verb_data[3],
+			    verbs * sizeof(u32));
+	assert_int_equal(model.corbctl & HDA_CORBCTL_RUN, 0);
+	assert_int_equal(model.rirbctl & HDA_RIRBCTL_RUN, 0);
+	assert_int_equal(model.pci_command, PCI_COMMAND_MEMORY);
+
+	return model.now - model.first_verb_at;
+}
+
+static void test_ring_faster(void **state)
+{
+	unsigned long ring, immediate;
+
+	ring = load_table();
+
+	setup_model(state);
+	model.ring_caps = 0;
+	immediate = load_table();
+
+	print_message("%u verbs: %lu us with CORB/RIRB, %lu us immediate\n",
+		      4 * TABLE_PINS, ring, immediate);
+
+	/* The rings keep the link busy with a verb in every frame. */
+	assert_true(ring < 4 * TABLE_PINS * FRAME_US * 11 / 10 + 100);
+	assert_true(ring < immediate * 3 / 5);
+}
+
+static void test_unsolicited(void **state)
+{
+	model.unsol_every = 7;
+	load_table();
+	assert_int_equal(model.rirbsts, 0);
+}
+
+static void test_broken_dma(void **state)
+{
+	model.broken_dma = 1;
+	load_table();
+	assert_int_equal(model.corb_rp, 0);
+}
+
+/* The immediate interface picks up where the rings stopped, sends no verb twice. */
+static void test_ring_stall(void **state)
+{
+	static const unsigned int stalls[] = { 1, 100, 255, 256, 280 };
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(stalls); i++) {
+		setup_model(state);
+		model.ring_stall = stalls[i];
+		load_table();
+		assert_int_equal(model.fetched, stalls[i]);
+	}
+}
+
+/* Verbs that went out without a response are not sent again either. */
+static void test_rirb_stall(void **state)
+{
+	static const unsigned int stalls[] = { 1, 100, 254, 255, 256, 280 };
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(stalls); i++) {
+		setup_model(state);
+		model.rirb_stall = stalls[i];
+		load_table();
+		assert_int_equal(model.answered, stalls[i]);
+	}
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup(test_ring_faster, setup_model),
+		cmocka_unit_test_setup(test_unsolicited, setup_model),
+		cmocka_unit_test_setup(test_broken_dma, setup_model),
+		cmocka_unit_test_setup(test_ring_stall, setup_model),
+		cmocka_unit_test_setup(test_rirb_stall, setup_model),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
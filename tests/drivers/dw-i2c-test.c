@@ -0,0 +1,430 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <commonlib/helpers.h>
+#include <device/i2c_simple.h>
+#include <drivers/i2c/designware/dw_i2c.h>
+#include <string.h>
+#include <tests/test.h>
+#include <timer.h>
+
+/*
+ * Register model of a DesignWare I2C controller in master mode with an
+ * EEPROM-like target behind it. Time is counted in register accesses, and
+ * every command from the TX FIFO takes BYTE_TIME of them on the bus. The bus
+ * idles when the TX FIFO runs empty and reads stall while the RX FIFO is
+ * full, like the real controller stretches the clock.
+ */
+
+#define DW_BASE		0x10000
+#define TARGET_ADDR	0x50
+#define MODEL_MAX_DEPTH	256
+#define MODEL_LOG_SIZE	1024
+/* A byte at 400 kHz takes about ten slow register reads. */
+#define BYTE_TIME	10
+
+#define CMD_DATA_CMD			(1 << 8)
+#define CMD_DATA_STOP			(1 << 9)
+
+#define STATUS_ACTIVITY			(1 << 0)
+#define STATUS_TX_FIFO_NOT_FULL		(1 << 1)
+#define STATUS_TX_FIFO_EMPTY		(1 << 2)
+#define STATUS_RX_FIFO_NOT_EMPTY	(1 << 3)
+#define STATUS_RX_FIFO_FULL		(1 << 4)
+#define STATUS_MASTER_ACTIVITY		(1 << 5)
+
+#define COMP_PARAM1_RX_DEPTH_SHIFT	8
+#define COMP_PARAM1_TX_DEPTH_SHIFT	16
+
+#define ENABLE_CONTROLLER		(1 << 0)
+
+#define INTR_STAT_RX_FULL		(1 << 2)
+#define INTR_STAT_TX_EMPTY		(1 << 4)
+#define INTR_STAT_TX_ABORT		(1 << 6)
+#define INTR_STAT_STOP_DET		(1 << 9)
+
+#define DW_I2C_COMP_TYPE		0x44570140
+
+/* Offsets of the registers the driver uses for transfers */
+#define REG_TARGET_ADDR			0x04
+#define REG_CMD_DATA			0x10
+#define REG_RAW_INTR_STAT		0x34
+#define REG_RX_THRESH			0x38
+#define REG_TX_THRESH			0x3c
+#define REG_CLEAR_INTR			0x40
+#define REG_CLEAR_TX_ABRT_INTR		0x54
+#define REG_CLEAR_STOP_DET_INTR		0x60
+#define REG_ENABLE			0x6c
+#define REG_STATUS			0x70
+#define REG_TX_LEVEL			0x74
+#define REG_RX_LEVEL			0x78
+#define REG_TX_ABORT_SOURCE		0x80
+#define REG_ENABLE_STATUS		0x9c
+#define REG_COMP_PARAM1			0xf4
+#define REG_COMP_TYPE			0xfc
+#define REG_SIZE			0x100
+
+static struct {
+	uint32_t comp_param1;
+	unsigned int depth;
+	uint32_t target;
+	uint32_t enable;
+	uint32_t tx_thresh;
+	uint32_t rx_thresh;
+	uint32_t tx[MODEL_MAX_DEPTH];
+	unsigned int tx_count;
+	uint8_t rx[MODEL_MAX_DEPTH];
+	unsigned int rx_count;
+	uint32_t raw_intr;
+	uint32_t abort_source;
+	/* Target */
+	uint8_t mem[256];
+	uint8_t ptr;
+	int addressed;
+	int last_read;
+	/* Commands as they went out on the bus */
+	uint32_t log[MODEL_LOG_SIZE];
+	size_t log_len;
+	unsigned long now;
+	unsigned long done_at;
+	unsigned int polls;
+} model;
+
+/* Executes the oldest command of the TX FIFO, if the RX FIFO has room. */
+static int model_execute(void)
+{
+	uint32_t cmd;
+	int read;
+
+	cmd = model.tx[0];
+	read = !!(cmd & CMD_DATA_CMD);
+	if (read && model.rx_count == model.depth)
+		return 0;
+
+	memmove(&model.tx[0], &model.tx[1], --model.tx_count * sizeof(cmd));
+
+	if (model.target != TARGET_ADDR) {
+		/* Address NAK: the controller flushes the TX FIFO and stops. */
+		model.abort_source = 1;
+		model.raw_intr |= INTR_STAT_TX_ABORT | INTR_STAT_STOP_DET;
+		model.tx_count = 0;
+		return 1;
+	}
+
+	assert_true(model.log_len < MODEL_LOG_SIZE);
+	model.log[model.log_len++] = cmd;
+
+	/* A direction change is a repeated start. */
+	if (model.addressed && read != model.last_read)
+		model.addressed = 0;
+	model.last_read = read;
+
+	if (read) {
+		model.rx[model.rx_count++] = model.mem[model.ptr++];
+	} else if (!model.addressed) {
+		model.ptr = cmd & 0xff;
+	} else {
+		model.mem[model.ptr++] = cmd & 0xff;
+	}
+	model.addressed = 1;
+
+	if (cmd & CMD_DATA_STOP) {
+		model.addressed = 0;
+		model.raw_intr |= INTR_STAT_STOP_DET;
+	}
+	return 1;
+}
+
+/* Moves time on by one register access. */
+static void model_tick(void)
+{
+	model.now++;
+	while (model.tx_count && model.now >= model.done_at) {
+		if (!model_execute())
+			/* Clock stretched, the byte is done once there's room. */
+			model.done_at = model.now + 1;
+		else
+			model.done_at += BYTE_TIME;
+	}
+}
+
+static uint32_t model_raw_intr(void)
+{
+	uint32_t stat = model.raw_intr;
+
+	if (model.tx_count <= model.tx_thresh)
+		stat |= INTR_STAT_TX_EMPTY;
+	if (model.rx_count > model.rx_thresh)
+		stat |= INTR_STAT_RX_FULL;
+	return stat;
+}
+
+static uint32_t model_status(void)
+{
+	uint32_t status = 0;
+
+	if (model.tx_count)
+		status |= STATUS_ACTIVITY | STATUS_MASTER_ACTIVITY;
+	if (model.tx_count < model.depth)
+		status |= STATUS_TX_FIFO_NOT_FULL;
+	if (!model.tx_count)
+		status |= STATUS_TX_FIFO_EMPTY;
+	if (model.rx_count)
+		status |= STATUS_RX_FIFO_NOT_EMPTY;
+	if (model.rx_count == model.depth)
+		status |= STATUS_RX_FIFO_FULL;
+	return status;
+}
+
+static size_t model_reg(const volatile void *addr)
+{
+	size_t reg = (uintptr_t)addr - DW_BASE;
+
+	assert_true(reg < REG_SIZE);
+	return reg;
+}
+
+uint32_t read32(const volatile void *addr)
+{
+	uint8_t data;
+
+	model_tick();
+	switch (model_reg(addr)) {
+	case REG_RAW_INTR_STAT:
+		model.polls++;
+		return model_raw_intr();
+	case REG_STATUS:
+		model.polls++;
+		return model_status();
+	case REG_CMD_DATA:
+		assert_true(model.rx_count > 0);
+		data = model.rx[0];
+		memmove(&model.rx[0], &model.rx[1], --model.rx_count);
+		return data;
+	case REG_TX_LEVEL:
+		return model.tx_count;
+	case REG_RX_LEVEL:
+		return model.rx_count;
+	case REG_ENABLE:
+	case REG_ENABLE_STATUS:
+		return model.enable;
+	case REG_TX_ABORT_SOURCE:
+		return model.abort_source;
+	case REG_CLEAR_INTR:
+		model.raw_intr = 0;
+		return 0;
+	case REG_CLEAR_TX_ABRT_INTR:
+		model.raw_intr &= ~INTR_STAT_TX_ABORT;
+		return 0;
+	case REG_CLEAR_STOP_DET_INTR:
+		model.raw_intr &= ~INTR_STAT_STOP_DET;
+		return 0;
+	case REG_COMP_PARAM1:
+		return model.comp_param1;
+	case REG_COMP_TYPE:
+		return DW_I2C_COMP_TYPE;
+	default:
+		fail_msg("Unexpected read of register 0x%zx", model_reg(addr));
+		return 0;
+	}
+}
+
+void write32(volatile void *addr, uint32_t value)
+{
+	model_tick();
+	switch (model_reg(addr)) {
+	case REG_CMD_DATA:
+		assert_true(model.enable);
+		assert_true(model.tx_count < model.depth);
+		/* An idle bus starts right away. */
+		if (!model.tx_count)
+			model.done_at = model.now + BYTE_TIME;
+		model.tx[model.tx_count++] = value;
+		break;
+	case REG_TARGET_ADDR:
+		assert_false(model.enable);
+		model.target = value;
+		break;
+	case REG_ENABLE:
+		model.enable = value & ENABLE_CONTROLLER;
+		break;
+	case REG_TX_THRESH:
+		assert_true(value < model.depth);
+		model.tx_thresh = value;
+		break;
+	case REG_RX_THRESH:
+		assert_true(value < model.depth);
+		model.rx_thresh = value;
+		break;
+	default:
+		fail_msg("Unexpected write of register 0x%zx", model_reg(addr));
+	}
+}
+
+/* The driver only waits on the model, time only has to move. */
+void timer_monotonic_get(struct mono_time *mt)
+{
+	static long now;
+
+	mt->microseconds = now++;
+}
+
+uintptr_t dw_i2c_base_address(unsigned int bus)
+{
+	return DW_BASE;
+}
+
+static int setup_model(void **state)
+{
+	const unsigned int depth = (uintptr_t)*state;
+	int i;
+
+	memset(&model, 0, sizeof(model));
+	model.depth = depth;
+	/* A controller without encoded parameters reports nothing. */
+	if (depth > 1)
+		model.comp_param1 = (depth - 1) << COMP_PARAM1_TX_DEPTH_SHIFT |
+			(depth - 1) << COMP_PARAM1_RX_DEPTH_SHIFT;
+	for (i = 0; i < ARRAY_SIZE(model.mem); i++)
+		model.mem[i] = i * 13 + 5;
+	return 0;
+}
+
+/* The commands the byte-at-a-time driver sends for the same segments. */
+static size_t expected_log(const struct i2c_msg *segments, size_t count,
+			   uint32_t *log)
+{
+	size_t len = 0;
+	size_t i, j;
+
+	for (i = 0; i < count; i++) {
+		for (j = 0; j < segments[i].len; j++) {
+			if (segments[i].flags & I2C_M_RD)
+				log[len] = CMD_DATA_CMD;
+			else
+				log[len] = segments[i].buf[j];
+			if (i == count - 1 && j == segments[i].len - 1)
+				log[len] |= CMD_DATA_STOP;
+			len++;
+		}
+	}
+	return len;
+}
+
+static void run_transfer(struct i2c_msg *segments, size_t count)
+{
+	uint32_t log[MODEL_LOG_SIZE];
+	size_t log_len;
+
+	assert_int_equal(dw_i2c_transfer(0, segments, count), 0);
+
+	log_len = expected_log(segments, count, log);
+	assert_int_equal(model.log_len, log_len);
+	assert_memory_equal(model.log, log, log_len * sizeof(log[0]));
+	assert_int_equal(model.tx_count, 0);
+	assert_int_equal(model.rx_count, 0);
+	assert_false(model.enable);
+}
+
+static void test_read(void **state)
+{
+	uint8_t offset = 0;
+	uint8_t buf[256];
+	struct i2c_msg segments[] = {
+		{ .slave = TARGET_ADDR, .buf = &offset, .len = 1 },
+		{ .slave = TARGET_ADDR, .flags = I2C_M_RD, .buf = buf,
+		  .len = sizeof(buf) },
+	};
+
+	const unsigned long bus_time = (1 + sizeof(buf)) * BYTE_TIME;
+	unsigned long start = model.now;
+
+	run_transfer(segments, ARRAY_SIZE(segments));
+	assert_memory_equal(buf, model.mem, sizeof(buf));
+
+	print_message("FIFO depth %u: %u polls, %lu accesses for a 256 byte read\n",
+		      model.depth, model.polls, model.now - start);
+
+	/* With a FIFO the bus doesn't wait for the driver. */
+	if (model.depth >= 8)
+		assert_true(model.now - start < bus_time + bus_time / 20);
+}
+
+static void test_short_reads(void **state)
+{
+	uint8_t offset;
+	uint8_t buf[40];
+	struct i2c_msg segments[] = {
+		{ .slave = TARGET_ADDR, .buf = &offset, .len = 1 },
+		{ .slave = TARGET_ADDR, .flags = I2C_M_RD, .buf = buf },
+	};
+
+	for (segments[1].len = 1; segments[1].len <= sizeof(buf);
+	     segments[1].len++) {
+		offset = segments[1].len;
+		model.log_len = 0;
+		run_transfer(segments, ARRAY_SIZE(segments));
+		assert_memory_equal(buf, &model.mem[offset], segments[1].len);
+	}
+}
+
+static void test_write_then_read(void **state)
+{
+	uint8_t wbuf[20];
+	uint8_t rbuf[24];
+	struct i2c_msg segments[] = {
+		{ .slave = TARGET_ADDR, .buf = wbuf, .len = sizeof(wbuf) },
+		{ .slave = TARGET_ADDR, .flags = I2C_M_RD, .buf = rbuf,
+		  .len = sizeof(rbuf) },
+	};
+	int i;
+
+	/* Offset, then data: the read continues after the written bytes. */
+	wbuf[0] = 100;
+	for (i = 1; i < sizeof(wbuf); i++)
+		wbuf[i] = 0xa0 + i;
+
+	run_transfer(segments, ARRAY_SIZE(segments));
+	assert_memory_equal(&model.mem[100], &wbuf[1], sizeof(wbuf) - 1);
+	assert_memory_equal(rbuf, &model.mem[100 + sizeof(wbuf) - 1],
+			    sizeof(rbuf));
+}
+
+static void test_nak(void **state)
+{
+	uint8_t buf[16];
+	struct i2c_msg segment = {
+		.slave = TARGET_ADDR + 1, .flags = I2C_M_RD, .buf = buf,
+		.len = sizeof(buf),
+	};
+
+	assert_int_equal(dw_i2c_transfer(0, &segment, 1), -1);
+	assert_false(model.enable);
+	/* The abort is seen right away, not after a timeout. */
+	assert_true(model.polls < 2 * BYTE_TIME);
+}
+
+#define DEPTH(n) ((void *)(uintptr_t)(n))
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_prestate_setup_teardown(test_read,
+			setup_model, NULL, DEPTH(1)),
+		cmocka_unit_test_prestate_setup_teardown(test_read,
+			setup_model, NULL, DEPTH(8)),
+		cmocka_unit_test_prestate_setup_teardown(test_read,
+			setup_model, NULL, DEPTH(64)),
+		cmocka_unit_test_prestate_setup_teardown(test_short_reads,
+			setup_model, NULL, DEPTH(1)),
+		cmocka_unit_test_prestate_setup_teardown(test_short_reads,
+			setup_model, NULL, DEPTH(16)),
+		cmocka_unit_test_prestate_setup_teardown(test_write_then_read,
+			setup_model, NULL, DEPTH(4)),
+		cmocka_unit_test_prestate_setup_teardown(test_write_then_read,
+			setup_model, NULL, DEPTH(32)),
+		cmocka_unit_test_prestate_setup_teardown(test_nak,
+			setup_model, NULL, DEPTH(16)),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
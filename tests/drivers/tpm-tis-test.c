@@ -0,0 +1,354 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <commonlib/helpers.h>
+#include <delay.h>
+#include <endian.h>
+#include <security/tpm/tis.h>
+#include <string.h>
+#include <tests/test.h>
+#include <timer.h>
+
+/*
+ * Register model of a TIS/PTP FIFO TPM at locality 0, enough to run commands
+ * through the driver and count the MMIO accesses that takes.
+ *
+ * The driver probes the TPM only once, so every interface capability is built
+ * into a test binary of its own, see TEST_TIS_VERSION and
+ * TEST_TIS_TRANSFER_SIZE in Makefile.inc.
+ */
+
+#define TPM_BASE	CONFIG_TPM_TIS_BASE_ADDRESS
+#define MODEL_BUF_SIZE	1024
+
+#define TIS_REG_ACCESS			0x0
+#define TIS_REG_INTF_CAPABILITY		0x14
+#define TIS_REG_STS			0x18
+#define TIS_REG_BURST_COUNT		0x19
+#define TIS_REG_DATA_FIFO		0x24
+#define TIS_REG_XDATA_FIFO		0x80
+#define TIS_REG_DID_VID			0xf00
+
+#define TIS_STS_VALID			(1 << 7)
+#define TIS_STS_COMMAND_READY		(1 << 6)
+#define TIS_STS_TPM_GO			(1 << 5)
+#define TIS_STS_DATA_AVAILABLE		(1 << 4)
+#define TIS_STS_EXPECT			(1 << 3)
+
+#define TIS_ACCESS_TPM_REG_VALID_STS	(1 << 7)
+#define TIS_ACCESS_ACTIVE_LOCALITY	(1 << 5)
+#define TIS_ACCESS_REQUEST_USE		(1 << 1)
+
+#define TIS_CAP_TRANSFER_SIZE_SHIFT	9
+#define TIS_CAP_TRANSFER_SIZE_MASK	0x3
+#define  TIS_CAP_TRANSFER_LEGACY	0
+#define TIS_CAP_VERSION_SHIFT		28
+#define TIS_CAP_VERSION_MASK		0x7
+#define  TIS_CAP_VERSION_PTP		3
+
+#define TEST_INTF_CAPABILITY \
+	(TEST_TIS_VERSION << TIS_CAP_VERSION_SHIFT | \
+	 TEST_TIS_TRANSFER_SIZE << TIS_CAP_TRANSFER_SIZE_SHIFT)
+
+enum model_state {
+	MODEL_IDLE,
+	MODEL_READY,
+	MODEL_RECEPTION,
+	MODEL_COMPLETION,
+};
+
+static struct {
+	u32 intf_capability;
+	u16 fifo_size;
+	int active;
+	enum model_state state;
+	u8 cmd[MODEL_BUF_SIZE];
+	size_t cmd_len;
+	u8 rsp[MODEL_BUF_SIZE];
+	size_t rsp_len;
+	size_t rsp_pos;
+	unsigned int accesses;
+	unsigned int fifo_accesses;
+} model;
+
+static size_t model_cmd_size(void)
+{
+	if (model.cmd_len < 6)
+		return MODEL_BUF_SIZE;
+	return be32_to_cpu(*(u32 *)&model.cmd[2]);
+}
+
+static u8 model_status(void)
+{
+	u8 sts = TIS_STS_VALID;
+
+	switch (model.state) {
+	case MODEL_READY:
+		sts |= TIS_STS_COMMAND_READY | TIS_STS_EXPECT;
+		break;
+	case MODEL_RECEPTION:
+		if (model.cmd_len < model_cmd_size())
+			sts |= TIS_STS_EXPECT;
+		break;
+	case MODEL_COMPLETION:
+		if (model.rsp_pos < model.rsp_len)
+			sts |= TIS_STS_DATA_AVAILABLE;
+		break;
+	default:
+		break;
+	}
+	return sts;
+}
+
+static u16 model_burst(void)
+{
+	switch (model.state) {
+	case MODEL_READY:
+	case MODEL_RECEPTION:
+		return model.fifo_size;
+	case MODEL_COMPLETION:
+		return MIN(model.fifo_size, model.rsp_len - model.rsp_pos);
+	default:
+		return 0;
+	}
+}
+
+/* Answers every command with a success header echoing the command tag. */
+static void model_execute(void)
+{
+	assert_int_equal(model.cmd_len, model_cmd_size());
+	memcpy(model.rsp, model.cmd, 2);
+	*(u32 *)&model.rsp[2] = cpu_to_be32(10);
+	*(u32 *)&model.rsp[6] = 0;
+	model.rsp_len = 10;
+	model.rsp_pos = 0;
+	model.state = MODEL_COMPLETION;
+}
+
+static int model_is_fifo(u32 reg, int width)
+{
+	const int ptp = ((model.intf_capability >> TIS_CAP_VERSION_SHIFT) &
+			 TIS_CAP_VERSION_MASK) == TIS_CAP_VERSION_PTP;
+	const int wide = ((model.intf_capability >> TIS_CAP_TRANSFER_SIZE_SHIFT) &
+			  TIS_CAP_TRANSFER_SIZE_MASK) != TIS_CAP_TRANSFER_LEGACY;
+
+	if (reg == TIS_REG_DATA_FIFO || (ptp && reg == TIS_REG_XDATA_FIFO)) {
+		/* Wider accesses must have been announced by the TPM. */
+		assert_true(width == 1 || (wide && width == 4));
+		model.fifo_accesses++;
+		return 1;
+	}
+	return 0;
+}
+
+static u32 model_reg(const volatile void *addr)
+{
+	u32 reg = (uintptr_t)addr - TPM_BASE;
+
+	assert_true(reg < 0x1000);
+	model.accesses++;
+	return reg;
+}
+
+static u32 model_read(const volatile void *addr, int width)
+{
+	const u32 reg = model_reg(addr);
+	u32 value = 0;
+	int i;
+
+	if (model_is_fifo(reg, width)) {
+		assert_int_equal(model.state, MODEL_COMPLETION);
+		for (i = 0; i < width; i++) {
+			assert_true(model.rsp_pos < model.rsp_len);
+			value |= model.rsp[model.rsp_pos++] << (8 * i);
+		}
+		return value;
+	}
+
+	switch (reg) {
+	case TIS_REG_ACCESS:
+		return TIS_ACCESS_TPM_REG_VALID_STS |
+			(model.active ? TIS_ACCESS_ACTIVE_LOCALITY : 0);
+	case TIS_REG_STS:
+		return model_status() | model_burst() << 8;
+	case TIS_REG_BURST_COUNT:
+		return model_burst() & 0xff;
+	case TIS_REG_BURST_COUNT + 1:
+		return model_burst() >> 8;
+	case TIS_REG_INTF_CAPABILITY:
+		return model.intf_capability;
+	case TIS_REG_DID_VID:
+		return 0x00011014;
+	default:
+		fail_msg("Unexpected read of register 0x%x", reg);
+		return 0;
+	}
+}
+
+static void model_write(volatile void *addr, u32 value, int width)
+{
+	const u32 reg = model_reg(addr);
+	int i;
+
+	if (model_is_fifo(reg, width)) {
+		assert_true(model.state == MODEL_READY ||
+			    model.state == MODEL_RECEPTION);
+		model.state = MODEL_RECEPTION;
+		for (i = 0; i < width; i++) {
+			assert_true(model.cmd_len < model_cmd_size());
+			model.cmd[model.cmd_len++] = value >> (8 * i);
+		}
+		return;
+	}
+
+	switch (reg) {
+	case TIS_REG_ACCESS:
+		if (value & TIS_ACCESS_REQUEST_USE)
+			model.active = 1;
+		if (value & TIS_ACCESS_ACTIVE_LOCALITY)
+			model.active = 0;
+		break;
+	case TIS_REG_STS:
+		if (value & TIS_STS_COMMAND_READY) {
+			model.state = MODEL_READY;
+			model.cmd_len = 0;
+			model.rsp_len = 0;
+		}
+		if (value & TIS_STS_TPM_GO) {
+			assert_int_equal(model.state, MODEL_RECEPTION);
+			model_execute();
+		}
+		break;
+	default:
+		fail_msg("Unexpected write of register 0x%x", reg);
+	}
+}
+
+uint8_t read8(const volatile void *addr)
+{
+	return model_read(addr, 1);
+}
+
+uint32_t read32(const volatile void *addr)
+{
+	return model_read(addr, 4);
+}
+
+void write8(volatile void *addr, uint8_t value)
+{
+	model_write(addr, value, 1);
+}
+
+void write32(volatile void *addr, uint32_t value)
+{
+	model_write(addr, value, 4);
+}
+
+/* The driver never waits on the model, time only has to move. */
+void timer_monotonic_get(struct mono_time *mt)
+{
+	static long now;
+
+	mt->microseconds = now++;
+}
+
+void udelay(unsigned int usecs)
+{
+}
+
+/* TPM2_PCR_Extend of PCR 2 with one SHA-256 digest, as tlcl sends it. */
+static const u8 pcr_extend[] = {
+	0x80, 0x02, 0x00, 0x00, 0x00, 0x41, 0x00, 0x00, 0x01, 0x82,
+	0x00, 0x00, 0x00, 0x02,				/* pcrHandle */
+	0x00, 0x00, 0x00, 0x09, 0x40, 0x00, 0x00, 0x09,	/* TPM_RS_PW */
+	0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x01, 0x00, 0x0b,		/* one SHA-256 */
+	0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+	0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+	0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+	0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f,
+};
+
+static int setup_model(void **state)
+{
+	memset(&model, 0, sizeof(model));
+	model.intf_capability = TEST_INTF_CAPABILITY;
+	model.fifo_size = 32;
+
+	assert_int_equal(tis_init(), 0);
+	assert_int_equal(tis_open(), 0);
+	return 0;
+}
+
+static unsigned int run_pcr_extend(void)
+{
+	u8 rsp[64];
+	size_t rsp_len = sizeof(rsp);
+	unsigned int accesses = model.accesses;
+
+	assert_int_equal(tis_sendrecv(pcr_extend, sizeof(pcr_extend), rsp,
+				      &rsp_len), 0);
+	assert_int_equal(rsp_len, 10);
+	assert_memory_equal(model.cmd, pcr_extend, sizeof(pcr_extend));
+	assert_memory_equal(rsp, model.rsp, rsp_len);
+	assert_int_equal(model.state, MODEL_READY);
+
+	return model.accesses - accesses;
+}
+
+static void test_pcr_extend(void **state)
+{
+	const unsigned int fifo = model.fifo_accesses;
+	unsigned int accesses = run_pcr_extend();
+
+	print_message("%u MMIO accesses, %u of them to the FIFO\n", accesses,
+		      model.fifo_accesses - fifo);
+
+	if (TEST_TIS_TRANSFER_SIZE == TIS_CAP_TRANSFER_LEGACY) {
+		/* One access per byte, plus the status/burst reads. */
+		assert_int_equal(model.fifo_accesses - fifo,
+				 sizeof(pcr_extend) + 10);
+		assert_true(accesses <= sizeof(pcr_extend) + 10 + 12);
+	} else {
+		assert_true(model.fifo_accesses - fifo <=
+			    (sizeof(pcr_extend) + 10) / 4 + 6);
+		assert_true(accesses <= 40);
+	}
+}
+
+static void test_small_bursts(void **state)
+{
+	int i;
+
+	/* Commands and responses take many bursts. */
+	for (i = 1; i <= 8; i++) {
+		model.fifo_size = i;
+		run_pcr_extend();
+	}
+}
+
+static void test_split_transaction(void **state)
+{
+	u8 rsp[64];
+	size_t rsp_len = sizeof(rsp);
+
+	assert_int_equal(tis_send(pcr_extend, sizeof(pcr_extend)), 0);
+	assert_memory_equal(model.cmd, pcr_extend, sizeof(pcr_extend));
+	assert_true(tis_response_ready());
+
+	assert_int_equal(tis_recv(rsp, &rsp_len), 0);
+	assert_int_equal(rsp_len, 10);
+	assert_memory_equal(rsp, model.rsp, rsp_len);
+	assert_int_equal(model.state, MODEL_READY);
+	assert_false(tis_response_ready());
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup(test_pcr_extend, setup_model),
+		cmocka_unit_test_setup(test_small_bursts, setup_model),
+		cmocka_unit_test_setup(test_split_transaction, setup_model),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,338 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <delay.h>
+#include <ec/google/chromeec/ec.h>
+#include <ec/google/chromeec/ec_commands.h>
+#include <string.h>
+#include <tests/test.h>
+
+/*
+ * Mock of a Chrome EC behind LPC: the host command and memory map ranges,
+ * the command/status port and the protocol version 3 packet handling of the
+ * EC firmware. A few commands work on a small flash array.
+ */
+
+#define MOCK_RANGE_START	EC_HOST_CMD_REGION0
+#define MOCK_RANGE_SIZE		(2 * EC_HOST_CMD_REGION_SIZE + EC_MEMMAP_SIZE + 1)
+#define MOCK_FLASH_SIZE		1024
+#define MOCK_BUSY_POLLS		3
+
+static struct {
+	u8 mem[MOCK_RANGE_SIZE];
+	u8 flash[MOCK_FLASH_SIZE];
+	u8 result;
+	int busy;
+	int corrupt_response;
+	unsigned int accesses;
+	unsigned int packets;
+} ec;
+
+static u8 mock_checksum(const u8 *data, size_t size)
+{
+	u8 csum = 0;
+
+	while (size--)
+		csum += *data++;
+	return csum;
+}
+
+/* Runs one command, returns the EC result code and the response data size. */
+static u16 mock_command(u16 command, const u8 *params, size_t params_size,
+			u8 *out, u16 *out_size)
+{
+	const struct ec_params_flash_read *rd = (const void *)params;
+	const struct ec_params_flash_write *wr = (const void *)params;
+	u32 hello;
+
+	*out_size = 0;
+	switch (command) {
+	case EC_CMD_HELLO:
+		if (params_size != sizeof(hello))
+			return EC_RES_INVALID_PARAM;
+		memcpy(&hello, params, sizeof(hello));
+		hello += 0x01020304;
+		memcpy(out, &hello, sizeof(hello));
+		*out_size = sizeof(hello);
+		return EC_RES_SUCCESS;
+	case EC_CMD_FLASH_READ:
+		if (params_size != sizeof(*rd) ||
+		    rd->offset + rd->size > MOCK_FLASH_SIZE ||
+		    rd->size + sizeof(struct ec_host_response) >
+		    EC_LPC_HOST_PACKET_SIZE)
+			return EC_RES_INVALID_PARAM;
+		memcpy(out, &ec.flash[rd->offset], rd->size);
+		*out_size = rd->size;
+		return EC_RES_SUCCESS;
+	case EC_CMD_FLASH_WRITE:
+		if (params_size < sizeof(*wr) ||
+		    params_size - sizeof(*wr) != wr->size ||
+		    wr->offset + wr->size > MOCK_FLASH_SIZE)
+			return EC_RES_INVALID_PARAM;
+		memcpy(&ec.flash[wr->offset], params + sizeof(*wr), wr->size);
+		return EC_RES_SUCCESS;
+	default:
+		return EC_RES_INVALID_COMMAND;
+	}
+}
+
+/* What the EC firmware does when the host writes EC_COMMAND_PROTOCOL_3. */
+static void mock_packet(void)
+{
+	u8 *packet = &ec.mem[EC_LPC_ADDR_HOST_PACKET - MOCK_RANGE_START];
+	struct ec_host_request rq;
+	struct ec_host_response rs;
+	u8 data[EC_LPC_HOST_PACKET_SIZE];
+	u16 data_len;
+
+	ec.packets++;
+	ec.busy = MOCK_BUSY_POLLS;
+
+	memcpy(&rq, packet, sizeof(rq));
+	if (rq.struct_version != EC_HOST_REQUEST_VERSION ||
+	    rq.data_len + sizeof(rq) > EC_LPC_HOST_PACKET_SIZE) {
+		ec.result = EC_RES_INVALID_HEADER;
+		return;
+	}
+	if (mock_checksum(packet, sizeof(rq) + rq.data_len)) {
+		ec.result = EC_RES_INVALID_CHECKSUM;
+		return;
+	}
+
+	ec.result = mock_command(rq.command, packet + sizeof(rq), rq.data_len,
+				 data, &data_len);
+
+	memset(&rs, 0, sizeof(rs));
+	rs.struct_version = EC_HOST_RESPONSE_VERSION;
+	rs.result = ec.result;
+	rs.data_len = data_len;
+	memcpy(packet, &rs, sizeof(rs));
+	memcpy(packet + sizeof(rs), data, data_len);
+	packet[offsetof(struct ec_host_response, checksum)] =
+		-mock_checksum(packet, sizeof(rs) + data_len);
+	if (ec.corrupt_response)
+		packet[sizeof(rs) + data_len - 1] ^= 0x10;
+}
+
+static u8 *mock_mem(u16 port)
+{
+	assert_in_range(port, MOCK_RANGE_START,
+			MOCK_RANGE_START + MOCK_RANGE_SIZE - 1);
+	return &ec.mem[port - MOCK_RANGE_START];
+}
+
+uint8_t inb(uint16_t port)
+{
+	ec.accesses++;
+	switch (port) {
+	case EC_LPC_ADDR_HOST_CMD:
+		if (ec.busy) {
+			ec.busy--;
+			return EC_LPC_CMDR_BUSY;
+		}
+		return 0;
+	case EC_LPC_ADDR_HOST_DATA:
+		return ec.result;
+	default:
+		return *mock_mem(port);
+	}
+}
+
+uint32_t inl(uint16_t port)
+{
+	uint32_t value;
+
+	ec.accesses++;
+	assert_int_equal(port % 4, 0);
+	memcpy(&value, mock_mem(port), sizeof(value));
+	(void)mock_mem(port + 3);
+	return value;
+}
+
+void outb(uint8_t value, uint16_t port)
+{
+	ec.accesses++;
+	if (port == EC_LPC_ADDR_HOST_CMD) {
+		assert_int_equal(value, EC_COMMAND_PROTOCOL_3);
+		mock_packet();
+		return;
+	}
+	*mock_mem(port) = value;
+}
+
+void outl(uint32_t value, uint16_t port)
+{
+	ec.accesses++;
+	assert_int_equal(port % 4, 0);
+	(void)mock_mem(port + 3);
+	memcpy(mock_mem(port), &value, sizeof(value));
+}
+
+/* Not used by the code under test. */
+void udelay(unsigned int usecs)
+{
+}
+
+static int setup_ec(void **state)
+{
+	u8 *memmap = &ec.mem[EC_LPC_ADDR_MEMMAP - MOCK_RANGE_START];
+	int i;
+
+	memset(&ec, 0, sizeof(ec));
+	memmap[EC_MEMMAP_ID] = 'E';
+	memmap[EC_MEMMAP_ID + 1] = 'C';
+	memmap[EC_MEMMAP_HOST_CMD_FLAGS] = EC_HOST_CMD_FLAG_VERSION_3;
+	for (i = 0; i < MOCK_FLASH_SIZE; i++)
+		ec.flash[i] = i * 7 + (i >> 8);
+	return 0;
+}
+
+static void test_hello(void **state)
+{
+	struct ec_params_hello params = { .in_data = 0xa0b0c0d0 };
+	struct ec_response_hello resp;
+	struct chromeec_command cmd = {
+		.cmd_code = EC_CMD_HELLO,
+		.cmd_data_in = &params,
+		.cmd_size_in = sizeof(params),
+		.cmd_data_out = &resp,
+		.cmd_size_out = sizeof(resp),
+	};
+
+	assert_int_equal(google_chromeec_command(&cmd), 0);
+	assert_int_equal(cmd.cmd_code, EC_RES_SUCCESS);
+	assert_int_equal(cmd.cmd_size_out, sizeof(resp));
+	assert_int_equal(resp.out_data, 0xa0b0c0d0 + 0x01020304);
+}
+
+static int flash_read(u32 offset, u32 size, u8 *buf)
+{
+	struct ec_params_flash_read params = { .offset = offset, .size = size };
+	struct chromeec_command cmd = {
+		.cmd_code = EC_CMD_FLASH_READ,
+		.cmd_data_in = &params,
+		.cmd_size_in = sizeof(params),
+		.cmd_data_out = buf,
+		.cmd_size_out = size,
+	};
+	int ret = google_chromeec_command(&cmd);
+
+	if (!ret)
+		assert_int_equal(cmd.cmd_size_out, size);
+	return ret;
+}
+
+static void test_flash_read(void **state)
+{
+	const u32 max = EC_LPC_HOST_PACKET_SIZE - sizeof(struct ec_host_response);
+	u8 buf[EC_LPC_HOST_PACKET_SIZE + 3];
+	u32 size;
+
+	/* Every length, read to unaligned buffers too. */
+	for (size = 0; size <= max; size++) {
+		memset(buf, 0, sizeof(buf));
+		assert_int_equal(flash_read(size, size, &buf[size % 4]), 0);
+		assert_memory_equal(&buf[size % 4], &ec.flash[size], size);
+	}
+}
+
+static void test_flash_write(void **state)
+{
+	const u32 max = EC_LPC_HOST_PACKET_SIZE -
+		sizeof(struct ec_host_request) -
+		sizeof(struct ec_params_flash_write);
+	u8 buf[EC_LPC_HOST_PACKET_SIZE + 1];
+	struct ec_params_flash_write *params = (void *)&buf[1];
+	u8 *data = &buf[1] + sizeof(*params);
+	struct chromeec_command cmd = {
+		.cmd_code = EC_CMD_FLASH_WRITE,
+		.cmd_data_in = params,
+	};
+	u32 size;
+	u32 i;
+
+	for (size = 1; size <= max; size += 13) {
+		params->offset = 512;
+		params->size = size;
+		for (i = 0; i < size; i++)
+			data[i] = size + i;
+
+		cmd.cmd_code = EC_CMD_FLASH_WRITE;
+		cmd.cmd_size_in = sizeof(*params) + size;
+		cmd.cmd_size_out = 0;
+		assert_int_equal(google_chromeec_command(&cmd), 0);
+		assert_int_equal(cmd.cmd_size_out, 0);
+		assert_memory_equal(&ec.flash[512], data, size);
+	}
+}
+
+static void test_error_result(void **state)
+{
+	struct chromeec_command cmd = {
+		.cmd_code = 0x3fff,
+	};
+
+	assert_int_not_equal(google_chromeec_command(&cmd), 0);
+	assert_int_equal(cmd.cmd_code, EC_RES_INVALID_COMMAND);
+}
+
+static void test_bad_checksum(void **state)
+{
+	u8 buf[64];
+
+	ec.corrupt_response = 1;
+	assert_int_not_equal(flash_read(0, sizeof(buf), buf), 0);
+}
+
+static void test_too_big(void **state)
+{
+	u8 buf[EC_LPC_HOST_PACKET_SIZE];
+	struct chromeec_command cmd = {
+		.cmd_code = EC_CMD_FLASH_WRITE,
+		.cmd_data_in = buf,
+		.cmd_size_in = sizeof(buf),
+	};
+
+	assert_int_not_equal(google_chromeec_command(&cmd), 0);
+	assert_int_equal(ec.packets, 0);
+}
+
+static void test_io_count(void **state)
+{
+	const u32 size = EC_LPC_HOST_PACKET_SIZE -
+		sizeof(struct ec_host_response);
+	u8 buf[EC_LPC_HOST_PACKET_SIZE];
+	unsigned int accesses;
+
+	/* Detect the protocol version first, that's not counted. */
+	assert_int_equal(flash_read(0, 4, buf), 0);
+
+	accesses = ec.accesses;
+	assert_int_equal(flash_read(0, size, buf), 0);
+	accesses = ec.accesses - accesses;
+
+	print_message("%u port accesses to read %u bytes\n", accesses, size);
+
+	/*
+	 * Request and response move in words; then there are the checksum
+	 * byte, the command, the status polls and the result.
+	 */
+	assert_true(accesses <= (sizeof(struct ec_host_request) +
+				 sizeof(struct ec_params_flash_read) +
+				 sizeof(struct ec_host_response) + size) / 4 +
+			2 * (MOCK_BUSY_POLLS + 2) + 3);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup(test_hello, setup_ec),
+		cmocka_unit_test_setup(test_flash_read, setup_ec),
+		cmocka_unit_test_setup(test_flash_write, setup_ec),
+		cmocka_unit_test_setup(test_error_result, setup_ec),
+		cmocka_unit_test_setup(test_bad_checksum, setup_ec),
+		cmocka_unit_test_setup(test_too_big, setup_ec),
+		cmocka_unit_test_setup(test_io_count, setup_ec),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,236 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+/*
+ * Benchmark harness, see tests/include/tests/benchmark.h. This file is built against the host
+ * C library headers rather than the coreboot ones seen by the code under test.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <tests/benchmark.h>
+
+#define NSECS_PER_SEC		1000000000ULL
+#define DEFAULT_SAMPLES		10
+/* Medians were seen to move by up to 10% between runs, leave room above that. */
+#define DEFAULT_THRESHOLD	15.0
+/* Run for at least this long before taking samples. */
+#define WARMUP_NS		(100ULL * 1000 * 1000)
+/* Aim for samples of at least this length to keep timer resolution out of the results. */
+#define MIN_SAMPLE_NS		(20ULL * 1000 * 1000)
+
+struct result {
+	char name[128];
+	double ns_per_op;
+	double min_ns_per_op;
+	double mb_per_s;
+	uint64_t ops_per_sample;
+	int samples;
+};
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * NSECS_PER_SEC + ts.tv_nsec;
+}
+
+static uint64_t time_ops(const struct benchmark *b, void *state, uint64_t ops)
+{
+	uint64_t start = now_ns();
+
+	for (uint64_t i = 0; i < ops; i++)
+		b->func(state);
+
+	return now_ns() - start;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+
+	return (x > y) - (x < y);
+}
+
+static int env_int(const char *name, int def)
+{
+	const char *s = getenv(name);
+
+	return s && atoi(s) > 0 ? atoi(s) : def;
+}
+
+static void measure(const struct benchmark *b, void *state, int samples, struct result *r)
+{
+	double per_op[samples];
+	uint64_t ops = 1;
+	uint64_t elapsed, warmup = 0;
+
+	/* Calibrate the sample length, which also serves as the first part of the warmup. */
+	while ((elapsed = time_ops(b, state, ops)) < MIN_SAMPLE_NS) {
+		warmup += elapsed;
+		ops *= 2;
+	}
+	warmup += elapsed;
+	while (warmup < WARMUP_NS)
+		warmup += time_ops(b, state, ops);
+
+	for (int i = 0; i < samples; i++)
+		per_op[i] = (double)time_ops(b, state, ops) / ops;
+	qsort(per_op, samples, sizeof(per_op[0]), cmp_double);
+
+	snprintf(r->name, sizeof(r->name), "%s", b->name);
+	r->samples = samples;
+	r->ops_per_sample = ops;
+	r->min_ns_per_op = per_op[0];
+	r->ns_per_op = samples % 2 ? per_op[samples / 2] :
+		(per_op[samples / 2 - 1] + per_op[samples / 2]) / 2;
+	/* 1 byte/ns == 1000 MB/s */
+	r->mb_per_s = b->bytes_per_op ? b->bytes_per_op * 1000.0 / r->ns_per_op : 0;
+}
+
+static void write_json(const char *path, const char *group, const struct result *results,
+		       size_t count)
+{
+	FILE *f = fopen(path, "w");
+
+	if (!f) {
+		fprintf(stderr, "Cannot write %s\n", path);
+		return;
+	}
+
+	/* One benchmark per line, which keeps read_baseline() trivial. */
+	fprintf(f, "{\n\t\"group\": \"%s\",\n\t\"benchmarks\": [\n", group);
+	for (size_t i = 0; i < count; i++)
+		fprintf(f, "\t\t{\"name\": \"%s\", \"ns_per_op\": %.3f, "
+			"\"min_ns_per_op\": %.3f, \"mb_per_s\": %.3f, "
+			"\"ops_per_sample\": %llu, \"samples\": %d}%s\n",
+			results[i].name, results[i].ns_per_op, results[i].min_ns_per_op,
+			results[i].mb_per_s, (unsigned long long)results[i].ops_per_sample,
+			results[i].samples, i + 1 < count ? "," : "");
+	fprintf(f, "\t]\n}\n");
+	fclose(f);
+}
+
+/* Look up the fastest ns/op of a benchmark in a JSON file written by write_json(). */
+static int read_baseline(FILE *f, const char *name, double *min_ns_per_op)
+{
+	static const char field[] = "\"min_ns_per_op\": ";
+	char line[512], key[160];
+
+	snprintf(key, sizeof(key), "{\"name\": \"%s\", ", name);
+	rewind(f);
+	while (fgets(line, sizeof(line), f)) {
+		const char *p = strstr(line, key);
+
+		if (p)
+			p = strstr(p, field);
+		if (p && sscanf(p + strlen(field), "%lf", min_ns_per_op) == 1)
+			return 0;
+	}
+
+	return -1;
+}
+
+void *benchmark_read_file(const char *path, size_t *size)
+{
+	FILE *f = fopen(path, "rb");
+	void *buf = NULL;
+	long len;
+
+	if (!f)
+		goto err;
+	if (fseek(f, 0, SEEK_END) || (len = ftell(f)) < 0 || fseek(f, 0, SEEK_SET))
+		goto err;
+	buf = malloc(len);
+	if (!buf || fread(buf, 1, len, f) != (size_t)len)
+		goto err;
+
+	fclose(f);
+	*size = len;
+	return buf;
+
+err:
+	fprintf(stderr, "Cannot read %s\n", path);
+	free(buf);
+	if (f)
+		fclose(f);
+	return NULL;
+}
+
+int _run_benchmarks(const char *group_name, const struct benchmark *benchmarks, size_t count)
+{
+	const char *json_file = getenv("BENCH_JSON_FILE");
+	const char *baseline_file = getenv("BENCH_BASELINE_FILE");
+	const char *threshold_env = getenv("BENCH_THRESHOLD");
+	const double threshold = threshold_env ? atof(threshold_env) : DEFAULT_THRESHOLD;
+	const int samples = env_int("BENCH_SAMPLES", DEFAULT_SAMPLES);
+	struct result *results = calloc(count, sizeof(*results));
+	FILE *baseline = NULL;
+	size_t measured = 0;
+	int failures = 0;
+
+	if (!results)
+		return 1;
+
+	if (baseline_file && *baseline_file) {
+		baseline = fopen(baseline_file, "r");
+		if (!baseline)
+			fprintf(stderr, "Cannot read baseline %s\n", baseline_file);
+	}
+
+	printf("[==========] Running %zu benchmark(s) of %s.\n", count, group_name);
+	for (size_t i = 0; i < count; i++) {
+		const struct benchmark *b = &benchmarks[i];
+		struct result *r = &results[measured];
+		void *state = NULL;
+		double base;
+
+		if (b->setup && b->setup(&state)) {
+			printf("[  ERROR   ] %s: setup failed\n", b->name);
+			failures++;
+			continue;
+		}
+
+		measure(b, state, samples, r);
+		measured++;
+
+		if (b->teardown)
+			b->teardown(&state);
+
+		printf("[    BENCH ] %s: %.1f ns/op (min %.1f)", r->name, r->ns_per_op,
+		       r->min_ns_per_op);
+		if (b->bytes_per_op)
+			printf(", %.1f MB/s", r->mb_per_s);
+		printf(", %d x %llu ops\n", r->samples, (unsigned long long)r->ops_per_sample);
+
+		if (!baseline || read_baseline(baseline, r->name, &base) || base <= 0)
+			continue;
+
+		/*
+		 * Compare the fastest samples: noise from the rest of the system only ever
+		 * makes a sample slower, so the minimum is the most stable figure.
+		 */
+		double change = (r->min_ns_per_op - base) / base * 100.0;
+		if (change > threshold) {
+			printf("[ REGRESS  ] %s: min %+.1f%% vs. baseline min %.1f ns/op\n",
+			       r->name, change, base);
+			failures++;
+		} else {
+			printf("[  BASELINE] %s: min %+.1f%% vs. baseline min %.1f ns/op\n",
+			       r->name, change, base);
+		}
+	}
+
+	if (json_file && *json_file)
+		write_json(json_file, group_name, results, measured);
+	if (baseline)
+		fclose(baseline);
+	free(results);
+
+	printf("[==========] %zu benchmark(s) run, %d failed.\n", measured, failures);
+
+	return failures;
+}
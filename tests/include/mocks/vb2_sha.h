@@ -0,0 +1,8 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef _TESTS_MOCKS_VB2_SHA_H
+#define _TESTS_MOCKS_VB2_SHA_H
+
+#include <vb2_api.h>
+
+#endif /* _TESTS_MOCKS_VB2_SHA_H */
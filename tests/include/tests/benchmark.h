@@ -0,0 +1,47 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef _TESTS_BENCHMARK_H
+#define _TESTS_BENCHMARK_H
+
+/*
+ * Minimal benchmark harness for hot library code. Benchmarks live next to the unit tests, in
+ * files named *-bench.c that are registered as tests-y += <name>-bench. They are not part of
+ * `make unit-tests`, but built and run with `make unit-benchmarks`.
+ *
+ * Each benchmark function performs one operation on the state prepared by its optional setup
+ * fixture. The harness calibrates how many operations fit into a sample, warms up, takes a
+ * number of samples and reports the median in ns/op (and MB/s if bytes_per_op is set). When
+ * BENCH_JSON_FILE is set the results are also written there as JSON, and when
+ * BENCH_BASELINE_FILE points to such a file from an earlier run, the fastest sample of each
+ * result is compared to the fastest one of the baseline and the run fails if it got slower by
+ * more than BENCH_THRESHOLD percent (default 15). BENCH_SAMPLES overrides the number of
+ * samples (default 10).
+ */
+
+#include <stddef.h>
+
+struct benchmark {
+	const char *name;
+	void (*func)(void *state);
+	int (*setup)(void **state);
+	int (*teardown)(void **state);
+	size_t bytes_per_op;
+};
+
+#define benchmark(f, bytes) { #f, f, NULL, NULL, bytes }
+#define benchmark_setup_teardown(f, bytes, s, t) { #f, f, s, t, bytes }
+
+int _run_benchmarks(const char *group_name, const struct benchmark *benchmarks, size_t count);
+
+#define run_benchmarks(group) _run_benchmarks(__FILE__, group, sizeof(group) / sizeof(group[0]))
+
+/*
+ * Reads a whole host file into a malloc()ed buffer for use as benchmark input, since the code
+ * under test only sees the coreboot headers. Returns NULL on failure.
+ */
+void *benchmark_read_file(const char *path, size_t *size);
+
+/* Keeps the compiler from optimizing away a result (integer or pointer) that is otherwise unused. */
+#define benchmark_use(value) __asm__ volatile("" : : "r"(value) : "memory")
+
+#endif /* _TESTS_BENCHMARK_H */
@@ -0,0 +1,24 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef _TESTS_IO_MOCK_H
+#define _TESTS_IO_MOCK_H
+
+/*
+ * Replaces the inline port I/O accessors of the x86 <arch/io.h> with
+ * functions that the test has to provide, so that device models can see
+ * every access of the code under test. Add it to a test with
+ *   <test>-cflags += -include $(testsrc)/include/tests/io_mock.h
+ */
+
+#define __ARCH_IO_H__
+
+#include <stdint.h>
+
+void outb(uint8_t value, uint16_t port);
+void outw(uint16_t value, uint16_t port);
+void outl(uint32_t value, uint16_t port);
+uint8_t inb(uint16_t port);
+uint16_t inw(uint16_t port);
+uint32_t inl(uint16_t port);
+
+#endif /* _TESTS_IO_MOCK_H */
@@ -0,0 +1,26 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef _TESTS_MMIO_MOCK_H
+#define _TESTS_MMIO_MOCK_H
+
+/*
+ * Replaces the inline MMIO accessors of <arch/mmio.h> with functions that the
+ * test has to provide, so that register models can see every access of the
+ * code under test. Add it to a test with
+ *   <test>-cflags += -include $(testsrc)/include/tests/mmio_mock.h
+ */
+
+#define __ARCH_MMIO_H__
+
+#include <stdint.h>
+
+uint8_t read8(const volatile void *addr);
+uint16_t read16(const volatile void *addr);
+uint32_t read32(const volatile void *addr);
+uint64_t read64(const volatile void *addr);
+void write8(volatile void *addr, uint8_t value);
+void write16(volatile void *addr, uint16_t value);
+void write32(volatile void *addr, uint32_t value);
+void write64(volatile void *addr, uint64_t value);
+
+#endif /* _TESTS_MMIO_MOCK_H */
@@ -0,0 +1,251 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <commonlib/bsd/compression.h>
+#include <lib.h>
+#include <LzmaEnc.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tests/benchmark.h>
+
+#define DATA_SIZE	(256 * 1024)
+
+#define LZ4F_MAGICNUMBER	0x184D2204
+#define LZ4_HASH_BITS		12
+#define LZ4_MIN_MATCH		4
+/* LZ4 requires the last match to start at least 12 and end at least 5 bytes before the end. */
+#define LZ4_MFLIMIT		12
+#define LZ4_LASTLITERALS	5
+
+struct compressed {
+	uint8_t *data;
+	size_t size;
+	uint8_t *out;
+};
+
+/* Firmware-like input: text with lots of short repeats mixed with incompressible bytes. */
+static void fill_data(uint8_t *buf, size_t size)
+{
+	static const char *const words[] = {
+		"coreboot ", "ramstage ", "romstage ", "payload ", "CBFS ", "device ",
+		"resource ", "0x00000000 ", "PCI: ", "enabled\n", "disabled\n", "MMIO ",
+	};
+	uint32_t lcg = 0x1234567;
+	size_t i = 0;
+
+	while (i < size) {
+		lcg = lcg * 1103515245 + 12345;
+		if ((lcg >> 28) == 0) {
+			buf[i++] = lcg >> 16;
+			continue;
+		}
+		const char *w = words[(lcg >> 16) % ARRAY_SIZE(words)];
+		while (*w && i < size)
+			buf[i++] = *w++;
+	}
+}
+
+static uint32_t read32(const uint8_t *p)
+{
+	return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static void write32(uint8_t *p, uint32_t v)
+{
+	p[0] = v;
+	p[1] = v >> 8;
+	p[2] = v >> 16;
+	p[3] = v >> 24;
+}
+
+static uint8_t *lz4_put_length(uint8_t *op, size_t len)
+{
+	for (; len >= 255; len -= 255)
+		*op++ = 255;
+	*op++ = len;
+	return op;
+}
+
+/* Emits one LZ4 sequence. A match_len of 0 emits the final literals-only sequence. */
+static uint8_t *lz4_put_sequence(uint8_t *op, const uint8_t *literals, size_t literal_len,
+				 size_t offset, size_t match_len)
+{
+	uint8_t *token = op++;
+
+	*token = MIN(literal_len, 15) << 4;
+	if (literal_len >= 15)
+		op = lz4_put_length(op, literal_len - 15);
+	memcpy(op, literals, literal_len);
+	op += literal_len;
+
+	if (match_len) {
+		*op++ = offset & 0xff;
+		*op++ = offset >> 8;
+		*token |= MIN(match_len - LZ4_MIN_MATCH, 15);
+		if (match_len - LZ4_MIN_MATCH >= 15)
+			op = lz4_put_length(op, match_len - LZ4_MIN_MATCH - 15);
+	}
+
+	return op;
+}
+
+/* Simple greedy LZ4 block compressor, good enough to produce realistic input for ulz4fn(). */
+static size_t lz4_compress_block(const uint8_t *src, size_t size, uint8_t *dst)
+{
+	static uint32_t table[1 << LZ4_HASH_BITS];
+	size_t anchor = 0, i = 0;
+	uint8_t *op = dst;
+
+	memset(table, 0, sizeof(table));
+
+	while (size > LZ4_MFLIMIT && i < size - LZ4_MFLIMIT) {
+		uint32_t seq = read32(src + i);
+		uint32_t hash = (seq * 2654435761U) >> (32 - LZ4_HASH_BITS);
+		size_t ref = table[hash];
+		size_t len = LZ4_MIN_MATCH;
+
+		/* Table entries are stored + 1 so that 0 means empty. */
+		table[hash] = i + 1;
+		if (!ref-- || i - ref > 0xffff || read32(src + ref) != seq) {
+			i++;
+			continue;
+		}
+
+		while (i + len < size - LZ4_LASTLITERALS && src[ref + len] == src[i + len])
+			len++;
+
+		op = lz4_put_sequence(op, src + anchor, i - anchor, i - ref, len);
+		i += len;
+		anchor = i;
+	}
+
+	op = lz4_put_sequence(op, src + anchor, size - anchor, 0, 0);
+	return op - dst;
+}
+
+static int setup_lz4(void **state)
+{
+	struct compressed *c = malloc(sizeof(*c));
+	uint8_t *raw = malloc(DATA_SIZE);
+	uint8_t *p;
+
+	if (!c || !raw)
+		return -1;
+	c->data = malloc(DATA_SIZE * 2);
+	c->out = malloc(DATA_SIZE);
+	if (!c->data || !c->out)
+		return -1;
+
+	fill_data(raw, DATA_SIZE);
+
+	/* Frame header: version 1, independent blocks, 4MB max block size, (unchecked) HC. */
+	p = c->data;
+	write32(p, LZ4F_MAGICNUMBER);
+	p[4] = 0x60;
+	p[5] = 0x70;
+	p[6] = 0;
+	p += 7;
+
+	size_t block_size = lz4_compress_block(raw, DATA_SIZE, p + 4);
+	write32(p, block_size);
+	p += 4 + block_size;
+	write32(p, 0);
+	c->size = p + 4 - c->data;
+
+	if (ulz4fn(c->data, c->size, c->out, DATA_SIZE) != DATA_SIZE ||
+	    memcmp(c->out, raw, DATA_SIZE))
+		return -1;
+
+	free(raw);
+	*state = c;
+	return 0;
+}
+
+static void *lzma_alloc(void *p, size_t size)
+{
+	return malloc(size);
+}
+
+static void lzma_free(void *p, void *address)
+{
+	free(address);
+}
+
+static int setup_lzma(void **state)
+{
+	struct ISzAlloc alloc = { lzma_alloc, lzma_free };
+	struct CLzmaEncProps props;
+	struct compressed *c = malloc(sizeof(*c));
+	uint8_t *raw = malloc(DATA_SIZE);
+	size_t props_size = LZMA_PROPS_SIZE;
+	size_t size = DATA_SIZE * 2;
+
+	if (!c || !raw)
+		return -1;
+	c->data = malloc(LZMA_PROPS_SIZE + 8 + size);
+	c->out = malloc(DATA_SIZE);
+	if (!c->data || !c->out)
+		return -1;
+
+	fill_data(raw, DATA_SIZE);
+
+	/* Same settings cbfstool uses for stages and payloads. */
+	LzmaEncProps_Init(&props);
+	props.dictSize = DATA_SIZE;
+	props.lc = 1;
+	props.lp = 0;
+	props.pb = 0;
+	props.fb = 273;
+	props.numThreads = 1;
+
+	if (LzmaEncode(c->data + LZMA_PROPS_SIZE + 8, &size, raw, DATA_SIZE, &props, c->data,
+		       &props_size, 0, NULL, &alloc, &alloc) != SZ_OK)
+		return -1;
+	write32(c->data + LZMA_PROPS_SIZE, DATA_SIZE);
+	write32(c->data + LZMA_PROPS_SIZE + 4, 0);
+	c->size = LZMA_PROPS_SIZE + 8 + size;
+
+	if (ulzman(c->data, c->size, c->out, DATA_SIZE) != DATA_SIZE ||
+	    memcmp(c->out, raw, DATA_SIZE))
+		return -1;
+
+	free(raw);
+	*state = c;
+	return 0;
+}
+
+static int teardown_compressed(void **state)
+{
+	struct compressed *c = *state;
+
+	free(c->data);
+	free(c->out);
+	free(c);
+	return 0;
+}
+
+static void bench_ulz4fn(void *state)
+{
+	struct compressed *c = state;
+
+	benchmark_use(ulz4fn(c->data, c->size, c->out, DATA_SIZE));
+}
+
+static void bench_ulzman(void *state)
+{
+	struct compressed *c = state;
+
+	benchmark_use(ulzman(c->data, c->size, c->out, DATA_SIZE));
+}
+
+int main(void)
+{
+	const struct benchmark benchmarks[] = {
+		benchmark_setup_teardown(bench_ulz4fn, DATA_SIZE, setup_lz4,
+					 teardown_compressed),
+		benchmark_setup_teardown(bench_ulzman, DATA_SIZE, setup_lzma,
+					 teardown_compressed),
+	};
+
+	return run_benchmarks(benchmarks);
+}
@@ -0,0 +1,73 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <commonlib/helpers.h>
+#include <stdlib.h>
+#include <tests/benchmark.h>
+
+#include "../../src/lib/jpeg.h"
+
+/* Decodes the bootsplash from the top of the tree into a 32bpp framebuffer, as bootsplash.c. */
+
+struct jpeg_state {
+	unsigned char *jpeg;
+	unsigned char *framebuffer;
+	struct jpeg_decdata *decdata;
+	int width;
+	int height;
+};
+
+static int setup_jpeg(void **state)
+{
+	struct jpeg_state *s = malloc(sizeof(*s));
+	size_t size;
+
+	if (!s)
+		return -1;
+
+	s->jpeg = benchmark_read_file(JPEG_BENCH_FILE, &size);
+	if (!s->jpeg)
+		return -1;
+
+	jpeg_fetch_size(s->jpeg, &s->width, &s->height);
+	s->width = ALIGN_UP(s->width, 16);
+	s->height = ALIGN_UP(s->height, 16);
+
+	s->framebuffer = malloc(s->width * s->height * 4);
+	s->decdata = malloc(sizeof(*s->decdata));
+	if (!s->framebuffer || !s->decdata)
+		return -1;
+
+	if (jpeg_decode(s->jpeg, s->framebuffer, s->width, s->height, 32, s->decdata))
+		return -1;
+
+	*state = s;
+	return 0;
+}
+
+static int teardown_jpeg(void **state)
+{
+	struct jpeg_state *s = *state;
+
+	free(s->jpeg);
+	free(s->framebuffer);
+	free(s->decdata);
+	free(s);
+	return 0;
+}
+
+static void bench_jpeg_decode(void *state)
+{
+	struct jpeg_state *s = state;
+
+	jpeg_decode(s->jpeg, s->framebuffer, s->width, s->height, 32, s->decdata);
+	benchmark_use(s->framebuffer);
+}
+
+int main(void)
+{
+	const struct benchmark benchmarks[] = {
+		benchmark_setup_teardown(bench_jpeg_decode, 0, setup_jpeg, teardown_jpeg),
+	};
+
+	return run_benchmarks(benchmarks);
+}
@@ -0,0 +1,99 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tests/benchmark.h>
+
+/* This links against src/lib/mem*.c, so the functions measured are the C fallbacks. */
+
+#define BUF_SIZE	(64 * 1024)
+#define SMALL_SIZE	(4 * 1024)
+
+struct buffers {
+	uint8_t *src;
+	uint8_t *dst;
+};
+
+static int setup_buffers(void **state)
+{
+	struct buffers *b = malloc(sizeof(*b));
+
+	if (!b)
+		return -1;
+
+	b->src = malloc(BUF_SIZE);
+	b->dst = malloc(BUF_SIZE);
+	if (!b->src || !b->dst)
+		return -1;
+
+	for (size_t i = 0; i < BUF_SIZE; i++)
+		b->src[i] = i * 7 + 3;
+
+	*state = b;
+	return 0;
+}
+
+static int teardown_buffers(void **state)
+{
+	struct buffers *b = *state;
+
+	free(b->src);
+	free(b->dst);
+	free(b);
+	return 0;
+}
+
+static void bench_memcpy_4k(void *state)
+{
+	struct buffers *b = state;
+
+	benchmark_use(memcpy(b->dst, b->src, SMALL_SIZE));
+}
+
+static void bench_memcpy_64k(void *state)
+{
+	struct buffers *b = state;
+
+	benchmark_use(memcpy(b->dst, b->src, BUF_SIZE));
+}
+
+static void bench_memset_4k(void *state)
+{
+	struct buffers *b = state;
+
+	benchmark_use(memset(b->dst, 0, SMALL_SIZE));
+}
+
+static void bench_memset_64k(void *state)
+{
+	struct buffers *b = state;
+
+	benchmark_use(memset(b->dst, 0xa5, BUF_SIZE));
+}
+
+static void bench_memmove_overlap_60k(void *state)
+{
+	struct buffers *b = state;
+
+	/* Overlapping backwards move, the case memcpy can't handle. */
+	benchmark_use(memmove(b->dst + SMALL_SIZE, b->dst, BUF_SIZE - SMALL_SIZE));
+}
+
+int main(void)
+{
+	const struct benchmark benchmarks[] = {
+		benchmark_setup_teardown(bench_memcpy_4k, SMALL_SIZE, setup_buffers,
+					 teardown_buffers),
+		benchmark_setup_teardown(bench_memcpy_64k, BUF_SIZE, setup_buffers,
+					 teardown_buffers),
+		benchmark_setup_teardown(bench_memset_4k, SMALL_SIZE, setup_buffers,
+					 teardown_buffers),
+		benchmark_setup_teardown(bench_memset_64k, BUF_SIZE, setup_buffers,
+					 teardown_buffers),
+		benchmark_setup_teardown(bench_memmove_overlap_60k, BUF_SIZE - SMALL_SIZE,
+					 setup_buffers, teardown_buffers),
+	};
+
+	return run_benchmarks(benchmarks);
+}
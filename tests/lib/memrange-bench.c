@@ -0,0 +1,44 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <commonlib/helpers.h>
+#include <memrange.h>
+#include <tests/benchmark.h>
+
+/*
+ * Builds a memory map the way the resource allocator and bootmem do: insert a few dozen
+ * overlapping ranges with different tags, punch holes into them and walk the result.
+ */
+#define NUM_RANGES	64
+
+static void bench_memranges_build(void *state)
+{
+	struct range_entry free_entries[2 * NUM_RANGES];
+	struct memranges ranges;
+	const struct range_entry *r;
+	resource_t total = 0;
+
+	memranges_init_empty(&ranges, free_entries, ARRAY_SIZE(free_entries));
+
+	for (int i = 0; i < NUM_RANGES; i++) {
+		resource_t base = (resource_t)((i * 37) % NUM_RANGES) * 16 * MiB;
+
+		memranges_insert(&ranges, base, 24 * MiB, i % 4 + 1);
+	}
+	for (int i = 0; i < NUM_RANGES / 4; i++)
+		memranges_create_hole(&ranges, (resource_t)i * 64 * MiB + 4 * MiB, 1 * MiB);
+
+	memranges_each_entry(r, &ranges)
+		total += range_entry_size(r);
+	benchmark_use(total);
+
+	memranges_teardown(&ranges);
+}
+
+int main(void)
+{
+	const struct benchmark benchmarks[] = {
+		benchmark(bench_memranges_build, 0),
+	};
+
+	return run_benchmarks(benchmarks);
+}
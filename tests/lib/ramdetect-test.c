@@ -0,0 +1,215 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <cbmem.h>
+#include <commonlib/helpers.h>
+#include <ramdetect.h>
+#include <string.h>
+#include <symbols.h>
+#include <tests/test.h>
+
+/*
+ * Model of a RAM of 'size' MiB at DRAM_START. Above it, reads return all ones
+ * and writes are dropped, or, with 'wraps' set, the RAM repeats every 'size'
+ * MiB like it does behind a controller ignoring the upper address bits. Only
+ * the words written are kept.
+ */
+
+#define DRAM_START	0x80000000UL
+#define PROBE_SIZE	4096
+#define MODEL_WORDS	256
+
+static struct {
+	size_t size;
+	int wraps;
+	struct {
+		uintptr_t cell;
+		uint32_t value;
+	} words[MODEL_WORDS];
+	size_t count;
+	unsigned int accesses;
+} model;
+
+/* CBMEM_ID_RAMDETECT as probe_ramsize() reads it */
+static struct {
+	int present;
+	struct {
+		uint64_t dram_start;
+		uint64_t probe_size;
+		uint64_t size;
+	} result;
+} cbmem_entry;
+
+u8 _program[4];
+u8 _eprogram[4];
+int cbmem_initialized;
+
+/* Returns the RAM cell behind an address, or -1 for no RAM. */
+static intptr_t model_cell(const volatile void *addr)
+{
+	uintptr_t offset = (uintptr_t)addr - DRAM_START;
+	const uintptr_t size = model.size * MiB;
+
+	model.accesses++;
+	assert_true((uintptr_t)addr >= DRAM_START);
+	assert_int_equal(offset % sizeof(uint32_t), 0);
+
+	if (offset >= size) {
+		if (!model.wraps)
+			return -1;
+		offset %= size;
+	}
+	return offset;
+}
+
+static size_t model_find(uintptr_t cell)
+{
+	size_t i;
+
+	for (i = 0; i < model.count; i++)
+		if (model.words[i].cell == cell)
+			break;
+	return i;
+}
+
+uint32_t read32(const volatile void *addr)
+{
+	const intptr_t cell = model_cell(addr);
+	size_t i;
+
+	if (cell < 0)
+		return 0xffffffff;
+
+	i = model_find(cell);
+	if (i < model.count)
+		return model.words[i].value;
+	return cell ^ 0xdeadbeef;
+}
+
+void write32(volatile void *addr, uint32_t value)
+{
+	const intptr_t cell = model_cell(addr);
+	size_t i;
+
+	if (cell < 0)
+		return;
+
+	i = model_find(cell);
+	if (i == model.count) {
+		assert_true(model.count < MODEL_WORDS);
+		model.words[model.count++].cell = cell;
+	}
+	model.words[i].value = value;
+}
+
+void *cbmem_find(u32 id)
+{
+	assert_int_equal(id, CBMEM_ID_RAMDETECT);
+	return cbmem_entry.present ? &cbmem_entry.result : NULL;
+}
+
+static int setup_model(void **state)
+{
+	memset(&model, 0, sizeof(model));
+	memset(&cbmem_entry, 0, sizeof(cbmem_entry));
+	return 0;
+}
+
+/*
+ * The result is remembered for the probe window, so every probe gets a window
+ * no earlier one used. They are all larger than the RAM of the model.
+ */
+static size_t new_window(void)
+{
+	static size_t window = PROBE_SIZE;
+
+	return window++;
+}
+
+/* Every word written by the probes holds its old value again. */
+static void assert_restored(void)
+{
+	size_t i;
+
+	for (i = 0; i < model.count; i++)
+		assert_int_equal(model.words[i].value,
+				 model.words[i].cell ^ 0xdeadbeef);
+}
+
+static void test_sizes(void **state)
+{
+	static const size_t sizes[] = { 1, 2, 3, 128, 512, 768, 1000, 2048, 4095 };
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(sizes); i++) {
+		setup_model(state);
+		model.size = sizes[i];
+		assert_int_equal(probe_ramsize(DRAM_START, new_window()),
+				 sizes[i]);
+		assert_restored();
+	}
+}
+
+static void test_wraparound(void **state)
+{
+	static const size_t sizes[] = { 1, 2, 4, 64, 128, 512, 1024, 2048 };
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(sizes); i++) {
+		setup_model(state);
+		model.size = sizes[i];
+		model.wraps = 1;
+		assert_int_equal(probe_ramsize(DRAM_START, new_window()),
+				 sizes[i]);
+		assert_restored();
+	}
+}
+
+static void test_memoized(void **state)
+{
+	const size_t window = new_window();
+	unsigned int accesses;
+
+	model.size = 768;
+	assert_int_equal(probe_ramsize(DRAM_START, window), 768);
+	accesses = model.accesses;
+	print_message("%u memory accesses for the first probe\n", accesses);
+
+	/* Same stage */
+	model.size = 1;
+	assert_int_equal(probe_ramsize(DRAM_START, window), 768);
+	assert_int_equal(model.accesses, accesses);
+
+	/* Another window is probed again. */
+	assert_int_equal(probe_ramsize(DRAM_START, new_window()), 1);
+	assert_true(model.accesses > accesses);
+}
+
+static void test_cbmem(void **state)
+{
+	const size_t window = new_window();
+
+	/* A previous stage found the size for this window. */
+	cbmem_entry.present = 1;
+	cbmem_entry.result.dram_start = DRAM_START;
+	cbmem_entry.result.probe_size = window;
+	cbmem_entry.result.size = 768;
+	model.size = 1;
+	assert_int_equal(probe_ramsize(DRAM_START, window), 768);
+	assert_int_equal(model.accesses, 0);
+
+	/* Not for another one */
+	assert_int_equal(probe_ramsize(DRAM_START, new_window()), 1);
+	assert_true(model.accesses > 0);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup(test_sizes, setup_model),
+		cmocka_unit_test_setup(test_wraparound, setup_model),
+		cmocka_unit_test_setup(test_memoized, setup_model),
+		cmocka_unit_test_setup(test_cbmem, setup_model),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,417 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <commonlib/helpers.h>
+#include <console/post_codes.h>
+#include <program_loading.h>
+#include <security/tpm/tspi.h>
+#include <security/tpm/tspi/crtm.h>
+#include <security/tpm/tss.h>
+#include <setjmp.h>
+#include <string.h>
+#include <tests/test.h>
+
+/*
+ * Model of a TPM 2.0 with a SHA-256 PCR bank behind the tlcl extend calls. A
+ * command sent with tlcl_extend_start() is done after 'polls' calls of
+ * tlcl_extend_ready(), or never with 'polls' negative. The extends are logged
+ * in the order the TPM does them.
+ */
+
+#define PCR_COUNT	24
+#define DIGEST_SIZE	32
+#define MODEL_LOG_SIZE	64
+#define EXTENDS		20
+/* Extends tspi.c keeps queued at most */
+#define EXTEND_QUEUE_SIZE	8
+
+struct extend {
+	int pcr;
+	uint8_t digest[DIGEST_SIZE];
+};
+
+static struct {
+	uint8_t pcrs[PCR_COUNT][DIGEST_SIZE];
+	int polls;
+	int polls_left;
+	int in_flight;
+	struct extend cmd;
+	/* Number of the command whose tlcl_extend_finish() fails, from 1 */
+	unsigned int fail_cmd;
+	unsigned int cmds;
+	struct extend log[MODEL_LOG_SIZE];
+	size_t log_len;
+} model;
+
+/* Extends passed to tpm_extend_pcr() */
+static size_t queued;
+static jmp_buf die_jmp;
+static int died;
+static u8 last_post_code;
+static int prog_ran;
+
+/* Plain SHA-256, FIPS 180-4, for the PCR bank. */
+static const uint32_t sha256_k[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+	0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+	0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+	0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+	0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+	0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+	0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+	0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+	0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+#define ROR(x, n)	((x) >> (n) | (x) << (32 - (n)))
+
+static void sha256_block(uint32_t h[8], const uint8_t *p)
+{
+	uint32_t w[64], v[8], t1, t2;
+	int i;
+
+	for (i = 0; i < 16; i++)
+		w[i] = (uint32_t)p[4 * i] << 24 | p[4 * i + 1] << 16 |
+		       p[4 * i + 2] << 8 | p[4 * i + 3];
+	for (; i < 64; i++)
+		w[i] = w[i - 16] + w[i - 7] +
+		       (ROR(w[i - 15], 7) ^ ROR(w[i - 15], 18) ^ w[i - 15] >> 3) +
+		       (ROR(w[i - 2], 17) ^ ROR(w[i - 2], 19) ^ w[i - 2] >> 10);
+
+	memcpy(v, h, sizeof(v));
+	for (i = 0; i < 64; i++) {
+		t1 = v[7] + (ROR(v[4], 6) ^ ROR(v[4], 11) ^ ROR(v[4], 25)) +
+		     ((v[4] & v[5]) ^ (~v[4] & v[6])) + sha256_k[i] + w[i];
+		t2 = (ROR(v[0], 2) ^ ROR(v[0], 13) ^ ROR(v[0], 22)) +
+		     ((v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]));
+		memmove(&v[1], &v[0], 7 * sizeof(v[0]));
+		v[4] += t1;
+		v[0] = t1 + t2;
+	}
+	for (i = 0; i < 8; i++)
+		h[i] += v[i];
+}
+
+/* Only what a PCR extend needs: messages shorter than 120 bytes. */
+static void sha256(const uint8_t *data, size_t len, uint8_t *digest)
+{
+	uint32_t h[8] = {
+		0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+		0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+	};
+	uint8_t buf[128] = { 0 };
+	const size_t blocks = len < 56 ? 1 : 2;
+	size_t i;
+
+	assert_true(len < 120);
+	memcpy(buf, data, len);
+	buf[len] = 0x80;
+	for (i = 0; i < 8; i++)
+		buf[blocks * 64 - 1 - i] = (uint64_t)len * 8 >> (8 * i);
+
+	for (i = 0; i < blocks; i++)
+		sha256_block(h, &buf[i * 64]);
+	for (i = 0; i < 32; i++)
+		digest[i] = h[i / 4] >> (24 - 8 * (i % 4));
+}
+
+/* PCR := SHA-256(PCR || digest) */
+static void model_extend(const struct extend *e)
+{
+	uint8_t buf[2 * DIGEST_SIZE];
+
+	assert_in_range(e->pcr, 0, PCR_COUNT - 1);
+	memcpy(buf, model.pcrs[e->pcr], DIGEST_SIZE);
+	memcpy(&buf[DIGEST_SIZE], e->digest, DIGEST_SIZE);
+	sha256(buf, sizeof(buf), model.pcrs[e->pcr]);
+
+	assert_true(model.log_len < MODEL_LOG_SIZE);
+	model.log[model.log_len++] = *e;
+}
+
+static uint32_t model_result(void)
+{
+	return ++model.cmds == model.fail_cmd ? TPM_E_IOERROR : TPM_SUCCESS;
+}
+
+uint32_t tlcl_lib_init(void)
+{
+	return TPM_SUCCESS;
+}
+
+uint32_t tlcl_startup(void)
+{
+	return TPM_SUCCESS;
+}
+
+uint32_t tlcl_resume(void)
+{
+	return TPM_SUCCESS;
+}
+
+uint32_t tlcl_assert_physical_presence(void)
+{
+	return TPM_SUCCESS;
+}
+
+uint32_t tlcl_physical_presence_cmd_enable(void)
+{
+	return TPM_SUCCESS;
+}
+
+int tspi_measure_cache_to_pcr(void)
+{
+	return 0;
+}
+
+uint32_t tlcl_extend(int pcr_num, const uint8_t *in_digest,
+		     uint8_t *out_digest)
+{
+	struct extend e = { .pcr = pcr_num };
+
+	assert_false(model.in_flight);
+	memcpy(e.digest, in_digest, DIGEST_SIZE);
+	model_extend(&e);
+	return model_result();
+}
+
+uint32_t tlcl_extend_start(int pcr_num, const uint8_t *in_digest)
+{
+	assert_false(model.in_flight);
+	model.cmd.pcr = pcr_num;
+	memcpy(model.cmd.digest, in_digest, DIGEST_SIZE);
+	model.in_flight = 1;
+	model.polls_left = model.polls;
+	return TPM_SUCCESS;
+}
+
+int tlcl_extend_ready(void)
+{
+	assert_true(model.in_flight);
+	if (!model.polls_left)
+		return 1;
+	if (model.polls_left > 0)
+		model.polls_left--;
+	return 0;
+}
+
+uint32_t tlcl_extend_finish(void)
+{
+	assert_true(model.in_flight);
+	model.in_flight = 0;
+	model_extend(&model.cmd);
+	return model_result();
+}
+
+void tcpa_log_add_table_entry(const char *name, const uint32_t pcr,
+			      enum vb2_hash_algorithm digest_algo,
+			      const uint8_t *digest, const size_t digest_len)
+{
+}
+
+void post_code(u8 value)
+{
+	last_post_code = value;
+}
+
+void die(const char *fmt, ...)
+{
+	died = 1;
+	longjmp(die_jmp, 1);
+}
+
+void arch_prog_run(struct prog *prog)
+{
+	/* Everything is in the PCRs before the next stage runs. */
+	assert_int_equal(model.log_len, queued);
+	assert_false(model.in_flight);
+	prog_ran = 1;
+}
+
+static int setup_model(void **state)
+{
+	memset(&model, 0, sizeof(model));
+	died = 0;
+	last_post_code = 0;
+	prog_ran = 0;
+	queued = 0;
+	return 0;
+}
+
+static int setup_tpm(void **state)
+{
+	return tpm_setup(0);
+}
+
+/* Digests of files loaded at boot, spread over a few PCRs */
+static void test_extend(size_t i, struct extend *e)
+{
+	size_t j;
+
+	e->pcr = i % 3 ? 2 : 0;
+	for (j = 0; j < DIGEST_SIZE; j++)
+		e->digest[j] = i * 37 + j;
+}
+
+static void queue_extend(size_t i)
+{
+	struct extend e;
+
+	test_extend(i, &e);
+	assert_int_equal(tpm_extend_pcr(e.pcr, VB2_HASH_SHA256, e.digest,
+					DIGEST_SIZE, "file"), TPM_SUCCESS);
+	queued++;
+	assert_true(queued - model.log_len <= EXTEND_QUEUE_SIZE);
+}
+
+/* The PCRs after doing the extends one by one, as without the queue */
+static void direct_pcrs(size_t extends, uint8_t pcrs[PCR_COUNT][DIGEST_SIZE])
+{
+	struct extend e;
+	size_t i;
+
+	setup_model(NULL);
+	for (i = 0; i < extends; i++) {
+		test_extend(i, &e);
+		assert_int_equal(tlcl_extend(e.pcr, e.digest, NULL),
+				 TPM_SUCCESS);
+	}
+	memcpy(pcrs, model.pcrs, sizeof(model.pcrs));
+	setup_model(NULL);
+}
+
+/* The TPM did the extends in the order they were queued. */
+static void assert_in_order(size_t extends)
+{
+	struct extend e;
+	size_t i;
+
+	assert_int_equal(model.log_len, extends);
+	for (i = 0; i < extends; i++) {
+		test_extend(i, &e);
+		assert_int_equal(model.log[i].pcr, e.pcr);
+		assert_memory_equal(model.log[i].digest, e.digest, DIGEST_SIZE);
+	}
+}
+
+static void test_order(void **state)
+{
+	static const int polls[] = { 0, 1, 3, -1 };
+	uint8_t pcrs[PCR_COUNT][DIGEST_SIZE];
+	size_t i, j;
+
+	direct_pcrs(EXTENDS, pcrs);
+
+	for (i = 0; i < ARRAY_SIZE(polls); i++) {
+		setup_model(state);
+		model.polls = polls[i];
+		for (j = 0; j < EXTENDS; j++)
+			queue_extend(j);
+		tpm_flush_pcr_extends();
+
+		assert_false(died);
+		assert_false(model.in_flight);
+		assert_in_order(EXTENDS);
+		assert_memory_equal(model.pcrs, pcrs, sizeof(pcrs));
+	}
+}
+
+static void test_stage_exit(void **state)
+{
+	struct prog prog = PROG_INIT(PROG_RAMSTAGE, "fallback/ramstage");
+	uint8_t pcrs[PCR_COUNT][DIGEST_SIZE];
+	size_t i;
+
+	direct_pcrs(3, pcrs);
+
+	model.polls = -1;
+	for (i = 0; i < 3; i++)
+		queue_extend(i);
+	assert_int_equal(model.log_len, 0);
+
+	prog_run(&prog);
+	assert_true(prog_ran);
+	assert_in_order(3);
+	assert_memory_equal(model.pcrs, pcrs, sizeof(pcrs));
+}
+
+static void test_finish_error(void **state)
+{
+	/*
+	 * The failing extend is collected while queueing, waited for in the
+	 * flush while in flight, or done by the flush without the queue.
+	 */
+	static const struct {
+		int polls;
+		unsigned int fail_cmd;
+	} cases[] = { { 2, 2 }, { -1, 1 }, { -1, 3 } };
+	size_t i, j;
+
+	for (i = 0; i < ARRAY_SIZE(cases); i++) {
+		setup_model(state);
+		model.polls = cases[i].polls;
+		model.fail_cmd = cases[i].fail_cmd;
+		for (j = 0; j < 5; j++)
+			queue_extend(j);
+
+		if (!setjmp(die_jmp))
+			tpm_flush_pcr_extends();
+
+		/* The failure stops the boot, after the other extends are done. */
+		assert_true(died);
+		assert_int_equal(last_post_code, POST_TPM_FAILURE);
+		assert_false(model.in_flight);
+		assert_in_order(5);
+	}
+}
+
+static void test_queue_full(void **state)
+{
+	uint8_t pcrs[PCR_COUNT][DIGEST_SIZE];
+	size_t i;
+
+	direct_pcrs(EXTENDS, pcrs);
+
+	/* The TPM never reports being done, adding waits for the oldest. */
+	model.polls = -1;
+	for (i = 0; i < EXTENDS; i++) {
+		queue_extend(i);
+		assert_int_equal(model.log_len,
+				 i < EXTEND_QUEUE_SIZE ? 0 :
+				 i + 1 - EXTEND_QUEUE_SIZE);
+	}
+	tpm_flush_pcr_extends();
+
+	assert_false(died);
+	assert_in_order(EXTENDS);
+	assert_memory_equal(model.pcrs, pcrs, sizeof(pcrs));
+}
+
+static void test_sha256(void **state)
+{
+	/* FIPS 180-2, appendix B.1 */
+	static const uint8_t abc_digest[DIGEST_SIZE] = {
+		0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea,
+		0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+		0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c,
+		0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad,
+	};
+	uint8_t digest[DIGEST_SIZE];
+
+	sha256((const uint8_t *)"abc", 3, digest);
+	assert_memory_equal(digest, abc_digest, DIGEST_SIZE);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_sha256),
+		cmocka_unit_test_setup(test_order, setup_model),
+		cmocka_unit_test_setup(test_stage_exit, setup_model),
+		cmocka_unit_test_setup(test_finish_error, setup_model),
+		cmocka_unit_test_setup(test_queue_full, setup_model),
+	};
+
+	return cmocka_run_group_tests(tests, setup_tpm, NULL);
+}
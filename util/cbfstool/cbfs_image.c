@@ -629,6 +629,189 @@ int cbfs_compact_instance(struct cbfs_image *image)
 	return 0;
 }
 
+/*
+ * Returns true for a stage linked to run from where it is in the memory mapped boot media,
+ * as `add-stage --xip` creates them. 'mmap_base' is the address the start of the region is
+ * mapped to.
+ */
+static bool cbfs_stage_is_xip(struct cbfs_image *image, struct cbfs_file *file,
+			      uint32_t mmap_base)
+{
+	struct buffer reader;
+	uint32_t data_addr;
+	uint64_t load;
+
+	if (ntohl(file->type) != CBFS_COMPONENT_STAGE ||
+	    cbfs_file_entry_data_size(file) < sizeof(struct cbfs_stage))
+		return false;
+
+	/* The stage metadata is in little endian. */
+	buffer_init(&reader, NULL, CBFS_SUBHEADER(file), sizeof(struct cbfs_stage));
+	xdr_le.get32(&reader);	/* compression */
+	xdr_le.get64(&reader);	/* entry */
+	load = xdr_le.get64(&reader);
+
+	data_addr = cbfs_get_entry_addr(image, file) + ntohl(file->offset) +
+		    sizeof(struct cbfs_stage);
+	return load == (uint32_t)(mmap_base + data_addr);
+}
+
+/*
+ * Returns true if a file has to stay where it is when reordering. Files placed at one of the
+ * 'pinned' offsets, XIP stages and the files that are fixed by nature are known. Files placed
+ * at another offset or alignment can't be recognized reliably after the fact, so be
+ * conservative: anything that carries a position attribute, has padding between its metadata
+ * and data or doesn't directly follow the previous file was most likely placed with -b, -a or
+ * -P.
+ */
+static bool cbfs_file_is_pinned(struct cbfs_image *image, const struct cbfs_file *prev,
+				struct cbfs_file *file, const uint32_t pinned[],
+				size_t pinned_count, uint32_t mmap_base)
+{
+	struct cbfs_file_attribute *attr;
+	size_t metadata_size, i;
+	uint32_t data_offset;
+
+	switch (ntohl(file->type)) {
+	case CBFS_COMPONENT_BOOTBLOCK:
+	case CBFS_COMPONENT_CBFSHEADER:
+		return true;
+	}
+
+	data_offset = cbfs_get_entry_addr(image, file) + ntohl(file->offset);
+	for (i = 0; i < pinned_count; i++)
+		if (data_offset == pinned[i])
+			return true;
+
+	if (cbfs_stage_is_xip(image, file, mmap_base))
+		return true;
+
+	if (prev && (ntohl(prev->type) == CBFS_COMPONENT_NULL ||
+		     ntohl(prev->type) == CBFS_COMPONENT_DELETED))
+		return true;
+
+	metadata_size = cbfs_calculate_file_header_size(file->filename);
+	for (attr = cbfs_file_first_attr(file); attr;
+	     attr = cbfs_file_next_attr(file, attr)) {
+		if (ntohl(attr->tag) == CBFS_FILE_ATTR_TAG_POSITION)
+			return true;
+		metadata_size = (uint8_t *)attr + ntohl(attr->len) - (uint8_t *)file;
+	}
+
+	return cbfs_file_entry_metadata_size(file) > metadata_size;
+}
+
+struct cbfs_reorder_entry {
+	struct cbfs_file *header;
+	struct buffer data;
+	bool placed;
+};
+
+static int cbfs_reorder_add(struct cbfs_image *image,
+			    struct cbfs_reorder_entry *entry)
+{
+	entry->placed = true;
+	return cbfs_add_entry(image, &entry->data, 0, entry->header, 0);
+}
+
+int cbfs_reorder_instance(struct cbfs_image *image, const char *const names[],
+			  size_t count, const uint32_t pinned[],
+			  size_t pinned_count, uint32_t mmap_base)
+{
+	assert(image);
+
+	struct cbfs_reorder_entry *entries = NULL;
+	struct cbfs_file *prev = NULL, *cur;
+	struct buffer original;
+	size_t num_entries = 0, num_pinned = 0, i, j;
+	int ret = 1;
+
+	/* Reordering is an optimization, a failure must not break the image. */
+	if (buffer_create(&original, buffer_size(&image->buffer), "original"))
+		return 1;
+	memcpy(buffer_get(&original), buffer_get(&image->buffer),
+	       buffer_size(&original));
+
+	/* Take a copy of every file that may move... */
+	for (cur = cbfs_find_first_entry(image);
+	     cur && cbfs_is_valid_entry(image, cur);
+	     prev = cur, cur = cbfs_find_next_entry(image, cur)) {
+		uint32_t type = ntohl(cur->type);
+		struct cbfs_reorder_entry *entry;
+
+		if (type == CBFS_COMPONENT_NULL || type == CBFS_COMPONENT_DELETED)
+			continue;
+
+		if (cbfs_file_is_pinned(image, prev, cur, pinned, pinned_count,
+					mmap_base)) {
+			DEBUG("Keeping '%s' at 0x%x\n", cur->filename,
+			      cbfs_get_entry_addr(image, cur));
+			num_pinned++;
+			continue;
+		}
+
+		entry = realloc(entries, (num_entries + 1) * sizeof(*entries));
+		if (!entry)
+			goto out;
+		entries = entry;
+		entry = &entries[num_entries];
+		memset(entry, 0, sizeof(*entry));
+		num_entries++;
+
+		entry->header = malloc(cbfs_file_entry_metadata_size(cur));
+		if (!entry->header ||
+		    buffer_create(&entry->data, cbfs_file_entry_data_size(cur),
+				  cur->filename))
+			goto out;
+		memcpy(entry->header, cur, cbfs_file_entry_metadata_size(cur));
+		memcpy(buffer_get(&entry->data), CBFS_SUBHEADER(cur),
+		       cbfs_file_entry_data_size(cur));
+	}
+
+	/* ...then take them all out... */
+	for (i = 0; i < num_entries; i++)
+		if (cbfs_remove_entry(image, entries[i].header->filename))
+			goto out;
+
+	/* ...and put them back, files in the access order first. */
+	for (i = 0; i < count; i++) {
+		for (j = 0; j < num_entries; j++)
+			if (!entries[j].placed &&
+			    !strcasecmp(entries[j].header->filename, names[i]))
+				break;
+		if (j == num_entries) {
+			INFO("'%s' is not a movable file, skipping.\n", names[i]);
+			continue;
+		}
+		if (cbfs_reorder_add(image, &entries[j]))
+			goto out;
+	}
+
+	for (j = 0; j < num_entries; j++)
+		if (!entries[j].placed && cbfs_reorder_add(image, &entries[j]))
+			goto out;
+
+	INFO("Reordered %zu files, kept %zu in place.\n", num_entries,
+	     num_pinned);
+	ret = 0;
+
+out:
+	if (ret) {
+		WARN("Reordering failed, keeping the original layout.\n");
+		memcpy(buffer_get(&image->buffer), buffer_get(&original),
+		       buffer_size(&original));
+		ret = 0;
+	}
+
+	for (i = 0; i < num_entries; i++) {
+		free(entries[i].header);
+		buffer_delete(&entries[i].data);
+	}
+	free(entries);
+	buffer_delete(&original);
+	return ret;
+}
+
 int cbfs_image_delete(struct cbfs_image *image)
 {
 	if (image == NULL)
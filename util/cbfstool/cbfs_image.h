@@ -68,6 +68,19 @@ int cbfs_copy_instance(struct cbfs_image *image, struct buffer *dst);
  * beginning of the image. Returns 0 on success, otherwise non-zero.  */
 int cbfs_compact_instance(struct cbfs_image *image);
 
+#define CBFS_REORDER_MAX_PINNED 64
+
+/* Reorder a CBFS image so that the named files come first, in the given order,
+ * followed by the remaining files. Files whose data starts at one of the
+ * 'pinned' offsets keep their location, as do stages that execute in place at
+ * 'mmap_base' + offset and files that look like they were placed at a fixed
+ * offset or alignment. If the files can't be put back, the original layout is
+ * restored with a warning. Returns non-zero only if the image couldn't be
+ * backed up to begin with. */
+int cbfs_reorder_instance(struct cbfs_image *image, const char *const names[],
+			  size_t count, const uint32_t pinned[],
+			  size_t pinned_count, uint32_t mmap_base);
+
 /* Expand a CBFS image inside an fmap region to the entire region's space.
    Returns 0 on success, otherwise non-zero. */
 int cbfs_expand_to_region(struct buffer *region);
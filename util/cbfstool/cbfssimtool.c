@@ -0,0 +1,726 @@
+/* cbfs-sim-tool, CLI utility simulating boot media accesses of CBFS loads */
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <commonlib/cbfs.h>
+#include <commonlib/endian.h>
+#include <commonlib/helpers.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "flashmap/fmap.h"
+
+/* Used by the printk() wrapper in console/console.h, which commonlib cbfs.c logs through. */
+int verbose;
+
+static const char *usage_text = "cbfs-sim-tool [options] coreboot.rom [list]\n"
+	"  Replays the CBFS lookups and loads of a boot against coreboot.rom and\n"
+	"  reports the resulting boot media traffic and a modeled SPI read time.\n"
+	"\n"
+	"  -r, --region NAME      FMAP region holding the CBFS (default: COREBOOT)\n"
+	"  -l, --log              list is a coreboot console log instead of a file list\n"
+	"  -f, --freq MHZ         SPI clock in MHz (default: 33)\n"
+	"  -m, --mode MODE        read, fast, dual-out, dual-io, quad-out or quad-io\n"
+	"                         (default: fast)\n"
+	"  -x, --max-xfer BYTES   largest single read transaction the controller issues\n"
+	"                         (default: 0, unlimited)\n"
+	"  -o, --overhead NS      fixed cost per transaction in ns (default: 0)\n"
+	"  -c, --cache BYTES      model a LRU read cache of 4KiB lines in front of the\n"
+	"                         boot device (default: 0, no cache)\n"
+	"  -v, --verbose          print every boot media transaction\n"
+	"  -h, --help             show this help\n"
+	"\n"
+	"The list is read from stdin when not given. Each line is one of:\n"
+	"  @STAGE                 attribute the following accesses to STAGE\n"
+	"  locate NAME            only look NAME up\n"
+	"  [load] NAME            look NAME up and load it the way its type is\n"
+	"                         loaded by coreboot (stage, payload, other files)\n"
+	"Empty lines and lines starting with '#' are ignored. With --log, every\n"
+	"\"CBFS: Locating 'NAME'\" line is loaded and every \"STAGE starting\" banner\n"
+	"starts a new stage.\n";
+
+#define CACHE_LINE_SIZE	(4 * KiB)
+#define NAME_LEN	64
+
+struct spi_mode {
+	const char *name;
+	/* Clock cycles spent on the opcode, the address and dummy/mode bits. */
+	unsigned int cmd, addr, dummy;
+	/* Number of lanes used for data. */
+	unsigned int lanes;
+};
+
+static const struct spi_mode spi_modes[] = {
+	{ "read",	8, 24, 0, 1 },	/* 03h */
+	{ "fast",	8, 24, 8, 1 },	/* 0Bh */
+	{ "dual-out",	8, 24, 8, 2 },	/* 3Bh */
+	{ "dual-io",	8, 12, 4, 2 },	/* BBh */
+	{ "quad-out",	8, 24, 8, 4 },	/* 6Bh */
+	{ "quad-io",	8, 6, 6, 4 },	/* EBh */
+};
+
+struct access_stats {
+	unsigned long reads;
+	unsigned long long bytes;
+	unsigned long long redundant;
+	double time_ns;
+};
+
+struct sim_op {
+	char stage[NAME_LEN];
+	char name[NAME_LEN];
+	bool load;
+	bool found;
+	uint32_t type;
+	uint32_t compression;
+	size_t in_size;
+	size_t out_size;
+	struct access_stats lookup;
+	struct access_stats loading;
+};
+
+static struct {
+	const struct spi_mode *mode;
+	double freq_mhz;
+	size_t max_xfer;
+	double overhead_ns;
+	size_t cache_size;
+} params = {
+	.mode = &spi_modes[1],
+	.freq_mhz = 33,
+};
+
+static struct {
+	uint8_t *image;
+	size_t size;
+	/* One bit per byte of the image that has been read from the boot device before. */
+	uint8_t *seen;
+	/* Cache line tags and last use, for the optional read cache model. */
+	size_t *cache_tag;
+	unsigned long *cache_used;
+	size_t cache_lines;
+	unsigned long clock;
+	unsigned long cache_hits, cache_misses;
+	struct access_stats *cur;
+} sim;
+
+static void account_transaction(size_t offset, size_t size)
+{
+	const struct spi_mode *m = params.mode;
+	struct access_stats *s = sim.cur;
+	unsigned long long clocks;
+
+	clocks = m->cmd + m->addr + m->dummy + DIV_ROUND_UP(size * 8, m->lanes);
+
+	s->reads++;
+	s->bytes += size;
+	s->time_ns += clocks * 1000.0 / params.freq_mhz + params.overhead_ns;
+
+	for (size_t i = offset; i < offset + size; i++) {
+		if (sim.seen[i / 8] & (1 << (i % 8)))
+			s->redundant++;
+		sim.seen[i / 8] |= 1 << (i % 8);
+	}
+
+	if (verbose)
+		printf("    read %#9zx +%#zx\n", offset, size);
+}
+
+static void spi_read(size_t offset, size_t size)
+{
+	while (size) {
+		size_t chunk = params.max_xfer ? MIN(size, params.max_xfer) : size;
+
+		account_transaction(offset, chunk);
+		offset += chunk;
+		size -= chunk;
+	}
+}
+
+/* Returns true on a hit, otherwise evicts the least recently used line for the new tag. */
+static bool cache_lookup(size_t tag)
+{
+	size_t victim = 0;
+
+	sim.clock++;
+	for (size_t i = 0; i < sim.cache_lines; i++) {
+		if (sim.cache_used[i] && sim.cache_tag[i] == tag) {
+			sim.cache_used[i] = sim.clock;
+			sim.cache_hits++;
+			return true;
+		}
+		if (sim.cache_used[i] < sim.cache_used[victim])
+			victim = i;
+	}
+
+	sim.cache_tag[victim] = tag;
+	sim.cache_used[victim] = sim.clock;
+	sim.cache_misses++;
+	return false;
+}
+
+static void boot_media_read(size_t offset, size_t size)
+{
+	if (!size)
+		return;
+
+	if (!sim.cache_lines) {
+		spi_read(offset, size);
+		return;
+	}
+
+	for (size_t line = offset / CACHE_LINE_SIZE;
+	     line <= (offset + size - 1) / CACHE_LINE_SIZE; line++) {
+		size_t start = line * CACHE_LINE_SIZE;
+
+		if (!cache_lookup(line))
+			spi_read(start, MIN(CACHE_LINE_SIZE, sim.size - start));
+	}
+}
+
+/*
+ * The simulated boot device. Like the SPI boot devices in coreboot, mappings are served from
+ * a buffer that is filled by reading the whole requested range.
+ */
+static void *sim_mmap(const struct region_device *rd __unused, size_t offset, size_t size)
+{
+	void *mapping = malloc(size);
+
+	if (!mapping)
+		return NULL;
+
+	boot_media_read(offset, size);
+	memcpy(mapping, sim.image + offset, size);
+	return mapping;
+}
+
+static int sim_munmap(const struct region_device *rd __unused, void *mapping)
+{
+	free(mapping);
+	return 0;
+}
+
+static ssize_t sim_readat(const struct region_device *rd __unused, void *b, size_t offset,
+			  size_t size)
+{
+	boot_media_read(offset, size);
+	memcpy(b, sim.image + offset, size);
+	return size;
+}
+
+static const struct region_device_ops sim_ops = {
+	.mmap = sim_mmap,
+	.munmap = sim_munmap,
+	.readat = sim_readat,
+};
+
+/* Mirrors the accesses of cbfs_prog_stage_load() for a stage that isn't executed in place. */
+static int load_stage(struct sim_op *op, const struct region_device *data)
+{
+	struct cbfs_stage stage;
+	void *mapping;
+
+	if (rdev_readat(data, &stage, 0, sizeof(stage)) != sizeof(stage))
+		return -1;
+
+	op->compression = read_le32(&stage.compression);
+	op->in_size = read_le32(&stage.len);
+	op->out_size = read_le32(&stage.memlen);
+
+	/* LZ4 and uncompressed stages are read into memory, LZMA decompresses from a mapping. */
+	if (op->compression == CBFS_COMPRESS_LZMA) {
+		mapping = rdev_mmap(data, sizeof(stage), op->in_size);
+		if (!mapping)
+			return -1;
+		rdev_munmap(data, mapping);
+		return 0;
+	}
+
+	mapping = malloc(op->in_size);
+	if (!mapping)
+		return -1;
+	if (rdev_readat(data, mapping, sizeof(stage), op->in_size) != (ssize_t)op->in_size) {
+		free(mapping);
+		return -1;
+	}
+	free(mapping);
+	return 0;
+}
+
+/* Mirrors payload_load(), which maps the whole file and walks the segments in the mapping. */
+static int load_payload(struct sim_op *op, const struct region_device *data)
+{
+	const struct cbfs_payload_segment *seg;
+	uint8_t *mapping = rdev_mmap_full(data);
+
+	if (!mapping)
+		return -1;
+
+	op->in_size = region_device_sz(data);
+	op->out_size = 0;
+	for (seg = (void *)mapping; (const uint8_t *)(seg + 1) <= mapping + op->in_size; seg++) {
+		uint32_t type = read_be32(&seg->type);
+
+		if (type == PAYLOAD_SEGMENT_ENTRY)
+			break;
+		if (type == PAYLOAD_SEGMENT_CODE || type == PAYLOAD_SEGMENT_DATA ||
+		    type == PAYLOAD_SEGMENT_BSS) {
+			op->out_size += read_be32(&seg->mem_len);
+			op->compression |= read_be32(&seg->compression);
+		}
+	}
+
+	rdev_munmap(data, mapping);
+	return 0;
+}
+
+/* Mirrors cbfs_boot_load_file() and cbfs_load_and_decompress() for all other files. */
+static int load_file(struct sim_op *op, struct cbfsf *fh)
+{
+	uint32_t compression;
+	size_t size;
+	void *buf;
+
+	if (cbfsf_decompression_info(fh, &compression, &size))
+		return -1;
+
+	op->compression = compression;
+	op->in_size = region_device_sz(&fh->data);
+	op->out_size = size;
+
+	if (compression != CBFS_COMPRESS_NONE) {
+		buf = rdev_mmap_full(&fh->data);
+		if (!buf)
+			return -1;
+		rdev_munmap(&fh->data, buf);
+		return 0;
+	}
+
+	buf = malloc(op->in_size);
+	if (!buf)
+		return -1;
+	if (rdev_readat(&fh->data, buf, 0, op->in_size) != (ssize_t)op->in_size) {
+		free(buf);
+		return -1;
+	}
+	free(buf);
+	return 0;
+}
+
+static int simulate(struct sim_op *op, const struct region_device *cbfs)
+{
+	struct cbfsf fh;
+	int ret;
+
+	if (verbose)
+		printf("%s: %s '%s'\n", op->stage, op->load ? "load" : "locate", op->name);
+
+	sim.cur = &op->lookup;
+	if (cbfs_locate(&fh, cbfs, op->name, NULL))
+		return 0;
+	op->found = true;
+	if (cbfsf_file_type(&fh, &op->type))
+		return -1;
+	op->in_size = region_device_sz(&fh.data);
+
+	if (!op->load)
+		return 0;
+
+	sim.cur = &op->loading;
+	switch (op->type) {
+	case CBFS_TYPE_STAGE:
+		ret = load_stage(op, &fh.data);
+		break;
+	case CBFS_TYPE_SELF:
+		ret = load_payload(op, &fh.data);
+		break;
+	default:
+		ret = load_file(op, &fh);
+	}
+
+	if (ret)
+		fprintf(stderr, "E: Failed to load '%s'\n", op->name);
+	return ret;
+}
+
+static char *strip(char *s)
+{
+	char *end;
+
+	while (*s == ' ' || *s == '\t')
+		s++;
+	end = s + strlen(s);
+	while (end > s && (end[-1] == '\n' || end[-1] == '\r' || end[-1] == ' ' ||
+			   end[-1] == '\t'))
+		*--end = '\0';
+	return s;
+}
+
+/* Parses one line of the list into op. Returns 1 if op was filled in, 0 otherwise. */
+static int parse_list_line(char *line, char *stage, struct sim_op *op)
+{
+	line = strip(line);
+
+	if (!*line || *line == '#')
+		return 0;
+	if (*line == '@') {
+		snprintf(stage, NAME_LEN, "%s", strip(line + 1));
+		return 0;
+	}
+
+	op->load = true;
+	if (!strncmp(line, "locate ", 7)) {
+		op->load = false;
+		line = strip(line + 7);
+	} else if (!strncmp(line, "load ", 5)) {
+		line = strip(line + 5);
+	}
+	snprintf(op->name, sizeof(op->name), "%s", line);
+	return 1;
+}
+
+/* Picks lookups and stage banners out of a coreboot console log. */
+static int parse_log_line(char *line, char *stage, struct sim_op *op)
+{
+	const char *key = "CBFS: Locating '";
+	char *p, *end;
+
+	p = strstr(line, " starting");
+	if (p && strstr(line, "coreboot-")) {
+		end = p;
+		while (p > line && p[-1] != ' ')
+			p--;
+		snprintf(stage, NAME_LEN, "%.*s", (int)(end - p), p);
+		return 0;
+	}
+
+	p = strstr(line, key);
+	if (!p)
+		return 0;
+	p += strlen(key);
+	end = strchr(p, '\'');
+	if (!end)
+		return 0;
+
+	op->load = true;
+	snprintf(op->name, sizeof(op->name), "%.*s", (int)(end - p), p);
+	return 1;
+}
+
+static int read_ops(FILE *f, bool is_log, struct sim_op **ops, size_t *count)
+{
+	char line[512], stage[NAME_LEN] = "boot";
+	size_t alloc = 0;
+
+	*ops = NULL;
+	*count = 0;
+
+	while (fgets(line, sizeof(line), f)) {
+		struct sim_op op = { 0 };
+		int ret;
+
+		if (is_log)
+			ret = parse_log_line(line, stage, &op);
+		else
+			ret = parse_list_line(line, stage, &op);
+		if (!ret)
+			continue;
+
+		if (*count == alloc) {
+			struct sim_op *n;
+
+			alloc = alloc ? alloc * 2 : 32;
+			n = realloc(*ops, alloc * sizeof(**ops));
+			if (!n)
+				return -1;
+			*ops = n;
+		}
+		snprintf(op.stage, sizeof(op.stage), "%s", stage);
+		(*ops)[(*count)++] = op;
+	}
+
+	return 0;
+}
+
+static int read_image(const char *path)
+{
+	FILE *f = fopen(path, "rb");
+	long size;
+
+	if (!f) {
+		fprintf(stderr, "E: Could not open '%s'\n", path);
+		return -1;
+	}
+	if (fseek(f, 0, SEEK_END) || (size = ftell(f)) <= 0 || fseek(f, 0, SEEK_SET)) {
+		fprintf(stderr, "E: Could not determine size of '%s'\n", path);
+		fclose(f);
+		return -1;
+	}
+
+	sim.size = size;
+	sim.image = malloc(sim.size);
+	sim.seen = calloc(DIV_ROUND_UP(sim.size, 8), 1);
+	if (!sim.image || !sim.seen || fread(sim.image, sim.size, 1, f) != 1) {
+		fprintf(stderr, "E: Could not read '%s'\n", path);
+		fclose(f);
+		return -1;
+	}
+
+	fclose(f);
+	return 0;
+}
+
+static int find_cbfs(const char *region_name, struct region_device *cbfs)
+{
+	long fmap_offset = fmap_find(sim.image, sim.size);
+	const struct fmap_area *area;
+
+	region_device_init(cbfs, &sim_ops, 0, sim.size);
+
+	if (fmap_offset < 0) {
+		fprintf(stderr, "W: No FMAP found, treating the whole image as CBFS\n");
+		return 0;
+	}
+
+	area = fmap_find_area((const struct fmap *)(sim.image + fmap_offset), region_name);
+	if (!area) {
+		fprintf(stderr, "E: FMAP region '%s' not found\n", region_name);
+		return -1;
+	}
+
+	region_device_init(cbfs, &sim_ops, read_le32(&area->offset), read_le32(&area->size));
+	if (region_device_offset(cbfs) + region_device_sz(cbfs) > sim.size) {
+		fprintf(stderr, "E: FMAP region '%s' exceeds the image\n", region_name);
+		return -1;
+	}
+
+	return 0;
+}
+
+static void add_stats(struct access_stats *sum, const struct access_stats *s)
+{
+	sum->reads += s->reads;
+	sum->bytes += s->bytes;
+	sum->redundant += s->redundant;
+	sum->time_ns += s->time_ns;
+}
+
+static const char *type_name(const struct sim_op *op)
+{
+	if (!op->found)
+		return "missing";
+
+	switch (op->type) {
+	case CBFS_TYPE_STAGE:
+		return "stage";
+	case CBFS_TYPE_SELF:
+		return "payload";
+	case CBFS_TYPE_FIT:
+		return "fit";
+	case CBFS_TYPE_MICROCODE:
+		return "microcode";
+	case CBFS_TYPE_FSP:
+		return "fsp";
+	case CBFS_TYPE_OPTIONROM:
+		return "optionrom";
+	case CBFS_TYPE_BOOTSPLASH:
+		return "bootsplash";
+	default:
+		return "raw";
+	}
+}
+
+static const char *compression_name(uint32_t compression)
+{
+	switch (compression) {
+	case CBFS_COMPRESS_NONE:
+		return "none";
+	case CBFS_COMPRESS_LZMA:
+		return "LZMA";
+	case CBFS_COMPRESS_LZ4:
+		return "LZ4";
+	default:
+		return "mixed";
+	}
+}
+
+static void print_total(const char *what, const struct access_stats *lookup,
+			const struct access_stats *loading)
+{
+	printf("%-36s %6lu %10llu %6lu %10llu %10llu %10.1f\n", what,
+	       lookup->reads, lookup->bytes, loading->reads, loading->bytes,
+	       lookup->redundant + loading->redundant,
+	       (lookup->time_ns + loading->time_ns) / 1000);
+}
+
+static void report(const struct sim_op *ops, size_t count)
+{
+	struct access_stats lookup = { 0 }, loading = { 0 };
+	struct access_stats stage_lookup = { 0 }, stage_loading = { 0 };
+	unsigned long long unique = 0;
+
+	printf("SPI %s at %.1f MHz, ", params.mode->name, params.freq_mhz);
+	if (params.max_xfer)
+		printf("max %zu bytes per read, ", params.max_xfer);
+	printf("%.0f ns per read", params.overhead_ns);
+	if (params.cache_size)
+		printf(", %zu KiB read cache", params.cache_size / KiB);
+	printf("\n\n");
+
+	printf("%-20s %-9s %-5s %6s %10s %6s %10s %10s %10s\n", "File", "Type", "Comp",
+	       "Lookup", "Bytes", "Load", "Bytes", "Redundant", "Time (us)");
+
+	for (size_t i = 0; i < count; i++) {
+		const struct sim_op *op = &ops[i];
+
+		if (!i || strcmp(op->stage, ops[i - 1].stage))
+			printf("[%s]\n", op->stage);
+
+		printf("%-20s %-9s %-5s %6lu %10llu %6lu %10llu %10llu %10.1f\n", op->name,
+		       type_name(op), op->load && op->found ?
+				compression_name(op->compression) : "-",
+		       op->lookup.reads, op->lookup.bytes, op->loading.reads,
+		       op->loading.bytes, op->lookup.redundant + op->loading.redundant,
+		       (op->lookup.time_ns + op->loading.time_ns) / 1000);
+
+		add_stats(&stage_lookup, &op->lookup);
+		add_stats(&stage_loading, &op->loading);
+
+		if (i + 1 == count || strcmp(op->stage, ops[i + 1].stage)) {
+			char what[NAME_LEN + 8];
+
+			snprintf(what, sizeof(what), "%s total", op->stage);
+			print_total(what, &stage_lookup, &stage_loading);
+			add_stats(&lookup, &stage_lookup);
+			add_stats(&loading, &stage_loading);
+			memset(&stage_lookup, 0, sizeof(stage_lookup));
+			memset(&stage_loading, 0, sizeof(stage_loading));
+		}
+	}
+
+	for (size_t i = 0; i < DIV_ROUND_UP(sim.size, 8); i++)
+		unique += __builtin_popcount(sim.seen[i]);
+
+	printf("\n");
+	print_total("Total", &lookup, &loading);
+	printf("\n%lu reads, %llu bytes read, %llu unique, %llu redundant, %.3f ms\n",
+	       lookup.reads + loading.reads, lookup.bytes + loading.bytes, unique,
+	       lookup.redundant + loading.redundant, (lookup.time_ns + loading.time_ns) / 1e6);
+	if (params.cache_size)
+		printf("Read cache: %lu line hits, %lu line misses\n", sim.cache_hits,
+		       sim.cache_misses);
+}
+
+static void usage(void)
+{
+	fputs(usage_text, stderr);
+}
+
+int main(int argc, char *argv[])
+{
+	static const struct option long_options[] = {
+		{"region",	required_argument,	0, 'r'},
+		{"log",		no_argument,		0, 'l'},
+		{"freq",	required_argument,	0, 'f'},
+		{"mode",	required_argument,	0, 'm'},
+		{"max-xfer",	required_argument,	0, 'x'},
+		{"overhead",	required_argument,	0, 'o'},
+		{"cache",	required_argument,	0, 'c'},
+		{"verbose",	no_argument,		0, 'v'},
+		{"help",	no_argument,		0, 'h'},
+		{NULL,		0,			0, 0}
+	};
+	const char *region_name = "COREBOOT";
+	struct region_device cbfs;
+	struct sim_op *ops;
+	bool is_log = false;
+	size_t count, i;
+	FILE *list = stdin;
+	int c, ret = 0;
+
+	while ((c = getopt_long(argc, argv, "r:lf:m:x:o:c:vh", long_options, NULL)) != -1) {
+		switch (c) {
+		case 'r':
+			region_name = optarg;
+			break;
+		case 'l':
+			is_log = true;
+			break;
+		case 'f':
+			params.freq_mhz = strtod(optarg, NULL);
+			break;
+		case 'm':
+			for (i = 0; i < ARRAY_SIZE(spi_modes); i++)
+				if (!strcmp(optarg, spi_modes[i].name))
+					break;
+			if (i == ARRAY_SIZE(spi_modes)) {
+				fprintf(stderr, "E: Unknown SPI mode '%s'\n", optarg);
+				return 1;
+			}
+			params.mode = &spi_modes[i];
+			break;
+		case 'x':
+			params.max_xfer = strtoul(optarg, NULL, 0);
+			break;
+		case 'o':
+			params.overhead_ns = strtod(optarg, NULL);
+			break;
+		case 'c':
+			params.cache_size = strtoul(optarg, NULL, 0);
+			break;
+		case 'v':
+			verbose++;
+			break;
+		case 'h':
+		default:
+			usage();
+			return c != 'h';
+		}
+	}
+
+	if (optind >= argc || argc - optind > 2 || params.freq_mhz <= 0) {
+		usage();
+		return 1;
+	}
+
+	if (read_image(argv[optind]) || find_cbfs(region_name, &cbfs))
+		return 1;
+
+	if (argc - optind == 2) {
+		list = fopen(argv[optind + 1], "r");
+		if (!list) {
+			fprintf(stderr, "E: Could not open '%s'\n", argv[optind + 1]);
+			return 1;
+		}
+	}
+	if (read_ops(list, is_log, &ops, &count)) {
+		fprintf(stderr, "E: Out of memory\n");
+		return 1;
+	}
+	if (list != stdin)
+		fclose(list);
+
+	sim.cache_lines = params.cache_size / CACHE_LINE_SIZE;
+	if (sim.cache_lines) {
+		sim.cache_tag = calloc(sim.cache_lines, sizeof(*sim.cache_tag));
+		sim.cache_used = calloc(sim.cache_lines, sizeof(*sim.cache_used));
+		if (!sim.cache_tag || !sim.cache_used) {
+			fprintf(stderr, "E: Out of memory\n");
+			return 1;
+		}
+	}
+
+	for (i = 0; i < count; i++)
+		if (simulate(&ops[i], &cbfs))
+			ret = 1;
+
+	report(ops, count);
+
+	free(ops);
+	free(sim.cache_tag);
+	free(sim.cache_used);
+	free(sim.seen);
+	free(sim.image);
+	return ret;
+}
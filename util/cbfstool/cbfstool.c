@@ -60,6 +60,9 @@ static struct param {
 	uint32_t arch;
 	uint32_t padding;
 	uint32_t topswap_size;
+	/* Base addresses of files that reorder must not move */
+	uint32_t pinned[CBFS_REORDER_MAX_PINNED];
+	size_t pinned_count;
 	bool u64val_assigned;
 	bool fill_partial_upward;
 	bool fill_partial_downward;
@@ -1232,6 +1235,118 @@ static int cbfs_compact(void)
 	return cbfs_compact_instance(&image);
 }
 
+#define PROFILE_LOG_KEY "CBFS: Locating '"
+
+/*
+ * Returns the file name in one line of an access order profile, or NULL if the
+ * line doesn't name a file. Profiles are either cbfs-sim-tool style lists of
+ * names or coreboot console logs, of which the "CBFS: Locating 'NAME'" lines
+ * are used.
+ */
+static char *profile_line_name(char *line, bool is_log)
+{
+	char *name, *end;
+
+	if (is_log) {
+		name = strstr(line, PROFILE_LOG_KEY);
+		if (!name)
+			return NULL;
+		name += strlen(PROFILE_LOG_KEY);
+		end = strchr(name, '\'');
+		if (!end)
+			return NULL;
+		*end = '\0';
+		return name;
+	}
+
+	while (isspace((unsigned char)*line))
+		line++;
+	end = line + strlen(line);
+	while (end > line && isspace((unsigned char)end[-1]))
+		*--end = '\0';
+	/* Stage markers and comments of cbfs-sim-tool lists. */
+	if (!*line || *line == '#' || *line == '@')
+		return NULL;
+	if (!strncmp(line, "load ", 5))
+		line += 5;
+	else if (!strncmp(line, "locate ", 7))
+		line += 7;
+	while (isspace((unsigned char)*line))
+		line++;
+	return line;
+}
+
+static int cbfs_reorder(void)
+{
+	struct cbfs_image image;
+	struct buffer profile;
+	const char **names = NULL;
+	uint32_t pinned[CBFS_REORDER_MAX_PINNED];
+	size_t count = 0, i;
+	char *text, *line, *name;
+	bool is_log;
+	int ret = 1;
+
+	if (!param.filename) {
+		ERROR("You need to specify -f/--filename.\n");
+		return 1;
+	}
+
+	if (cbfs_image_from_buffer(&image, param.image_region,
+							param.headeroffset))
+		return 1;
+
+	if (buffer_from_file(&profile, param.filename))
+		return 1;
+
+	/* The profile isn't NUL terminated, so work on a copy. */
+	text = calloc(1, buffer_size(&profile) + 1);
+	if (!text)
+		goto out;
+	memcpy(text, buffer_get(&profile), buffer_size(&profile));
+	is_log = strstr(text, PROFILE_LOG_KEY) != NULL;
+
+	for (line = strtok(text, "\n"); line; line = strtok(NULL, "\n")) {
+		const char **new_names;
+
+		name = profile_line_name(line, is_log);
+		if (!name)
+			continue;
+
+		/* Only the first access of a file matters for its placement. */
+		for (i = 0; i < count; i++)
+			if (!strcasecmp(names[i], name))
+				break;
+		if (i < count)
+			continue;
+
+		new_names = realloc(names, (count + 1) * sizeof(*names));
+		if (!new_names)
+			goto out;
+		names = new_names;
+		names[count++] = name;
+	}
+
+	/* The files Makefile.inc added with -b, as region offsets */
+	for (i = 0; i < param.pinned_count; i++) {
+		pinned[i] = param.pinned[i];
+		if (IS_TOP_ALIGNED_ADDRESS(pinned[i]))
+			pinned[i] = convert_to_from_top_aligned(
+					param.image_region, -pinned[i]);
+	}
+
+	/* XIP stages are linked against the x86 mapping below 4GiB. */
+	ret = cbfs_reorder_instance(&image, names, count, pinned,
+		param.pinned_count,
+		-convert_to_from_absolute_top_aligned(param.image_region, 0));
+
+out:
+	free(names);
+	free(text);
+	buffer_delete(&profile);
+	return ret;
+}
+
 static int cbfs_expand(void)
 {
 	struct buffer src_buf;
@@ -1281,6 +1396,7 @@ static const struct command commands[] = {
 	{"print", "H:r:vkh?", cbfs_print, true, false},
 	{"read", "r:f:vh?", cbfs_read, true, false},
 	{"remove", "H:r:n:vh?", cbfs_remove, true, true},
+	{"reorder", "H:r:f:b:vh?", cbfs_reorder, true, true},
 	{"write", "r:f:i:Fudvh?", cbfs_write, true, true},
 	{"expand", "r:h?", cbfs_expand, true, true},
 	{"truncate", "r:h?", cbfs_truncate, true, true},
@@ -1432,6 +1548,8 @@ static void usage(char *name)
 			"Remove a component\n"
 	     " compact -r image,regions                                    "
 			"Defragment CBFS image.\n"
+	     " reorder [-r image,regions] -f PROFILE [-b base-address]...  "
+			"Place files in boot access order\n"
 	     " copy -r image,regions -R source-region                      "
 			"Create a copy (duplicate) cbfs instance in fmap\n"
 	     " create -m ARCH -s size [-b bootblock offset] \\\n"
@@ -1601,6 +1719,13 @@ int main(int argc, char **argv)
 				// baseaddress may be zero on non-x86, so we
 				// need an explicit "baseaddress_assigned".
 				param.baseaddress_assigned = 1;
+				// reorder takes a list of them.
+				if (param.pinned_count == CBFS_REORDER_MAX_PINNED) {
+					ERROR("Too many base addresses.\n");
+					return 1;
+				}
+				param.pinned[param.pinned_count++] =
+					param.baseaddress;
 				break;
 			case 'l':
 				param.loadaddress = strtoul(optarg, &suffix, 0);
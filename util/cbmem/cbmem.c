@@ -17,9 +17,13 @@
 #include <libgen.h>
 #include <assert.h>
 #include <regex.h>
+#include <elf.h>
 #include <commonlib/cbmem_id.h>
 #include <commonlib/timestamp_serialized.h>
 #include <commonlib/tcpa_log_serialized.h>
+#include <commonlib/trace_serialized.h>
+#include <commonlib/profile_serialized.h>
+#include <commonlib/coverage_serialized.h>
 #include <commonlib/coreboot_tables.h>
 
 #ifdef __OpenBSD__
@@ -1009,6 +1013,501 @@ static int mkpath(char *path, mode_t mode)
 	return 0;
 }
 
+/* .gcda format of the gcov version coreboot's libgcov implements. */
+#define GCOV_DATA_MAGIC			0x67636461
+#define GCOV_TAG_FUNCTION		0x01000000
+#define GCOV_TAG_FUNCTION_LENGTH	3
+#define GCOV_TAG_FOR_COUNTER(t)		(0x01a10000 + ((uint32_t)(t) << 17))
+#define GCOV_TAG_PROGRAM_SUMMARY	0xa3000000
+#define GCOV_TAG_SUMMARY_LENGTH		9
+#define GCOV_COUNTER_ARCS		0
+
+struct gcov_summary {
+	uint32_t checksum;
+	uint32_t num;
+	uint32_t runs;
+	uint64_t sum_all;
+	uint64_t run_max;
+	uint64_t sum_max;
+};
+
+static uint32_t gcov_crc32(uint32_t crc32, uint32_t value)
+{
+	for (int i = 0; i < 32; i++, value <<= 1) {
+		const uint32_t feedback = (value ^ crc32) & 0x80000000 ? 0x04c11db7 : 0;
+
+		crc32 = (crc32 << 1) ^ feedback;
+	}
+	return crc32;
+}
+
+static uint64_t get_counter(const uint32_t *p)
+{
+	return p[0] | (uint64_t)p[1] << 32;
+}
+
+static void put_counter(uint32_t *p, uint64_t value)
+{
+	p[0] = value;
+	p[1] = value >> 32;
+}
+
+typedef int (*coverage_function_fn)(const struct coverage_function *func, void *arg);
+typedef int (*coverage_array_fn)(int type, uint32_t *values, uint32_t num, void *arg);
+
+/*
+ * Calls fn_cb for every function and array_cb for every counter array of a
+ * record checked by coverage_object_valid(). Stops at the first callback
+ * that does not return 0.
+ */
+static int coverage_for_each_function(struct coverage_object *obj,
+				      coverage_function_fn fn_cb,
+				      coverage_array_fn array_cb, void *arg)
+{
+	uint32_t *p = (uint32_t *)&obj[1] + obj->filename_size / sizeof(*p);
+
+	for (uint32_t f = 0; f < obj->n_functions; f++) {
+		const struct coverage_function *func = (const void *)p;
+
+		p = (uint32_t *)&func[1];
+		if (fn_cb && fn_cb(func, arg))
+			return -1;
+		if (!(func->flags & COVERAGE_FUNCTION_PRESENT))
+			continue;
+
+		for (int t = 0; t < COVERAGE_COUNTER_TYPES; t++) {
+			uint32_t num;
+
+			if (!(obj->counter_mask & (1 << t)))
+				continue;
+			num = *p++;
+			if (array_cb && array_cb(t, p, num, arg))
+				return -1;
+			p += 2 * num;
+		}
+	}
+	return 0;
+}
+
+static int coverage_object_valid(const struct coverage_object *obj, size_t avail)
+{
+	const uint32_t *p, *end;
+
+	if (avail < sizeof(*obj) || obj->length < sizeof(*obj) || obj->length > avail ||
+	    obj->length % sizeof(*p) || obj->filename_size % sizeof(*p) ||
+	    obj->filename_size == 0 || obj->filename_size > obj->length - sizeof(*obj))
+		return 0;
+
+	p = (const uint32_t *)&obj[1];
+	end = (const uint32_t *)((const uint8_t *)obj + obj->length);
+	if (memchr(p, 0, obj->filename_size) == NULL)
+		return 0;
+	p += obj->filename_size / sizeof(*p);
+
+	for (uint32_t f = 0; f < obj->n_functions; f++) {
+		const struct coverage_function *func = (const void *)p;
+
+		if ((size_t)(end - p) < sizeof(*func) / sizeof(*p))
+			return 0;
+		p += sizeof(*func) / sizeof(*p);
+		if (!(func->flags & COVERAGE_FUNCTION_PRESENT))
+			continue;
+
+		for (int t = 0; t < COVERAGE_COUNTER_TYPES; t++) {
+			if (!(obj->counter_mask & (1 << t)))
+				continue;
+			if (p == end || (size_t)(end - p - 1) / 2 < *p)
+				return 0;
+			p += 1 + 2 * *p;
+		}
+	}
+
+	return p == end;
+}
+
+/* Program summary of the arc counters of all objects, as libgcov computes it. */
+struct coverage_program {
+	uint32_t crc32;
+	struct gcov_summary summary;
+};
+
+static int coverage_program_fn(const struct coverage_function *func, void *arg)
+{
+	struct coverage_program *prg = arg;
+
+	prg->crc32 = gcov_crc32(prg->crc32, func->cfg_checksum);
+	prg->crc32 = gcov_crc32(prg->crc32, func->lineno_checksum);
+	return 0;
+}
+
+static int coverage_program_array(int type, uint32_t *values, uint32_t num, void *arg)
+{
+	struct coverage_program *prg = arg;
+
+	if (type != GCOV_COUNTER_ARCS)
+		return 0;
+
+	prg->crc32 = gcov_crc32(prg->crc32, num);
+	prg->summary.num += num;
+	for (uint32_t i = 0; i < num; i++) {
+		const uint64_t value = get_counter(&values[2 * i]);
+
+		prg->summary.sum_all += value;
+		if (prg->summary.run_max < value)
+			prg->summary.run_max = value;
+	}
+	return 0;
+}
+
+/* Merge state for one object: the old .gcda contents and the read position. */
+struct gcda_merge {
+	const uint32_t *w;
+	size_t pos;
+	size_t len;
+};
+
+static const uint32_t *gcda_take(struct gcda_merge *m, size_t words)
+{
+	const uint32_t *p = &m->w[m->pos];
+
+	if (m->len - m->pos < words)
+		return NULL;
+	m->pos += words;
+	return p;
+}
+
+static int gcda_merge_fn(const struct coverage_function *func, void *arg)
+{
+	struct gcda_merge *m = arg;
+	const int present = func->flags & COVERAGE_FUNCTION_PRESENT;
+	const uint32_t *p = gcda_take(m, 2);
+
+	if (!p || p[0] != GCOV_TAG_FUNCTION ||
+	    p[1] != (present ? GCOV_TAG_FUNCTION_LENGTH : 0))
+		return -1;
+	if (!present)
+		return 0;
+
+	p = gcda_take(m, GCOV_TAG_FUNCTION_LENGTH);
+	if (!p || p[0] != func->ident || p[1] != func->lineno_checksum ||
+	    p[2] != func->cfg_checksum)
+		return -1;
+	return 0;
+}
+
+/* Merges the old counters into the new ones, like the __gcov_merge_* functions. */
+static int gcda_merge_array(int type, uint32_t *values, uint32_t num, void *arg)
+{
+	struct gcda_merge *m = arg;
+	const uint32_t *p = gcda_take(m, 2);
+	const uint32_t *old;
+
+	if (!p || p[0] != GCOV_TAG_FOR_COUNTER(type) || p[1] != 2 * num)
+		return -1;
+	old = gcda_take(m, 2 * num);
+	if (!old)
+		return -1;
+
+	switch (type) {
+	case 3: /* single */
+	case 4: /* delta */
+	case 5: /* indirect_call */
+	{
+		/* Tuples of [last value,] value, count, total. */
+		const uint32_t n = type == 4 ? 4 : 3;
+		const uint32_t v = n - 3;
+
+		if (num % n)
+			return -1;
+		for (uint32_t i = 0; i < num; i += n) {
+			uint32_t *new_c = &values[2 * i];
+			const uint32_t *old_c = &old[2 * i];
+			uint64_t count = get_counter(&new_c[2 * (v + 1)]);
+			const uint64_t old_count = get_counter(&old_c[2 * (v + 1)]);
+
+			if (get_counter(&new_c[2 * v]) == get_counter(&old_c[2 * v])) {
+				count += old_count;
+			} else if (old_count > count) {
+				put_counter(&new_c[2 * v], get_counter(&old_c[2 * v]));
+				count = old_count - count;
+			} else {
+				count -= old_count;
+			}
+			put_counter(&new_c[2 * (v + 1)], count);
+			put_counter(&new_c[2 * (v + 2)], get_counter(&new_c[2 * (v + 2)]) +
+				    get_counter(&old_c[2 * (v + 2)]));
+		}
+		break;
+	}
+	case 7: /* ior */
+		for (uint32_t i = 0; i < 2 * num; i++)
+			values[i] |= old[i];
+		break;
+	default: /* arcs, interval, pow2, average */
+		for (uint32_t i = 0; i < num; i++)
+			put_counter(&values[2 * i], get_counter(&values[2 * i]) +
+				    get_counter(&old[2 * i]));
+		break;
+	}
+	return 0;
+}
+
+/*
+ * Adds the counters of an existing .gcda file to obj. Returns 0 and fills in
+ * the summary of earlier runs if the file matches the object.
+ */
+static int gcda_merge(const char *filename, const struct coverage_stream *stream,
+		      struct coverage_object *obj, uint32_t crc32, struct gcov_summary *old)
+{
+	struct gcda_merge m = { 0 };
+	struct coverage_object *copy;
+	uint32_t *buf;
+	struct stat st;
+	FILE *f;
+	int ret = -1;
+
+	f = fopen(filename, "rb");
+	if (!f)
+		return -1;
+	if (fstat(fileno(f), &st) || st.st_size % sizeof(*buf) || st.st_size < 12) {
+		fclose(f);
+		return -1;
+	}
+
+	m.len = st.st_size / sizeof(*buf);
+	buf = malloc(st.st_size);
+	if (!buf)
+		die("Out of memory.\n");
+	if (fread(buf, st.st_size, 1, f) != 1 || buf[0] != GCOV_DATA_MAGIC ||
+	    buf[1] != stream->gcov_version || buf[2] != obj->stamp)
+		goto out;
+	m.w = buf;
+	m.pos = 3;
+
+	/* Keep the summary of this program, drop those of others. */
+	memset(old, 0, sizeof(*old));
+	while (m.len - m.pos >= 2 && m.w[m.pos] == GCOV_TAG_PROGRAM_SUMMARY) {
+		const uint32_t *p;
+
+		if (m.w[m.pos + 1] != GCOV_TAG_SUMMARY_LENGTH)
+			goto out;
+		p = gcda_take(&m, 2 + GCOV_TAG_SUMMARY_LENGTH) + 2;
+		if (!p)
+			goto out;
+		if (p[0] == crc32) {
+			old->num = p[1];
+			old->runs = p[2];
+			old->sum_all = get_counter(&p[3]);
+			old->run_max = get_counter(&p[5]);
+			old->sum_max = get_counter(&p[7]);
+		}
+	}
+
+	/* Merge into a copy so that a mismatch half way leaves obj untouched. */
+	copy = malloc(obj->length);
+	if (!copy)
+		die("Out of memory.\n");
+	memcpy(copy, obj, obj->length);
+	if (coverage_for_each_function(copy, gcda_merge_fn, gcda_merge_array, &m) == 0) {
+		memcpy(obj, copy, obj->length);
+		ret = 0;
+	}
+	free(copy);
+
+out:
+	free(buf);
+	fclose(f);
+	return ret;
+}
+
+static int gcda_write_array(int type, uint32_t *values, uint32_t num, void *arg)
+{
+	const uint32_t hdr[2] = { GCOV_TAG_FOR_COUNTER(type), 2 * num };
+
+	if (fwrite(hdr, sizeof(hdr), 1, arg) != 1 ||
+	    (num && fwrite(values, 2 * num * sizeof(*values), 1, arg) != 1))
+		return -1;
+	return 0;
+}
+
+static int gcda_write_fn(const struct coverage_function *func, void *arg)
+{
+	const int present = func->flags & COVERAGE_FUNCTION_PRESENT;
+	const uint32_t rec[5] = {
+		GCOV_TAG_FUNCTION, present ? GCOV_TAG_FUNCTION_LENGTH : 0,
+		func->ident, func->lineno_checksum, func->cfg_checksum,
+	};
+
+	return fwrite(rec, present ? sizeof(rec) : 2 * sizeof(rec[0]), 1, arg) == 1 ? 0 : -1;
+}
+
+static void gcda_write(const char *filename, const struct coverage_stream *stream,
+		       struct coverage_object *obj, const struct gcov_summary *summary)
+{
+	const uint32_t hdr[3] = { GCOV_DATA_MAGIC, stream->gcov_version, obj->stamp };
+	uint32_t sum[2 + GCOV_TAG_SUMMARY_LENGTH] = {
+		GCOV_TAG_PROGRAM_SUMMARY, GCOV_TAG_SUMMARY_LENGTH,
+		summary->checksum, summary->num, summary->runs,
+	};
+	const uint32_t eof = 0;
+	FILE *f;
+
+	put_counter(&sum[5], summary->sum_all);
+	put_counter(&sum[7], summary->run_max);
+	put_counter(&sum[9], summary->sum_max);
+
+	f = fopen(filename, "wb");
+	if (!f) {
+		printf("Could not open %s: %s\n", filename, strerror(errno));
+		exit(1);
+	}
+	if (fwrite(hdr, sizeof(hdr), 1, f) != 1 || fwrite(sum, sizeof(sum), 1, f) != 1 ||
+	    coverage_for_each_function(obj, gcda_write_fn, gcda_write_array, f) ||
+	    fwrite(&eof, sizeof(eof), 1, f) != 1) {
+		printf("Could not write to %s: %s\n", filename, strerror(errno));
+		exit(1);
+	}
+	fclose(f);
+}
+
+/*
+ * Every .gcda file written from a stream gets a <file>.boot_id next to it with
+ * the boot ID of the stream. Running cbmem -C again on the same boot finds it
+ * and does not add the same counters a second time.
+ */
+static char *gcda_boot_id_path(const char *filename)
+{
+	char *path = malloc(strlen(filename) + sizeof(".boot_id"));
+
+	if (!path)
+		die("Out of memory.\n");
+	sprintf(path, "%s.boot_id", filename);
+	return path;
+}
+
+static int gcda_boot_id_seen(const char *filename, uint32_t boot_id)
+{
+	char *path = gcda_boot_id_path(filename);
+	FILE *f = fopen(path, "r");
+	unsigned int id;
+	int seen;
+
+	free(path);
+	if (!f)
+		return 0;
+	seen = fscanf(f, "%x", &id) == 1 && id == boot_id;
+	fclose(f);
+	return seen;
+}
+
+static void gcda_boot_id_write(const char *filename, uint32_t boot_id)
+{
+	char *path = gcda_boot_id_path(filename);
+	FILE *f = fopen(path, "w");
+
+	if (!f || fprintf(f, "%08x\n", boot_id) < 0 || fclose(f)) {
+		printf("Could not write %s: %s\n", path, strerror(errno));
+		exit(1);
+	}
+	free(path);
+}
+
+/*
+ * Writes the .gcda files of a coverage stream. Counters are added to those of
+ * existing .gcda files from the same build, so that several boots accumulate.
+ * Objects already written from this stream are skipped.
+ */
+static void dump_coverage_stream(const struct coverage_stream *mapped, size_t size)
+{
+	struct coverage_stream *stream;
+	struct coverage_program prg = { 0 };
+	uint8_t *records, *p;
+	size_t used;
+	int count = 0, merged = 0, skipped = 0;
+
+	stream = malloc(size);
+	if (!stream)
+		die("Out of memory.\n");
+	aligned_memcpy(stream, mapped, size);
+
+	if (stream->version != COVERAGE_STREAM_VERSION) {
+		fprintf(stderr, "Unsupported coverage stream version %u\n", stream->version);
+		free(stream);
+		return;
+	}
+	used = size - sizeof(*stream);
+	if (stream->used < used)
+		used = stream->used;
+	records = (uint8_t *)stream->records;
+
+	/* The whole program summary and checksum cover every object. */
+	for (p = records; p < records + used; p += ((struct coverage_object *)p)->length) {
+		struct coverage_object *obj = (void *)p;
+
+		if (!coverage_object_valid(obj, records + used - p)) {
+			fprintf(stderr, "Coverage stream is corrupted at offset %zu\n",
+				(size_t)(p - records));
+			used = p - records;
+			break;
+		}
+		prg.crc32 = gcov_crc32(prg.crc32, obj->stamp);
+		prg.crc32 = gcov_crc32(prg.crc32, obj->n_functions);
+		coverage_for_each_function(obj, coverage_program_fn, coverage_program_array,
+					   &prg);
+	}
+
+	printf("Dumping coverage data...\n");
+
+	for (p = records; p < records + used; p += ((struct coverage_object *)p)->length) {
+		struct coverage_object *obj = (void *)p;
+		char *filename = strdup((char *)&obj[1]);
+		struct gcov_summary summary = { .checksum = prg.crc32 };
+		struct gcov_summary old;
+
+		debug(" -> %s\n", filename);
+		if (gcda_boot_id_seen(filename, stream->boot_id)) {
+			free(filename);
+			skipped++;
+			continue;
+		}
+		if (mkpath(filename, 0755) == -1) {
+			perror("Directory for coverage data could not be created");
+			exit(1);
+		}
+
+		if (obj->counter_mask & (1 << GCOV_COUNTER_ARCS)) {
+			summary.num = prg.summary.num;
+			summary.runs = 1;
+			summary.sum_all = prg.summary.sum_all;
+			summary.run_max = prg.summary.run_max;
+			summary.sum_max = prg.summary.run_max;
+		}
+		if (gcda_merge(filename, stream, obj, prg.crc32, &old) == 0) {
+			merged++;
+			if (old.runs) {
+				summary.runs += old.runs;
+				summary.sum_all += old.sum_all;
+				if (summary.run_max < old.run_max)
+					summary.run_max = old.run_max;
+				summary.sum_max += old.sum_max;
+			}
+		}
+		gcda_write(filename, stream, obj, &summary);
+		gcda_boot_id_write(filename, stream->boot_id);
+		free(filename);
+		count++;
+	}
+
+	printf("Wrote %d .gcda files, %d merged with earlier runs", count, merged);
+	if (skipped)
+		printf(", %d already written from this boot", skipped);
+	if (stream->dropped)
+		printf(", %u objects did not fit into CBMEM", stream->dropped);
+	printf("\n");
+
+	free(stream);
+}
+
 static void dump_coverage(void)
 {
 	uint64_t start;
@@ -1029,6 +1528,13 @@ static void dump_coverage(void)
 		die("Unable to map coverage area.\n");
 	phys_offset = (unsigned long)coverage - (unsigned long)start;
 
+	if (size >= sizeof(struct coverage_stream) &&
+	    *(const uint32_t *)coverage == COVERAGE_STREAM_MAGIC) {
+		dump_coverage_stream(coverage, size);
+		unmap_memory(&coverage_mapping);
+		return;
+	}
+
 	printf("Dumping coverage data...\n");
 
 	struct file *file = (struct file *)coverage;
@@ -1066,6 +1572,335 @@ static void dump_coverage(void)
 	unmap_memory(&coverage_mapping);
 }
 
+static void dump_function_trace(const char *path)
+{
+	uint64_t start;
+	size_t size;
+	const struct trace_buffer *buf;
+	struct mapping trace_mapping;
+	void *copy;
+	FILE *f;
+
+	if (find_cbmem_entry(CBMEM_ID_TRACE, &start, &size)) {
+		fprintf(stderr, "No function trace found\n");
+		return;
+	}
+
+	buf = map_memory(&trace_mapping, start, size);
+	if (!buf)
+		die("Unable to map function trace.\n");
+
+	if (size < sizeof(*buf) || buf->magic != TRACE_BUFFER_MAGIC) {
+		fprintf(stderr, "Function trace is not initialized\n");
+		unmap_memory(&trace_mapping);
+		return;
+	}
+
+	f = fopen(path, "wb");
+	if (!f) {
+		fprintf(stderr, "Could not open %s: %s\n", path, strerror(errno));
+		exit(1);
+	}
+	/* Go through aligned_memcpy() since /dev/mem may not like fwrite()'s accesses. */
+	copy = malloc(size);
+	if (!copy)
+		die("Out of memory.\n");
+	aligned_memcpy(copy, buf, size);
+	if (fwrite(copy, size, 1, f) != 1) {
+		fprintf(stderr, "Could not write to %s: %s\n", path, strerror(errno));
+		exit(1);
+	}
+	fclose(f);
+	free(copy);
+	unmap_memory(&trace_mapping);
+
+	printf("Wrote %zu bytes of function trace to %s\n", size, path);
+}
+
+static const char *const profile_stage_names[PROFILE_STAGE_COUNT] = {
+	[PROFILE_STAGE_ROMSTAGE] = "romstage",
+	[PROFILE_STAGE_POSTCAR] = "postcar",
+	[PROFILE_STAGE_RAMSTAGE] = "ramstage",
+};
+
+struct profile_symbol {
+	u64 addr;
+	u64 size;
+	const char *name;
+	u64 count;
+};
+
+/* Function symbols of a stage ELF, sorted by address. */
+struct profile_elf {
+	const char *path;
+	void *data;
+	struct profile_symbol *syms;
+	size_t num_syms;
+	u64 program;
+};
+
+static struct profile_elf profile_elfs[PROFILE_STAGE_COUNT];
+
+static int profile_symbol_cmp(const void *a, const void *b)
+{
+	const struct profile_symbol *sa = a, *sb = b;
+
+	if (sa->addr != sb->addr)
+		return sa->addr < sb->addr ? -1 : 1;
+	return 0;
+}
+
+static int profile_count_cmp(const void *a, const void *b)
+{
+	const struct profile_symbol *sa = a, *sb = b;
+
+	if (sa->count != sb->count)
+		return sa->count > sb->count ? -1 : 1;
+	return profile_symbol_cmp(a, b);
+}
+
+static void profile_add_symbol(struct profile_elf *elf, const char *name,
+			       unsigned int type, u64 value, u64 size)
+{
+	struct profile_symbol *sym;
+
+	if (!strcmp(name, "_program"))
+		elf->program = value;
+
+	if (type != STT_FUNC || !size)
+		return;
+
+	elf->syms = realloc(elf->syms, (elf->num_syms + 1) * sizeof(*elf->syms));
+	if (!elf->syms)
+		die("Out of memory.\n");
+
+	sym = &elf->syms[elf->num_syms++];
+	sym->addr = value;
+	sym->size = size;
+	sym->name = name;
+	sym->count = 0;
+}
+
+/* Reads the symbol table of a 32-bit or 64-bit little endian ELF file. */
+static void profile_load_elf(struct profile_elf *elf)
+{
+	const unsigned char *ident;
+	struct stat st;
+	size_t i, j;
+	int fd;
+
+	fd = open(elf->path, O_RDONLY);
+	if (fd < 0 || fstat(fd, &st)) {
+		fprintf(stderr, "Could not open %s: %s\n", elf->path, strerror(errno));
+		exit(1);
+	}
+	elf->data = malloc(st.st_size);
+	if (!elf->data)
+		die("Out of memory.\n");
+	if (read(fd, elf->data, st.st_size) != st.st_size) {
+		fprintf(stderr, "Could not read %s\n", elf->path);
+		exit(1);
+	}
+	close(fd);
+
+	ident = elf->data;
+	if ((size_t)st.st_size < sizeof(Elf64_Ehdr) || memcmp(ident, ELFMAG, SELFMAG) ||
+	    ident[EI_DATA] != ELFDATA2LSB) {
+		fprintf(stderr, "%s is not a little endian ELF file\n", elf->path);
+		exit(1);
+	}
+
+#define PROFILE_READ_SYMTAB(Ehdr, Shdr, Sym, ST_TYPE)					\
+	do {										\
+		const Ehdr *eh = elf->data;						\
+		const Shdr *sh = (const Shdr *)((char *)elf->data + eh->e_shoff);	\
+											\
+		if (eh->e_shoff + (u64)eh->e_shnum * sizeof(Shdr) > (u64)st.st_size)	\
+			die("Truncated ELF file.\n");					\
+		for (i = 0; i < eh->e_shnum; i++) {					\
+			const Sym *sym;							\
+			const char *strtab;						\
+											\
+			if (sh[i].sh_type != SHT_SYMTAB || sh[i].sh_link >= eh->e_shnum)	\
+				continue;						\
+			if (sh[i].sh_offset + sh[i].sh_size > (u64)st.st_size ||	\
+			    sh[sh[i].sh_link].sh_offset +				\
+			    sh[sh[i].sh_link].sh_size > (u64)st.st_size)		\
+				die("Truncated ELF file.\n");				\
+			sym = (const Sym *)((char *)elf->data + sh[i].sh_offset);	\
+			strtab = (const char *)elf->data + sh[sh[i].sh_link].sh_offset;	\
+			for (j = 0; j < sh[i].sh_size / sizeof(Sym); j++) {		\
+				if (sym[j].st_name >= sh[sh[i].sh_link].sh_size)	\
+					continue;					\
+				profile_add_symbol(elf, strtab + sym[j].st_name,	\
+						   ST_TYPE(sym[j].st_info),		\
+						   sym[j].st_value, sym[j].st_size);	\
+			}								\
+		}									\
+	} while (0)
+
+	if (ident[EI_CLASS] == ELFCLASS64)
+		PROFILE_READ_SYMTAB(Elf64_Ehdr, Elf64_Shdr, Elf64_Sym, ELF64_ST_TYPE);
+	else
+		PROFILE_READ_SYMTAB(Elf32_Ehdr, Elf32_Shdr, Elf32_Sym, ELF32_ST_TYPE);
+
+#undef PROFILE_READ_SYMTAB
+
+	if (!elf->num_syms) {
+		fprintf(stderr, "No function symbols in %s\n", elf->path);
+		exit(1);
+	}
+	qsort(elf->syms, elf->num_syms, sizeof(*elf->syms), profile_symbol_cmp);
+}
+
+static struct profile_symbol *profile_lookup(struct profile_elf *elf, u64 addr)
+{
+	size_t lo = 0, hi = elf->num_syms;
+
+	/* Find the last symbol starting at or below addr. */
+	while (hi - lo > 1) {
+		size_t mid = (lo + hi) / 2;
+
+		if (elf->syms[mid].addr <= addr)
+			lo = mid;
+		else
+			hi = mid;
+	}
+
+	if (addr < elf->syms[lo].addr || addr >= elf->syms[lo].addr + elf->syms[lo].size)
+		return NULL;
+	return &elf->syms[lo];
+}
+
+/* Parses a -e STAGE=ELF argument. */
+static void profile_add_elf(const char *arg)
+{
+	const char *eq = strchr(arg, '=');
+	size_t i;
+
+	for (i = 0; eq && i < PROFILE_STAGE_COUNT; i++) {
+		if (strlen(profile_stage_names[i]) == (size_t)(eq - arg) &&
+		    !strncmp(arg, profile_stage_names[i], eq - arg)) {
+			profile_elfs[i].path = eq + 1;
+			return;
+		}
+	}
+
+	fprintf(stderr, "Invalid ELF argument '%s', expected romstage|postcar|ramstage=FILE\n",
+		arg);
+	exit(1);
+}
+
+static void print_profile_stage(const struct profile_buffer *buf, int stage)
+{
+	struct profile_elf *elf = &profile_elfs[stage];
+	const u64 total = buf->stage_samples[stage];
+	struct profile_symbol *rows;
+	size_t num_rows = 0, i;
+	u64 unknown = 0;
+
+	if (!total)
+		return;
+
+	printf("\n%s: %" PRIu64 " samples, loaded at 0x%" PRIx64 "\n",
+	       profile_stage_names[stage], total, buf->stage_base[stage]);
+
+	rows = calloc(buf->capacity, sizeof(*rows));
+	if (!rows)
+		die("Out of memory.\n");
+
+	if (elf->path)
+		profile_load_elf(elf);
+
+	for (i = 0; i < buf->capacity; i++) {
+		const struct profile_entry *e = &buf->entries[i];
+		struct profile_symbol *sym;
+		u64 addr;
+
+		if (!e->count || e->stage != stage)
+			continue;
+
+		if (!elf->path) {
+			rows[num_rows].addr = e->ip;
+			rows[num_rows++].count = e->count;
+			continue;
+		}
+
+		/* Relocate the sample into the address space of the ELF. */
+		addr = e->ip - buf->stage_base[stage] + elf->program;
+		sym = profile_lookup(elf, addr);
+		if (sym)
+			sym->count += e->count;
+		else
+			unknown += e->count;
+	}
+
+	if (elf->path) {
+		for (i = 0; i < elf->num_syms; i++) {
+			if (elf->syms[i].count)
+				rows[num_rows++] = elf->syms[i];
+		}
+	}
+
+	qsort(rows, num_rows, sizeof(*rows), profile_count_cmp);
+
+	printf("%10s %7s  %s\n", "samples", "%", elf->path ? "function" : "address");
+	for (i = 0; i < num_rows; i++) {
+		printf("%10" PRIu64 " %6.2f%%  ", rows[i].count, 100.0 * rows[i].count / total);
+		if (elf->path)
+			printf("%s\n", rows[i].name);
+		else
+			printf("0x%" PRIx64 "\n", rows[i].addr);
+	}
+	if (unknown)
+		printf("%10" PRIu64 " %6.2f%%  (unknown)\n", unknown, 100.0 * unknown / total);
+
+	free(rows);
+	free(elf->syms);
+	free(elf->data);
+}
+
+static void dump_profile(void)
+{
+	uint64_t start;
+	size_t size;
+	const struct profile_buffer *mapped;
+	struct profile_buffer *buf;
+	struct mapping profile_mapping;
+	int stage;
+
+	if (find_cbmem_entry(CBMEM_ID_PROFILE, &start, &size)) {
+		fprintf(stderr, "No sampling profile found\n");
+		return;
+	}
+
+	mapped = map_memory(&profile_mapping, start, size);
+	if (!mapped)
+		die("Unable to map sampling profile.\n");
+
+	buf = malloc(size);
+	if (!buf)
+		die("Out of memory.\n");
+	aligned_memcpy(buf, mapped, size);
+	unmap_memory(&profile_mapping);
+
+	if (size < sizeof(*buf) || buf->magic != PROFILE_BUFFER_MAGIC ||
+	    buf->version != PROFILE_BUFFER_VERSION ||
+	    buf->capacity > (size - sizeof(*buf)) / sizeof(struct profile_entry)) {
+		fprintf(stderr, "Sampling profile is not initialized\n");
+		free(buf);
+		return;
+	}
+
+	printf("Sampling profile: %u Hz, %u of %u buckets used, %u samples dropped\n",
+	       buf->rate_hz, buf->used, buf->capacity, buf->dropped);
+
+	for (stage = 0; stage < PROFILE_STAGE_COUNT; stage++)
+		print_profile_stage(buf, stage);
+
+	free(buf);
+}
+
 static void print_version(void)
 {
 	printf("cbmem v%s -- ", CBMEM_VERSION);
@@ -1082,7 +1917,7 @@ static void print_version(void)
 
 static void print_usage(const char *name, int exit_code)
 {
-	printf("usage: %s [-cCltTLxVvh?]\n", name);
+	printf("usage: %s [-cCltTLPxVvh?] [-F FILE] [-e STAGE=ELF]\n", name);
 	printf("\n"
 	     "   -c | --console:                   print cbmem console\n"
 	     "   -1 | --oneboot:                   print cbmem console for last boot only\n"
@@ -1093,6 +1928,10 @@ static void print_usage(const char *name, int exit_code)
 	     "   -t | --timestamps:                print timestamp information\n"
 	     "   -T | --parseable-timestamps:      print parseable timestamps\n"
 	     "   -L | --tcpa-log                   print TCPA log\n"
+	     "   -F | --function-trace FILE:       write the binary function trace to FILE\n"
+	     "   -P | --profile:                   print the sampling profile\n"
+	     "   -e | --elf STAGE=ELF:             resolve profile samples of STAGE\n"
+	     "                                     (romstage, postcar or ramstage) to functions\n"
 	     "   -V | --verbose:                   verbose (debugging) output\n"
 	     "   -v | --version:                   print the version\n"
 	     "   -h | --help:                      print this help\n"
@@ -1225,6 +2064,8 @@ int main(int argc, char** argv)
 	int print_rawdump = 0;
 	int print_timestamps = 0;
 	int print_tcpa_log = 0;
+	int print_profile = 0;
+	const char *trace_file = NULL;
 	int machine_readable_timestamps = 0;
 	int one_boot_only = 0;
 	unsigned int rawdump_id = 0;
@@ -1236,6 +2077,9 @@ int main(int argc, char** argv)
 		{"coverage", 0, 0, 'C'},
 		{"list", 0, 0, 'l'},
 		{"tcpa-log", 0, 0, 'L'},
+		{"function-trace", required_argument, 0, 'F'},
+		{"profile", 0, 0, 'P'},
+		{"elf", required_argument, 0, 'e'},
 		{"timestamps", 0, 0, 't'},
 		{"parseable-timestamps", 0, 0, 'T'},
 		{"hexdump", 0, 0, 'x'},
@@ -1245,7 +2089,7 @@ int main(int argc, char** argv)
 		{"help", 0, 0, 'h'},
 		{0, 0, 0, 0}
 	};
-	while ((opt = getopt_long(argc, argv, "c1CltTLxVvh?r:",
+	while ((opt = getopt_long(argc, argv, "c1CltTLPxVvh?r:F:e:",
 				  long_options, &option_index)) != EOF) {
 		switch (opt) {
 		case 'c':
@@ -1269,6 +2113,17 @@ int main(int argc, char** argv)
 			print_tcpa_log = 1;
 			print_defaults = 0;
 			break;
+		case 'F':
+			trace_file = optarg;
+			print_defaults = 0;
+			break;
+		case 'P':
+			print_profile = 1;
+			print_defaults = 0;
+			break;
+		case 'e':
+			profile_add_elf(optarg);
+			break;
 		case 'x':
 			print_hexdump = 1;
 			print_defaults = 0;
@@ -1402,6 +2257,12 @@ int main(int argc, char** argv)
 	if (print_tcpa_log)
 		dump_tcpa_log();
 
+	if (trace_file)
+		dump_function_trace(trace_file);
+
+	if (print_profile)
+		dump_profile();
+
 	unmap_memory(&lbtable_mapping);
 
 	close(mem_fd);
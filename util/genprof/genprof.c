@@ -1,7 +1,13 @@
+#include <inttypes.h>
 #include <stdio.h>
+#include <string.h>
+#include <unistd.h>
 #include <uthash.h>
 #include <sys/gmon_out.h>
+#include <sys/wait.h>
+#include <fcntl.h>
 #include <stdlib.h>
+#include <commonlib/trace_serialized.h>
 
 #define GMON_SEC "seconds        s"
 uint32_t mineip = 0xffffffff;
@@ -30,7 +36,7 @@ void note_arc(uint32_t eip, uint32_t from)
 		if (eip > maxeip)
 			maxeip = eip;
 		if (eip < mineip)
-			maxeip = eip;
+			mineip = eip;
 
 		HASH_ADD_INT(arc, eip, s);
 	} else {
@@ -38,32 +44,36 @@ void note_arc(uint32_t eip, uint32_t from)
 	}
 }
 
-int main(int argc, char* argv[])
+static void write_gmon_header(FILE *fo)
+{
+	uint32_t tmp;
+
+	fwrite(GMON_MAGIC, 1, sizeof(GMON_MAGIC) - 1, fo);
+	tmp = GMON_VERSION;
+	fwrite(&tmp, 1, sizeof(tmp), fo);
+	tmp = 0;
+	fwrite(&tmp, 1, sizeof(tmp), fo);
+	fwrite(&tmp, 1, sizeof(tmp), fo);
+	fwrite(&tmp, 1, sizeof(tmp), fo);
+}
+
+static void write_gmon_arc(FILE *fo, uint32_t from, uint32_t self, uint32_t count)
+{
+	uint8_t tag = GMON_TAG_CG_ARC;
+
+	fwrite(&tag, 1, sizeof(tag), fo);
+	fwrite(&from, 1, sizeof(from), fo);
+	fwrite(&self, 1, sizeof(self), fo);
+	fwrite(&count, 1, sizeof(count), fo);
+}
+
+static int text_log_to_gmon(FILE *f, FILE *fo)
 {
-	FILE *f, *fo;
 	struct arec *s;
 	uint32_t eip, from, tmp;
 	uint8_t tag;
 	uint16_t hit;
 
-	if (argc != 2) {
-		fprintf(stderr, "Please specify the coreboot trace log as parameter\n");
-		return 1;
-	}
-
-	f = fopen(argv[1], "r");
-	if (f == NULL) {
-		perror("Unable to open the input file");
-		return 1;
-	}
-
-	fo = fopen("gmon.out", "w+");
-	if (fo == NULL) {
-		perror("Unable to open the output file");
-		fclose(f);
-		return 1;
-	}
-
 	while (!feof(f)) {
 		if (fscanf(f, "~%x(%x)%*[^\n]\n", &eip, &from) == 2) {
 			note_arc(eip, from);
@@ -76,13 +86,7 @@ int main(int argc, char* argv[])
 	}
 
 	/* write gprof header */
-	fwrite(GMON_MAGIC, 1, sizeof(GMON_MAGIC) - 1, fo);
-	tmp = GMON_VERSION;
-	fwrite(&tmp, 1, sizeof(tmp), fo);
-	tmp = 0;
-	fwrite(&tmp, 1, sizeof(tmp), fo);
-	fwrite(&tmp, 1, sizeof(tmp), fo);
-	fwrite(&tmp, 1, sizeof(tmp), fo);
+	write_gmon_header(fo);
 	/* write fake histogram */
 	tag = GMON_TAG_TIME_HIST;
 	fwrite(&tag, 1, sizeof(tag), fo);
@@ -99,16 +103,458 @@ int main(int argc, char* argv[])
 	fwrite(&hit, 1, sizeof(hit), fo);
 
 	/* write call graph data */
-	tag = GMON_TAG_CG_ARC;
-	for (s = arc; s != NULL; s = s->hh.next) {
-		fwrite(&tag, 1, sizeof(tag), fo);
-		fwrite(&s->from, 1, sizeof(s->from), fo);
-		fwrite(&s->eip, 1, sizeof(s->eip), fo);
-		fwrite(&s->count, 1, sizeof(s->count), fo);
+	for (s = arc; s != NULL; s = s->hh.next)
+		write_gmon_arc(fo, s->from, s->eip, s->count);
+
+	return 0;
+}
+
+/*
+ * Binary traces written by CONFIG_TRACE_BINARY, as dumped by `cbmem -F`.
+ *
+ * All aggregation goes through one table type, keyed by a pair of values:
+ * functions are keyed by (address, 0), call arcs by (callsite, function) and
+ * the nodes of the calling context tree by (parent node + 1, function).
+ */
+struct entry {
+	uint64_t a, b;
+	uint64_t count;
+	uint64_t incl;
+	uint64_t excl;
+	const char *name;
+};
+
+struct table {
+	struct entry *entries;
+	size_t num, cap;
+	/* Open addressing, holds entry index + 1. */
+	uint32_t *slots;
+	size_t nslots;
+};
+
+static struct table funcs, arcs, nodes;
+
+#define MAX_DEPTH 512
+
+struct frame {
+	uint32_t node;
+	uint32_t func;
+	uint64_t start;
+	uint64_t child;
+};
+
+static void *xrealloc(void *p, size_t size)
+{
+	p = realloc(p, size);
+	if (!p) {
+		fprintf(stderr, "Out of memory\n");
+		exit(1);
 	}
+	return p;
+}
 
-	fclose(fo);
+static size_t slot_of(const struct table *t, uint64_t a, uint64_t b)
+{
+	uint64_t h = (a * 0x9e3779b97f4a7c15ULL) ^ (b * 0xc2b2ae3d27d4eb4fULL);
+
+	return (h ^ (h >> 29)) & (t->nslots - 1);
+}
+
+static void table_grow(struct table *t)
+{
+	t->nslots = t->nslots ? t->nslots * 2 : 1024;
+	free(t->slots);
+	t->slots = calloc(t->nslots, sizeof(*t->slots));
+	if (!t->slots) {
+		fprintf(stderr, "Out of memory\n");
+		exit(1);
+	}
+
+	for (size_t i = 0; i < t->num; i++) {
+		size_t s = slot_of(t, t->entries[i].a, t->entries[i].b);
+
+		while (t->slots[s])
+			s = (s + 1) & (t->nslots - 1);
+		t->slots[s] = i + 1;
+	}
+}
+
+/* Returns the index of the entry for (a, b), adding it if needed. */
+static uint32_t table_get(struct table *t, uint64_t a, uint64_t b)
+{
+	size_t s;
+
+	if (2 * (t->num + 1) > t->nslots)
+		table_grow(t);
+
+	for (s = slot_of(t, a, b); t->slots[s]; s = (s + 1) & (t->nslots - 1)) {
+		struct entry *e = &t->entries[t->slots[s] - 1];
+
+		if (e->a == a && e->b == b)
+			return t->slots[s] - 1;
+	}
+
+	if (t->num == t->cap) {
+		t->cap = t->cap ? t->cap * 2 : 1024;
+		t->entries = xrealloc(t->entries, t->cap * sizeof(*t->entries));
+	}
+	memset(&t->entries[t->num], 0, sizeof(t->entries[0]));
+	t->entries[t->num].a = a;
+	t->entries[t->num].b = b;
+	t->slots[s] = t->num + 1;
+
+	return t->num++;
+}
+
+static void pop_frame(struct frame *stack, int *depth, uint64_t tsc)
+{
+	struct frame *fr = &stack[--*depth];
+	uint64_t incl = tsc > fr->start ? tsc - fr->start : 0;
+	uint64_t excl = incl > fr->child ? incl - fr->child : 0;
+	int recursive = 0;
+
+	/* Only count the outermost activation of recursive functions as inclusive time. */
+	for (int i = 0; i < *depth; i++)
+		recursive |= stack[i].func == fr->func;
+	if (!recursive)
+		funcs.entries[fr->func].incl += incl;
+	funcs.entries[fr->func].excl += excl;
+	nodes.entries[fr->node].excl += excl;
+
+	if (*depth)
+		stack[*depth - 1].child += incl;
+}
+
+static void replay_cpu(struct trace_buffer *buf, unsigned int cpu)
+{
+	const struct trace_ring *ring = &buf->rings[cpu];
+	const struct trace_record *recs = trace_buffer_records(buf, cpu);
+	const uint32_t size = buf->records_per_cpu;
+	struct frame stack[MAX_DEPTH];
+	uint32_t first = ring->count > size ? ring->count - size : 0;
+	uint64_t last = 0;
+	int depth = 0;
+	/* Calls deeper than MAX_DEPTH are not tracked, but their exits must be skipped. */
+	int overflow = 0;
+
+	for (uint32_t n = first; n < ring->count; n++) {
+		const struct trace_record *r = &recs[n % size];
+
+		last = r->tsc;
+
+		if (!(r->flags & TRACE_RECORD_EXIT)) {
+			uint32_t func = table_get(&funcs, r->func, 0);
+			uint32_t arc = table_get(&arcs, r->callsite, r->func);
+			uint32_t parent = depth ? stack[depth - 1].node + 1 : 0;
+
+			funcs.entries[func].count++;
+			arcs.entries[arc].count++;
+
+			if (depth == MAX_DEPTH) {
+				overflow++;
+				continue;
+			}
+			stack[depth].node = table_get(&nodes, parent, r->func);
+			stack[depth].func = func;
+			stack[depth].start = r->tsc;
+			stack[depth].child = 0;
+			nodes.entries[stack[depth].node].count++;
+			depth++;
+			continue;
+		}
+
+		if (overflow) {
+			overflow--;
+			continue;
+		}
+
+		/*
+		 * Unwind to the matching entry. Exits without one belong to calls that
+		 * started before the oldest record in the ring.
+		 */
+		int match = depth - 1;
+
+		while (match >= 0 && funcs.entries[stack[match].func].a != r->func)
+			match--;
+		if (match < 0)
+			continue;
+		while (depth > match)
+			pop_frame(stack, &depth, r->tsc);
+	}
+
+	/* Functions still running at the end, e.g. the ramstage main loop. */
+	while (depth)
+		pop_frame(stack, &depth, last);
+}
+
+/*
+ * Start addr2line on the ELF file with its input read from the file 'input'.
+ * Returns a stream with its output, or NULL on error.
+ */
+static FILE *run_addr2line(const char *elf, const char *input, pid_t *pid)
+{
+	char *const argv[] = { "addr2line", "-f", "-e", (char *)elf, NULL };
+	int out[2], in;
+
+	in = open(input, O_RDONLY);
+	if (in < 0)
+		return NULL;
+	if (pipe(out)) {
+		close(in);
+		return NULL;
+	}
+
+	*pid = fork();
+	if (*pid == 0) {
+		dup2(in, STDIN_FILENO);
+		dup2(out[1], STDOUT_FILENO);
+		close(in);
+		close(out[0]);
+		close(out[1]);
+		execvp(argv[0], argv);
+		_exit(127);
+	}
+
+	close(in);
+	close(out[1]);
+	if (*pid < 0) {
+		close(out[0]);
+		return NULL;
+	}
+
+	return fdopen(out[0], "r");
+}
+
+/* Look up function names with addr2line, if an ELF file was given. */
+static void resolve_names(const char *elf)
+{
+	char tmpname[] = "/tmp/genprofXXXXXX";
+	char line[4096];
+	FILE *f, *p;
+	pid_t pid;
+	int fd;
+
+	if (!elf)
+		return;
+
+	fd = mkstemp(tmpname);
+	if (fd < 0 || !(f = fdopen(fd, "w"))) {
+		perror("Unable to create temporary file");
+		return;
+	}
+	for (size_t i = 0; i < funcs.num; i++)
+		fprintf(f, "0x%" PRIx64 "\n", funcs.entries[i].a);
 	fclose(f);
 
+	p = run_addr2line(elf, tmpname, &pid);
+	if (!p) {
+		perror("Unable to run addr2line");
+		unlink(tmpname);
+		return;
+	}
+	/* addr2line prints the function name and the location for each address. */
+	for (size_t i = 0; i < funcs.num && fgets(line, sizeof(line), p); i++) {
+		line[strcspn(line, "\n")] = '\0';
+		if (strcmp(line, "??"))
+			funcs.entries[i].name = strdup(line);
+		if (!fgets(line, sizeof(line), p))
+			break;
+	}
+	fclose(p);
+	waitpid(pid, NULL, 0);
+	unlink(tmpname);
+}
+
+static void print_func(FILE *fo, uint64_t addr)
+{
+	uint32_t func = table_get(&funcs, addr, 0);
+
+	if (funcs.entries[func].name)
+		fputs(funcs.entries[func].name, fo);
+	else
+		fprintf(fo, "0x%08" PRIx64, addr);
+}
+
+static void print_stack(FILE *fo, uint32_t node)
+{
+	if (nodes.entries[node].a)
+		print_stack(fo, nodes.entries[node].a - 1);
+	if (nodes.entries[node].a)
+		fputc(';', fo);
+	print_func(fo, nodes.entries[node].b);
+}
+
+static int cmp_incl(const void *x, const void *y)
+{
+	const struct entry *a = x, *b = y;
+
+	return (a->incl < b->incl) - (a->incl > b->incl);
+}
+
+static int binary_trace_to_gmon(FILE *f, FILE *fo, const char *elf)
+{
+	struct trace_buffer hdr, *buf;
+	uint64_t min = UINT64_MAX, max = 0, max_excl = 0;
+	double ticks_per_us;
+	size_t size, nbins;
+	uint32_t tmp, scale;
+	uint16_t *bins;
+	uint8_t tag;
+	FILE *ff;
+
+	if (fread(&hdr, sizeof(hdr), 1, f) != 1 || hdr.version != TRACE_BUFFER_VERSION ||
+	    !hdr.num_cpus || !hdr.records_per_cpu) {
+		fprintf(stderr, "Unsupported function trace\n");
+		return 1;
+	}
+
+	size = sizeof(hdr) + hdr.num_cpus * sizeof(struct trace_ring) +
+		(size_t)hdr.num_cpus * hdr.records_per_cpu * sizeof(struct trace_record);
+	buf = xrealloc(NULL, size);
+	rewind(f);
+	if (fread(buf, size, 1, f) != 1) {
+		fprintf(stderr, "Function trace is truncated\n");
+		return 1;
+	}
+
+	for (unsigned int cpu = 0; cpu < buf->num_cpus; cpu++)
+		replay_cpu(buf, cpu);
+
+	ticks_per_us = buf->tick_freq_mhz ? buf->tick_freq_mhz : 1;
+	resolve_names(elf);
+
+	/* Flame graph input, one line per calling context with its exclusive time in ns. */
+	ff = fopen("trace.folded", "w");
+	if (ff == NULL) {
+		perror("Unable to open trace.folded");
+		return 1;
+	}
+	for (uint32_t i = 0; i < nodes.num; i++) {
+		uint64_t ns = nodes.entries[i].excl * 1000 / ticks_per_us;
+
+		if (!ns)
+			continue;
+		print_stack(ff, i);
+		fprintf(ff, " %" PRIu64 "\n", ns);
+	}
+	fclose(ff);
+
+	/* gprof data: the call arcs, plus a histogram built from the exclusive times. */
+	for (uint32_t i = 0; i < funcs.num; i++) {
+		if (funcs.entries[i].a < min)
+			min = funcs.entries[i].a;
+		if (funcs.entries[i].a > max)
+			max = funcs.entries[i].a;
+		if (funcs.entries[i].excl > max_excl)
+			max_excl = funcs.entries[i].excl;
+	}
+	if (!funcs.num)
+		min = max = 0;
+	/* One bin per 4 bytes of code, scaled so that the largest count fits. */
+	nbins = (max - min) / 4 + 1;
+	bins = calloc(nbins, sizeof(*bins));
+	if (!bins) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+	scale = max_excl / UINT16_MAX + 1;
+	for (uint32_t i = 0; i < funcs.num; i++)
+		bins[(funcs.entries[i].a - min) / 4] = funcs.entries[i].excl / scale;
+
+	write_gmon_header(fo);
+	tag = GMON_TAG_TIME_HIST;
+	fwrite(&tag, 1, sizeof(tag), fo);
+	tmp = min;
+	fwrite(&tmp, 1, sizeof(tmp), fo);
+	tmp = min + nbins * 4;
+	fwrite(&tmp, 1, sizeof(tmp), fo);
+	tmp = nbins;
+	fwrite(&tmp, 1, sizeof(tmp), fo);
+	/* prof rate: histogram counts per second */
+	tmp = ticks_per_us * 1000000 / scale;
+	fwrite(&tmp, 1, sizeof(tmp), fo);
+	fwrite(GMON_SEC, 1, sizeof(GMON_SEC) - 1, fo);
+	fwrite(bins, sizeof(*bins), nbins, fo);
+	free(bins);
+
+	for (uint32_t i = 0; i < arcs.num; i++)
+		write_gmon_arc(fo, arcs.entries[i].a, arcs.entries[i].b, arcs.entries[i].count);
+
+	/* Summary, with inclusive and exclusive times. */
+	qsort(funcs.entries, funcs.num, sizeof(*funcs.entries), cmp_incl);
+	printf("%10s %14s %14s  %s\n", "calls", "inclusive us", "exclusive us", "function");
+	for (uint32_t i = 0; i < funcs.num; i++) {
+		const struct entry *e = &funcs.entries[i];
+
+		printf("%10" PRIu64 " %14.1f %14.1f  ", e->count, e->incl / ticks_per_us,
+		       e->excl / ticks_per_us);
+		if (e->name)
+			printf("%s\n", e->name);
+		else
+			printf("0x%08" PRIx64 "\n", e->a);
+	}
+
+	free(buf);
 	return 0;
 }
+
+static void usage(const char *name)
+{
+	fprintf(stderr, "usage: %s [-e ELF] TRACE\n\n"
+		"TRACE is either a console log of CONFIG_TRACE or a binary trace\n"
+		"written by `cbmem -F` with CONFIG_TRACE_BINARY. Writes gmon.out,\n"
+		"and for binary traces also trace.folded and a summary. Function\n"
+		"names are looked up in ELF if given.\n", name);
+}
+
+int main(int argc, char* argv[])
+{
+	FILE *f, *fo;
+	const char *elf = NULL;
+	uint32_t magic = 0;
+	int opt, ret;
+
+	while ((opt = getopt(argc, argv, "e:h")) != -1) {
+		switch (opt) {
+		case 'e':
+			elf = optarg;
+			break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (optind + 1 != argc) {
+		fprintf(stderr, "Please specify the coreboot trace log as parameter\n");
+		usage(argv[0]);
+		return 1;
+	}
+
+	f = fopen(argv[optind], "r");
+	if (f == NULL) {
+		perror("Unable to open the input file");
+		return 1;
+	}
+
+	fo = fopen("gmon.out", "w+");
+	if (fo == NULL) {
+		perror("Unable to open the output file");
+		fclose(f);
+		return 1;
+	}
+
+	if (fread(&magic, sizeof(magic), 1, f) != 1)
+		magic = 0;
+	rewind(f);
+
+	if (magic == TRACE_BUFFER_MAGIC)
+		ret = binary_trace_to_gmon(f, fo, elf);
+	else
+		ret = text_log_to_gmon(f, fo);
+
+	fclose(fo);
+	fclose(f);
+
+	return ret;
+}
@@ -3,6 +3,7 @@
 
 #include <stdio.h>
 #include "inteltool.h"
+#include "snapshot.h"
 
 typedef struct { uint16_t addr; uint32_t def; } gpio_default_t;
 
@@ -713,6 +714,9 @@ static int show_baytrail_pad_reg(struct pci_dev *sb){
 	uint32_t val, bank, gpio, offset, size = 0x3000;
 	volatile uint32_t *reg;
 
+	if (snapshot_active())
+		return snapshot_mmio("IOBASE", iobase, size);
+
 	reg = map_physical(iobase, size);
 
 	if (reg == NULL) {
@@ -764,6 +768,33 @@ static int show_baytrail_pad_reg(struct pci_dev *sb){
 
 static uint16_t gpiobase;
 
+static int snapshot_gpios(struct pci_dev *sb, const io_register_t *gpio_registers,
+			  int size)
+{
+	size_t span = 0;
+	int i;
+
+	for (i = 0; i < size; i++)
+		span = MAX(span, (size_t)gpio_registers[i].addr + gpio_registers[i].size);
+
+	switch (sb->device_id) {
+	case PCI_DEVICE_ID_INTEL_LYNXPOINT_LP_FULL:
+	case PCI_DEVICE_ID_INTEL_LYNXPOINT_LP_PREM:
+	case PCI_DEVICE_ID_INTEL_LYNXPOINT_LP_BASE:
+	case PCI_DEVICE_ID_INTEL_WILDCATPOINT_LP_PREM:
+	case PCI_DEVICE_ID_INTEL_WILDCATPOINT_LP:
+		/* GPnCONFIGA/B of the 95 GPIOs */
+		span = MAX(span, 0x100 + 95 * 8);
+		break;
+	}
+
+	snapshot_io("GPIOBASE", gpiobase, span);
+
+	if (sb->device_id == PCI_DEVICE_ID_INTEL_BAYTRAIL_LPC)
+		return show_baytrail_pad_reg(sb);
+	return 0;
+}
+
 static void print_reg(const io_register_t *const reg)
 {
 	switch (reg->size) {
@@ -1077,6 +1108,9 @@ int print_gpios(struct pci_dev *sb, int show_all, int show_diffs)
 		return 1;
 	}
 
+	if (snapshot_active())
+		return snapshot_gpios(sb, gpio_registers, size);
+
 	if (show_diffs && !show_all)
 		printf("\n========== GPIO DIFFS ===========\n\n");
 	else
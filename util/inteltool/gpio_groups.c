@@ -9,6 +9,7 @@
 #include <inttypes.h>
 #include "inteltool.h"
 #include "pcr.h"
+#include "snapshot.h"
 
 #include "gpio_names/apollolake.h"
 #include "gpio_names/cannonlake.h"
@@ -63,8 +64,9 @@ static void print_gpio_community(const struct gpio_community *const community,
 	size_t group, pad_count;
 	size_t pad_cfg; /* offset in bytes under this communities PCR port */
 
-	printf("%s\n\nPCR Port ID: 0x%06zx\n\n",
-	       community->name, (size_t)community->pcr_port_id << 16);
+	if (!snapshot_active())
+		printf("%s\n\nPCR Port ID: 0x%06zx\n\n",
+		       community->name, (size_t)community->pcr_port_id << 16);
 
 	for (group = 0, pad_count = 0; group < community->group_count; ++group)
 		pad_count += community->groups[group]->pad_count;
@@ -76,6 +78,12 @@ static void print_gpio_community(const struct gpio_community *const community,
 		return;
 	}
 
+	if (snapshot_active()) {
+		snapshot_pcr(community->name, community->pcr_port_id,
+			     MIN(pad_cfg + pad_count * pad_stepping, PCR_PORT_SIZE));
+		return;
+	}
+
 	for (group = 0; group < community->group_count; ++group) {
 		print_gpio_group(community->pcr_port_id,
 				 pad_cfg, community->groups[group],
@@ -182,7 +190,8 @@ void print_gpio_groups(struct pci_dev *const sb)
 
 	pcr_init(sb);
 
-	printf("\n============= GPIOS =============\n\n");
+	if (!snapshot_active())
+		printf("\n============= GPIOS =============\n\n");
 
 	for (; community_count; --community_count)
 		print_gpio_community(*communities++, pad_stepping);
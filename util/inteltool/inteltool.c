@@ -12,6 +12,7 @@
 #include <errno.h>
 #include "inteltool.h"
 #include "pcr.h"
+#include "snapshot.h"
 
 #ifdef __NetBSD__
 #include <machine/sysarch.h>
@@ -442,9 +443,30 @@ static const struct {
 #ifndef __DARWIN__
 static int fd_mem;
 
+/*
+ * Several dumps map the same BAR (e.g. RCBA for --rcba and --spi), so
+ * mappings are kept until the end and handed out again. Larger ones, like
+ * PCIEXBAR, are not worth the address space.
+ */
+#define MAX_MAPPINGS		16
+#define MAX_KEPT_MAPPING	SBBAR_SIZE
+
+static struct {
+	uint64_t phys;
+	size_t len;
+	uint8_t *virt;
+} mappings[MAX_MAPPINGS];
+
 void *map_physical(uint64_t phys_addr, size_t len)
 {
 	void *virt_addr;
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(mappings); i++) {
+		if (mappings[i].virt && phys_addr >= mappings[i].phys &&
+		    phys_addr + len <= mappings[i].phys + mappings[i].len)
+			return mappings[i].virt + (phys_addr - mappings[i].phys);
+	}
 
 	virt_addr = mmap(0, len, PROT_WRITE | PROT_READ, MAP_SHARED,
 		    fd_mem, (off_t) phys_addr);
@@ -455,13 +477,41 @@ void *map_physical(uint64_t phys_addr, size_t len)
 		return NULL;
 	}
 
+	for (i = 0; len <= MAX_KEPT_MAPPING && i < ARRAY_SIZE(mappings); i++) {
+		if (!mappings[i].virt) {
+			mappings[i].phys = phys_addr;
+			mappings[i].len = len;
+			mappings[i].virt = virt_addr;
+			break;
+		}
+	}
+
 	return virt_addr;
 }
 
 void unmap_physical(void *virt_addr, size_t len)
 {
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(mappings); i++) {
+		if (mappings[i].virt && (uint8_t *)virt_addr >= mappings[i].virt &&
+		    (uint8_t *)virt_addr < mappings[i].virt + mappings[i].len)
+			return;
+	}
+
 	munmap(virt_addr, len);
 }
+
+static void unmap_all(void)
+{
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(mappings); i++) {
+		if (mappings[i].virt)
+			munmap(mappings[i].virt, mappings[i].len);
+		mappings[i].virt = NULL;
+	}
+}
 #endif
 
 static void print_version(void)
@@ -480,7 +530,8 @@ static void print_version(void)
 
 static void print_usage(const char *name)
 {
-	printf("usage: %s [-vh?gGrplmedPMaAsfSRx]\n", name);
+	printf("usage: %s [-vh?gGrplmedPMaAsfSRx] [-o FILE]\n"
+	       "       %s -D FILE [FILE2]\n", name, name);
 	printf("\n"
 	     "   -v | --version:                   print the version\n"
 	     "   -h | --help:                      print this help\n\n"
@@ -502,7 +553,11 @@ static void print_usage(const char *name)
 	     "   -x | --sgx:                       dump SGX status\n"
 	     "   -a | --all:                       dump all known (safe) registers\n"
 	     "        --pcr=PORT_ID:               dump all registers of a PCR port\n"
-	     "                                     (may be specified max %d times)\n"
+	     "                                     (may be specified max %d times)\n\n"
+	     "   -o FILE | --snapshot=FILE:        copy the GPIO, RCBA, MCHBAR, EPBAR, DMIBAR,\n"
+	     "                                     PCIEXBAR and PCR dumps into a binary file\n"
+	     "   -D FILE | --decode=FILE:          print a snapshot, or with a second FILE\n"
+	     "                                     the registers that differ\n"
 	     "\n", MAX_PCR_PORTS);
 	exit(1);
 }
@@ -555,6 +610,7 @@ int main(int argc, char *argv[])
 	struct pci_access *pacc;
 	struct pci_dev *sb = NULL, *nb, *gfx = NULL, *ahci = NULL, *dev;
 	const char *dump_spd_file = NULL;
+	const char *snapshot_file = NULL, *decode_file = NULL;
 	int opt, option_index = 0;
 
 	int dump_gpios = 0, dump_mchbar = 0, dump_rcba = 0;
@@ -587,10 +643,12 @@ int main(int argc, char *argv[])
 		{"ahci", 0, 0, 'R'},
 		{"sgx", 0, 0, 'x'},
 		{"pcr", required_argument, 0, LONG_OPT_PCR},
+		{"snapshot", required_argument, 0, 'o'},
+		{"decode", required_argument, 0, 'D'},
 		{0, 0, 0, 0}
 	};
 
-	while ((opt = getopt_long(argc, argv, "vh?gGrplmedPMaAsfRS:x",
+	while ((opt = getopt_long(argc, argv, "vh?gGrplmedPMaAsfRS:xo:D:",
                                   long_options, &option_index)) != EOF) {
 		switch (opt) {
 		case 'v':
@@ -662,6 +720,12 @@ int main(int argc, char *argv[])
 		case 'x':
 			dump_sgx = 1;
 			break;
+		case 'o':
+			snapshot_file = optarg;
+			break;
+		case 'D':
+			decode_file = optarg;
+			break;
 		case LONG_OPT_PCR:
 			if (pcr_count < MAX_PCR_PORTS) {
 				errno = 0;
@@ -686,6 +750,10 @@ int main(int argc, char *argv[])
 		}
 	}
 
+	if (decode_file)
+		return snapshot_decode(decode_file,
+				       optind < argc ? argv[optind] : NULL);
+
 #if defined(__FreeBSD__)
 	if (open("/dev/io", O_RDWR) < 0) {
 		perror("/dev/io");
@@ -790,6 +858,16 @@ int main(int argc, char *argv[])
 
 	print_system_info(nb, sb, gfx);
 
+	if (snapshot_file) {
+		if (snapshot_open(snapshot_file, nb, sb))
+			exit(1);
+		if (dump_pmbase || dump_lpc || dump_coremsrs || dump_ambs ||
+		    dump_spi || dump_gfx || dump_ahci || dump_sgx)
+			printf("Snapshots skip PMBASE, LPC, MSR, AMB, SPI, GFX, AHCI and SGX.\n");
+		dump_pmbase = dump_lpc = dump_coremsrs = dump_ambs = 0;
+		dump_spi = dump_gfx = dump_ahci = dump_sgx = 0;
+	}
+
 	/* Now do the deed */
 	if (dump_gpios) {
 		print_gpios(sb, 1, show_gpio_diffs);
@@ -857,8 +935,13 @@ int main(int argc, char *argv[])
 	if (pcr_count)
 		print_pcr_ports(sb, dump_pcr, pcr_count);
 
+	snapshot_close();
+
 	/* Clean up */
 	pcr_cleanup();
+#ifndef __DARWIN__
+	unmap_all();
+#endif
 	if (ahci)
 		pci_free_dev(ahci);
 	if (gfx)
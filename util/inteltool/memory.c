@@ -6,6 +6,7 @@
 #include <stdlib.h>
 #include <inttypes.h>
 #include "inteltool.h"
+#include "snapshot.h"
 
 volatile uint8_t *mchbar;
 
@@ -235,6 +236,9 @@ int print_mchbar(struct pci_dev *nb, struct pci_access *pacc, const char *dump_s
 		return 1;
 	}
 
+	if (snapshot_active())
+		return snapshot_mmio("MCHBAR", mchbar_phys, size);
+
 	mchbar = map_physical(mchbar_phys, size);
 
 	if (mchbar == NULL) {
@@ -5,6 +5,7 @@
 #include <stdlib.h>
 #include <inttypes.h>
 #include "inteltool.h"
+#include "snapshot.h"
 
 /* 320766 */
 static const io_register_t nehalem_dmi_registers[] = {
@@ -278,6 +279,9 @@ int print_epbar(struct pci_dev *nb)
 		return 1;
 	}
 
+	if (snapshot_active())
+		return snapshot_mmio("EPBAR", epbar_phys, size);
+
 	epbar = map_physical(epbar_phys, size);
 
 	if (epbar == NULL) {
@@ -405,6 +409,11 @@ int print_dmibar(struct pci_dev *nb)
 		return 1;
 	}
 
+	/* With a register list, size is its length, not that of DMIBAR. */
+	if (snapshot_active())
+		return snapshot_mmio("DMIBAR", dmibar_phys,
+				     dmi_registers ? 4 * KiB : (size_t)size);
+
 	dmibar = map_physical(dmibar_phys, size);
 
 	if (dmibar == NULL) {
@@ -546,7 +555,8 @@ int print_pciexbar(struct pci_dev *nb)
 		return 1;
 	}
 
-	printf("PCIEXBAR: 0x%08" PRIx64 "\n", pciexbar_phys);
+	if (!snapshot_active())
+		printf("PCIEXBAR: 0x%08" PRIx64 "\n", pciexbar_phys);
 
 	pciexbar = map_physical(pciexbar_phys, (max_busses * 1024 * 1024));
 
@@ -572,6 +582,15 @@ int print_pciexbar(struct pci_dev *nb)
 					continue;
 				}
 
+				if (snapshot_active()) {
+					char name[32];
+
+					snprintf(name, sizeof(name), "PCIe %02x:%02x.%01x", bus, dev, fn);
+					snapshot_mapped(SNAPSHOT_MMIO, name, pciexbar_phys + devbase,
+							pciexbar + devbase, 4 * KiB);
+					continue;
+				}
+
 				printf("\nPCIe %02x:%02x.%01x extended config space:", bus, dev, fn);
 				for (i = 0; i < 4096; i++) {
 					if((i % 0x10) == 0)
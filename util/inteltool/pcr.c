@@ -8,6 +8,7 @@
 #include <inttypes.h>
 #include <assert.h>
 #include "pcr.h"
+#include "snapshot.h"
 
 const uint8_t *sbbar = NULL;
 
@@ -41,14 +42,26 @@ static void print_pcr_port(const uint8_t port)
 		printf("*\n");
 }
 
+void snapshot_pcr(const char *const name, const uint8_t port, const size_t size)
+{
+	assert(sbbar);
+	snapshot_mapped(SNAPSHOT_PCR, name, port, sbbar + (port << 16), size);
+}
+
 void print_pcr_ports(struct pci_dev *const sb,
 		     const uint8_t *const ports, const size_t count)
 {
+	char name[16];
 	size_t i;
 
 	pcr_init(sb);
 
 	for (i = 0; i < count; ++i) {
+		if (snapshot_active()) {
+			snprintf(name, sizeof(name), "PCR 0x%02x", ports[i]);
+			snapshot_pcr(name, ports[i], PCR_PORT_SIZE);
+			continue;
+		}
 		printf("\n========== PCR 0x%02x ==========\n\n", ports[i]);
 		print_pcr_port(ports[i]);
 	}
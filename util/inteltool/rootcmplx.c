@@ -4,6 +4,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "inteltool.h"
+#include "snapshot.h"
 
 int print_rcba(struct pci_dev *sb)
 {
@@ -125,6 +126,9 @@ int print_rcba(struct pci_dev *sb)
 		return 1;
 	}
 
+	if (snapshot_active())
+		return snapshot_mmio("RCBA", rcba_phys, size);
+
 	rcba = map_physical(rcba_phys, size);
 
 	if (rcba == NULL) {
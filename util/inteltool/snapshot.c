@@ -0,0 +1,345 @@
+/* inteltool - dump all registers on an Intel CPU + chipset based system */
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+#include "inteltool.h"
+#include "snapshot.h"
+
+/*
+ * Snapshot mode copies whole register spaces into a binary file instead of
+ * printing every register, so that the state of a machine can be captured
+ * in a few milliseconds and looked at later with --decode.
+ */
+
+static FILE *snapshot_file;
+static const char *snapshot_filename;
+static unsigned int snapshot_regions;
+static uint64_t snapshot_bytes;
+
+struct loaded_region {
+	struct snapshot_region hdr;
+	uint8_t *data;
+};
+
+struct loaded_snapshot {
+	struct snapshot_header hdr;
+	size_t count;
+	struct loaded_region *regions;
+};
+
+int snapshot_open(const char *filename, struct pci_dev *nb, struct pci_dev *sb)
+{
+	struct snapshot_header hdr;
+
+	snapshot_file = fopen(filename, "wb");
+	if (!snapshot_file) {
+		perror(filename);
+		return 1;
+	}
+	snapshot_filename = filename;
+
+	memset(&hdr, 0, sizeof(hdr));
+	memcpy(hdr.magic, SNAPSHOT_MAGIC, sizeof(hdr.magic));
+	hdr.version = SNAPSHOT_VERSION;
+	hdr.cpuid = cpuid(1);
+	hdr.nb_vendor = nb->vendor_id;
+	hdr.nb_device = nb->device_id;
+	hdr.sb_vendor = sb->vendor_id;
+	hdr.sb_device = sb->device_id;
+	hdr.timestamp = time(NULL);
+
+	if (fwrite(&hdr, sizeof(hdr), 1, snapshot_file) != 1) {
+		perror(filename);
+		return 1;
+	}
+	return 0;
+}
+
+int snapshot_active(void)
+{
+	return snapshot_file != NULL;
+}
+
+static void snapshot_write(enum snapshot_space space, const char *name,
+			   uint64_t base, const uint32_t *data, size_t size)
+{
+	struct snapshot_region region;
+
+	memset(&region, 0, sizeof(region));
+	strncpy(region.name, name, sizeof(region.name) - 1);
+	region.space = space;
+	region.size = size;
+	region.base = base;
+
+	if (fwrite(&region, sizeof(region), 1, snapshot_file) != 1 ||
+	    fwrite(data, size, 1, snapshot_file) != 1) {
+		perror(snapshot_filename);
+		exit(1);
+	}
+	snapshot_regions++;
+	snapshot_bytes += size;
+}
+
+void snapshot_mapped(enum snapshot_space space, const char *name, uint64_t base,
+		     const volatile uint8_t *virt, size_t size)
+{
+	uint32_t *data;
+	size_t i;
+
+	size &= ~(size_t)3;
+	data = malloc(size);
+	if (!data) {
+		perror("malloc");
+		exit(1);
+	}
+
+	/* Registers only decode 32-bit accesses, no memcpy(). */
+	for (i = 0; i < size; i += 4)
+		data[i / 4] = read32(virt + i);
+
+	snapshot_write(space, name, base, data, size);
+	free(data);
+}
+
+int snapshot_mmio(const char *name, uint64_t phys, size_t size)
+{
+	const volatile uint8_t *virt;
+
+	virt = map_physical(phys, size);
+	if (virt == NULL) {
+		fprintf(stderr, "Error mapping %s\n", name);
+		return 1;
+	}
+
+	snapshot_mapped(SNAPSHOT_MMIO, name, phys, virt, size);
+	unmap_physical((void *)virt, size);
+	return 0;
+}
+
+void snapshot_io(const char *name, uint16_t port, size_t size)
+{
+	uint32_t *data;
+	size_t i;
+
+	size = ALIGN_UP(size, 4);
+	data = malloc(size);
+	if (!data) {
+		perror("malloc");
+		exit(1);
+	}
+
+	for (i = 0; i < size; i += 4)
+		data[i / 4] = inl(port + i);
+
+	snapshot_write(SNAPSHOT_IO, name, port, data, size);
+	free(data);
+}
+
+void snapshot_close(void)
+{
+	if (!snapshot_file)
+		return;
+
+	if (fclose(snapshot_file)) {
+		perror(snapshot_filename);
+		exit(1);
+	}
+	snapshot_file = NULL;
+
+	printf("Wrote %u regions, %" PRIu64 " bytes of registers to %s\n",
+	       snapshot_regions, snapshot_bytes, snapshot_filename);
+}
+
+static void snapshot_free(struct loaded_snapshot *snap)
+{
+	size_t i;
+
+	for (i = 0; i < snap->count; i++)
+		free(snap->regions[i].data);
+	free(snap->regions);
+}
+
+static int snapshot_load(const char *filename, struct loaded_snapshot *snap)
+{
+	struct loaded_region *r;
+	FILE *f;
+
+	f = fopen(filename, "rb");
+	if (!f) {
+		perror(filename);
+		return SNAPSHOT_ERROR;
+	}
+
+	memset(snap, 0, sizeof(*snap));
+	if (fread(&snap->hdr, sizeof(snap->hdr), 1, f) != 1 ||
+	    memcmp(snap->hdr.magic, SNAPSHOT_MAGIC, sizeof(snap->hdr.magic)) ||
+	    snap->hdr.version != SNAPSHOT_VERSION) {
+		fprintf(stderr, "%s: not an inteltool snapshot\n", filename);
+		fclose(f);
+		return SNAPSHOT_ERROR;
+	}
+
+	for (;;) {
+		snap->regions = realloc(snap->regions,
+					(snap->count + 1) * sizeof(*snap->regions));
+		if (!snap->regions) {
+			perror("realloc");
+			exit(1);
+		}
+		r = &snap->regions[snap->count];
+		r->data = NULL;
+		if (fread(&r->hdr, sizeof(r->hdr), 1, f) != 1)
+			break;
+		r->hdr.name[sizeof(r->hdr.name) - 1] = '\0';
+		r->data = malloc(r->hdr.size);
+		if (r->hdr.size % 4 || !r->data ||
+		    fread(r->data, r->hdr.size, 1, f) != 1) {
+			fprintf(stderr, "%s: truncated region %s\n", filename,
+				r->hdr.name);
+			free(r->data);
+			snapshot_free(snap);
+			fclose(f);
+			return SNAPSHOT_ERROR;
+		}
+		snap->count++;
+	}
+
+	fclose(f);
+	return 0;
+}
+
+static void print_snapshot_info(const char *filename,
+				const struct loaded_snapshot *snap)
+{
+	const time_t t = snap->hdr.timestamp;
+
+	printf("%s: taken %s", filename, ctime(&t));
+	printf("CPU: ID 0x%x\n", snap->hdr.cpuid);
+	printf("Northbridge: %04x:%04x\n", snap->hdr.nb_vendor, snap->hdr.nb_device);
+	printf("Southbridge: %04x:%04x\n\n", snap->hdr.sb_vendor, snap->hdr.sb_device);
+}
+
+static void print_region_header(const struct snapshot_region *r)
+{
+	switch (r->space) {
+	case SNAPSHOT_MMIO:
+		printf("%s = 0x%08" PRIx64 " (MEM)\n\n", r->name, r->base);
+		break;
+	case SNAPSHOT_IO:
+		printf("%s = 0x%04" PRIx64 " (IO)\n\n", r->name, r->base);
+		break;
+	case SNAPSHOT_PCR:
+		printf("%s = PCR port 0x%02" PRIx64 "\n\n", r->name, r->base);
+		break;
+	default:
+		printf("%s = 0x%08" PRIx64 " (unknown space %u)\n\n",
+		       r->name, r->base, r->space);
+	}
+}
+
+static const uint32_t *region_reg(const struct loaded_region *r, size_t offset)
+{
+	return (const uint32_t *)(r->data + offset);
+}
+
+static void print_region(const struct loaded_region *r)
+{
+	size_t i;
+
+	print_region_header(&r->hdr);
+	for (i = 0; i < r->hdr.size; i += 4) {
+		if (*region_reg(r, i))
+			printf("0x%04zx: 0x%08" PRIx32 "\n", i, *region_reg(r, i));
+	}
+	printf("\n");
+}
+
+static const struct loaded_region *find_region(const struct loaded_snapshot *snap,
+					       const struct snapshot_region *hdr)
+{
+	size_t i;
+
+	for (i = 0; i < snap->count; i++) {
+		const struct snapshot_region *r = &snap->regions[i].hdr;
+
+		if (r->space == hdr->space && r->base == hdr->base &&
+		    !strcmp(r->name, hdr->name))
+			return &snap->regions[i];
+	}
+	return NULL;
+}
+
+static unsigned int diff_region(const struct loaded_region *a,
+				const struct loaded_region *b)
+{
+	const size_t size = MIN(a->hdr.size, b->hdr.size);
+	unsigned int changed = 0;
+	size_t i;
+
+	for (i = 0; i < size; i += 4) {
+		if (*region_reg(a, i) == *region_reg(b, i))
+			continue;
+		printf("%s+0x%04zx: 0x%08" PRIx32 " -> 0x%08" PRIx32 "\n",
+		       a->hdr.name, i, *region_reg(a, i), *region_reg(b, i));
+		changed++;
+	}
+	if (a->hdr.size != b->hdr.size) {
+		printf("%s: size changed from 0x%x to 0x%x\n",
+		       a->hdr.name, a->hdr.size, b->hdr.size);
+		changed++;
+	}
+	return changed;
+}
+
+int snapshot_decode(const char *filename, const char *other)
+{
+	struct loaded_snapshot a, b;
+	const struct loaded_region *r;
+	unsigned int changed = 0, unmatched = 0;
+	size_t i;
+
+	if (snapshot_load(filename, &a))
+		return SNAPSHOT_ERROR;
+
+	if (!other) {
+		print_snapshot_info(filename, &a);
+		for (i = 0; i < a.count; i++)
+			print_region(&a.regions[i]);
+		snapshot_free(&a);
+		return 0;
+	}
+
+	if (snapshot_load(other, &b)) {
+		snapshot_free(&a);
+		return SNAPSHOT_ERROR;
+	}
+
+	print_snapshot_info(filename, &a);
+	print_snapshot_info(other, &b);
+
+	for (i = 0; i < a.count; i++) {
+		r = find_region(&b, &a.regions[i].hdr);
+		if (r) {
+			changed += diff_region(&a.regions[i], r);
+		} else {
+			printf("%s: only in %s\n", a.regions[i].hdr.name, filename);
+			unmatched++;
+		}
+	}
+	for (i = 0; i < b.count; i++) {
+		if (!find_region(&a, &b.regions[i].hdr)) {
+			printf("%s: only in %s\n", b.regions[i].hdr.name, other);
+			unmatched++;
+		}
+	}
+	printf("%u registers differ, %u regions only in one snapshot\n",
+	       changed, unmatched);
+
+	snapshot_free(&a);
+	snapshot_free(&b);
+	return changed || unmatched ? SNAPSHOT_DIFFERENT : 0;
+}
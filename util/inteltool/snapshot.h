@@ -0,0 +1,64 @@
+/* inteltool - dump all registers on an Intel CPU + chipset based system */
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef INTELTOOL_SNAPSHOT_H
+#define INTELTOOL_SNAPSHOT_H 1
+
+#include <stddef.h>
+#include <stdint.h>
+#include "inteltool.h"
+
+/*
+ * A snapshot is a snapshot_header followed by any number of regions, each a
+ * snapshot_region and `size` bytes of register contents, all in host (little
+ * endian) byte order.
+ */
+#define SNAPSHOT_MAGIC		"ITSNAPSH"
+#define SNAPSHOT_VERSION	1
+
+enum snapshot_space {
+	SNAPSHOT_MMIO = 1,	/* base is the physical address */
+	SNAPSHOT_IO = 2,	/* base is the I/O port */
+	SNAPSHOT_PCR = 3,	/* base is the PCR port ID */
+};
+
+struct snapshot_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t cpuid;		/* CPUID leaf 1, EAX */
+	uint16_t nb_vendor;
+	uint16_t nb_device;
+	uint16_t sb_vendor;
+	uint16_t sb_device;
+	uint64_t timestamp;	/* seconds since the epoch */
+};
+
+struct snapshot_region {
+	char name[32];
+	uint32_t space;
+	uint32_t size;
+	uint64_t base;
+};
+
+int snapshot_open(const char *filename, struct pci_dev *nb, struct pci_dev *sb);
+int snapshot_active(void);
+/* Maps, copies and unmaps `size` bytes at `phys`. */
+int snapshot_mmio(const char *name, uint64_t phys, size_t size);
+/* Copies from an existing mapping. */
+void snapshot_mapped(enum snapshot_space space, const char *name, uint64_t base,
+		     const volatile uint8_t *virt, size_t size);
+void snapshot_io(const char *name, uint16_t port, size_t size);
+void snapshot_close(void);
+
+/* Exit codes of snapshot_decode(), like diff(1). */
+#define SNAPSHOT_DIFFERENT	1
+#define SNAPSHOT_ERROR		2
+
+/*
+ * Prints a snapshot as text, or only the differences to a second one. Returns
+ * 0, SNAPSHOT_DIFFERENT if the two snapshots differ, or SNAPSHOT_ERROR if a
+ * file could not be read.
+ */
+int snapshot_decode(const char *filename, const char *other);
+
+#endif
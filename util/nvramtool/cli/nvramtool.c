@@ -268,8 +268,14 @@ static void op_cmos_show_all_params(void)
 	int result;
 
 	get_cmos_layout();
+
+	/* Read CMOS once instead of once per parameter. */
+	set_iopl(3);
+	cmos_cache_open();
+	set_iopl(0);
 	result = list_all_params();
 	cmos_checksum_verify();
+	cmos_cache_close();
 
 	if (result)
 		exit(1);
@@ -660,8 +666,10 @@ static void set_one_param(const char name[], const char value[])
 
 	/* write the value to nonvolatile RAM */
 	set_iopl(3);
+	cmos_cache_open();
 	cmos_write(e, n);
 	cmos_checksum_write(cmos_checksum_compute());
+	cmos_cache_close();
 	set_iopl(0);
 	return;
 
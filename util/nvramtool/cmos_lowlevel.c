@@ -18,6 +18,13 @@ static cmos_access_t *current_access =
 	&memory_hal;
 #endif
 
+/* In-memory image of CMOS while a cmos_cache_open() is in effect.  The
+ * real time clock area is never cached.
+ */
+static int cmos_cache_depth = 0;
+static unsigned char cmos_cache[CMOS_SIZE];
+static unsigned char cmos_cache_orig[CMOS_SIZE];
+
 void select_hal(hal_t hal, void *data)
 {
 	switch(hal) {
@@ -185,6 +192,9 @@ void cmos_write(const cmos_entry_t * e, unsigned long long value)
  ****************************************************************************/
 unsigned char cmos_read_byte(unsigned index)
 {
+	if (cmos_cache_depth && !verify_cmos_byte_index(index))
+		return cmos_cache[index];
+
 	return current_access->read(index);
 }
 
@@ -200,9 +210,62 @@ unsigned char cmos_read_byte(unsigned index)
  ****************************************************************************/
 void cmos_write_byte(unsigned index, unsigned char value)
 {
+	if (cmos_cache_depth && !verify_cmos_byte_index(index)) {
+		cmos_cache[index] = value;
+		return;
+	}
+
 	current_access->write(index, value);
 }
 
+/****************************************************************************
+ * cmos_cache_open
+ *
+ * Read all of CMOS memory outside the real time clock area once and direct
+ * all further byte accesses to this in-memory image, until the matching
+ * call to cmos_cache_close().  Calls may be nested.  The I/O privilege level
+ * of the currently executing process must be set appropriately.
+ ****************************************************************************/
+void cmos_cache_open(void)
+{
+	unsigned i;
+
+	if (cmos_cache_depth++)
+		return;
+
+	for (i = CMOS_RTC_AREA_SIZE; i < CMOS_SIZE; i++)
+		cmos_cache[i] = current_access->read(i);
+
+	memcpy(cmos_cache_orig, cmos_cache, sizeof(cmos_cache));
+}
+
+/****************************************************************************
+ * cmos_cache_close
+ *
+ * End the outermost cmos_cache_open() by writing the bytes that changed
+ * since then back to CMOS memory.  Return the number of bytes written.  The
+ * I/O privilege level of the currently executing process must be set
+ * appropriately if anything was changed.
+ ****************************************************************************/
+unsigned cmos_cache_close(void)
+{
+	unsigned i, n = 0;
+
+	assert(cmos_cache_depth > 0);
+
+	if (--cmos_cache_depth)
+		return 0;
+
+	for (i = CMOS_RTC_AREA_SIZE; i < CMOS_SIZE; i++) {
+		if (cmos_cache[i] != cmos_cache_orig[i]) {
+			current_access->write(i, cmos_cache[i]);
+			n++;
+		}
+	}
+
+	return n;
+}
+
 /****************************************************************************
  * cmos_read_all
  *
@@ -130,7 +130,11 @@ void do_cmos_writes(cmos_write_t * list)
 {
 	cmos_write_t *item;
 
+	/* Apply all writes to an in-memory image of CMOS, so that each byte is
+	 * read once and only the bytes that change are written back.
+	 */
 	set_iopl(3);
+	cmos_cache_open();
 
 	while (list != NULL) {
 		cmos_entry_t e;
@@ -144,6 +148,7 @@ void do_cmos_writes(cmos_write_t * list)
 	}
 
 	cmos_checksum_write(cmos_checksum_compute());
+	cmos_cache_close();
 	set_iopl(0);
 }
 
@@ -23,6 +23,8 @@ static int areas_overlap(unsigned area_0_start, unsigned area_0_length,
 			 unsigned area_1_start, unsigned area_1_length);
 static int entries_overlap(const cmos_entry_t * p, const cmos_entry_t * q);
 static const cmos_enum_item_t *find_first_cmos_enum_id(unsigned config_id);
+static unsigned cmos_entry_name_hash(const char name[]);
+static void build_cmos_entry_index(void);
 
 const char checksum_param_name[] = "check_sum";
 
@@ -59,6 +61,13 @@ unsigned cmos_checksum_index = CMOS_CHECKSUM_INDEX;
  */
 static cmos_entry_item_t *cmos_entry_list = NULL;
 
+/* Open addressed hash table over the names in 'cmos_entry_list', used by
+ * find_cmos_entry().  It is built on first use and dropped whenever an entry
+ * is added.  'cmos_entry_index_size' is a power of 2.
+ */
+static const cmos_entry_t **cmos_entry_index = NULL;
+static unsigned cmos_entry_index_size = 0;
+
 /* List is sorted in ascending order: first by 'config_id' and then by
  * 'value'.
  */
@@ -154,6 +163,10 @@ int add_cmos_entry(const cmos_entry_t * e, const cmos_entry_t ** conflict)
 
 	new_entry->item = *e;
 
+	free(cmos_entry_index);
+	cmos_entry_index = NULL;
+	cmos_entry_index_size = 0;
+
 	if (cmos_entry_list == NULL) {
 		new_entry->next = NULL;
 		cmos_entry_list = new_entry;
@@ -205,16 +218,75 @@ int add_cmos_entry(const cmos_entry_t * e, const cmos_entry_t ** conflict)
  ****************************************************************************/
 const cmos_entry_t *find_cmos_entry(const char name[])
 {
-	cmos_entry_item_t *item;
+	unsigned i, mask;
 
-	for (item = cmos_entry_list; item != NULL; item = item->next) {
-		if (!strcmp(item->item.name, name))
-			return &item->item;
+	if (cmos_entry_list == NULL)
+		return NULL;
+
+	if (cmos_entry_index == NULL)
+		build_cmos_entry_index();
+
+	mask = cmos_entry_index_size - 1;
+
+	for (i = cmos_entry_name_hash(name) & mask; cmos_entry_index[i] != NULL;
+	     i = (i + 1) & mask) {
+		if (!strcmp(cmos_entry_index[i]->name, name))
+			return cmos_entry_index[i];
 	}
 
 	return NULL;
 }
 
+/****************************************************************************
+ * cmos_entry_name_hash
+ *
+ * Return the FNV-1a hash of the CMOS parameter name 'name'.
+ ****************************************************************************/
+static unsigned cmos_entry_name_hash(const char name[])
+{
+	uint32_t h = 0x811c9dc5;
+
+	while (*name)
+		h = (h ^ (unsigned char)*name++) * 0x01000193;
+
+	return h;
+}
+
+/****************************************************************************
+ * build_cmos_entry_index
+ *
+ * Build the hash table used by find_cmos_entry().  The table is kept at
+ * most half full.  If several entries share a name, the first one in
+ * 'cmos_entry_list' is found, as with a linear search of the list.
+ ****************************************************************************/
+static void build_cmos_entry_index(void)
+{
+	const cmos_entry_item_t *item;
+	unsigned i, n, size, mask;
+
+	for (item = cmos_entry_list, n = 0; item != NULL; item = item->next)
+		n++;
+
+	for (size = 16; size < 2 * n; size *= 2) ;
+
+	if ((cmos_entry_index = calloc(size, sizeof(*cmos_entry_index))) == NULL)
+		out_of_memory();
+
+	cmos_entry_index_size = size;
+	mask = size - 1;
+
+	for (item = cmos_entry_list; item != NULL; item = item->next) {
+		for (i = cmos_entry_name_hash(item->item.name) & mask;
+		     cmos_entry_index[i] != NULL; i = (i + 1) & mask) {
+			if (!strcmp(cmos_entry_index[i]->name, item->item.name))
+				break;
+		}
+
+		if (cmos_entry_index[i] == NULL)
+			cmos_entry_index[i] = &item->item;
+	}
+}
+
 /****************************************************************************
  * first_cmos_entry
  *
@@ -1,100 +1,430 @@
 /* spkmodem-recv.c - decode spkmodem signals */
 /* SPDX-License-Identifier: GPL-2.0-or-later */
 
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
-/* Compilation:  gcc -o spkmodem-recv spkmodem-recv  */
+/* Compilation:  gcc -O2 -o spkmodem-recv spkmodem-recv.c -lm  */
 /* Usage: parec --channels=1 --rate=48000 --format=s16le | ./spkmodem-recv */
+/*        ./spkmodem-recv [-s speed] recording.wav */
 
-#define SAMPLES_PER_TRAME 240
-#define FREQ_SEP_MIN 5
-#define FREQ_SEP_MAX 15
-#define FREQ_DATA_MIN 15
-#define FREQ_DATA_THRESHOLD 25
-#define FREQ_DATA_MAX 60
-#define THRESHOLD 500
+/*
+ * Every bit is sent as a data tone of 2000 Hz (1) or 4000 Hz (0) followed
+ * by a separator tone of 1000 Hz, each lasting 5 ms divided by the speed
+ * set with CONFIG_SPKMODEM_SPEED. Bytes are framed by a 200 Hz tone.
+ *
+ * Instead of counting zero crossings, the signal is cut into hops of an
+ * eighth of a tone. For every hop, the correlation with each of the three
+ * tone frequencies is computed at once, with the phase referenced to the
+ * start of the stream, so that the DFT bin of any window is just the sum
+ * of the hop values in it. Two windows of one tone length are kept up to
+ * date, and a bit is found when the older one holds a data tone and the
+ * newer one the separator. This only needs a few multiply-adds per sample,
+ * works for any sample rate and keeps working when the tones get short.
+ */
+
+#define TONE_RATE 200		/* 1 / 5 ms */
+#define HOPS_PER_TONE 8
+
+#define FREQ_SEP 1000
+#define FREQ_ONE 2000
+#define FREQ_ZERO 4000
+
+/* Fraction of the window energy a tone needs to have. */
+#define MIN_TONE_RATIO 0.3
+/* Minimum RMS level of a tone. */
+#define THRESHOLD 250
 
 #define DEBUG 0
-#define FLUSH_TIMEOUT 1
 
-static signed short trame[2 * SAMPLES_PER_TRAME];
-static signed short pulse[2 * SAMPLES_PER_TRAME];
-static int ringpos = 0;
-static int pos, f1, f2;
-static int amplitude = 0;
-static int lp = 0;
+enum
+{
+  TONE_SEP,
+  TONE_ONE,
+  TONE_ZERO,
+  NUM_TONES,
+  TONE_NONE = NUM_TONES
+};
+
+static const double tone_freq[NUM_TONES] = { FREQ_SEP, FREQ_ONE, FREQ_ZERO };
+
+struct hop
+{
+  double re[NUM_TONES];
+  double im[NUM_TONES];
+  double energy;
+};
+
+struct window
+{
+  double re[NUM_TONES];
+  double im[NUM_TONES];
+  double energy;
+};
+
+static int rate = 48000;
+static int speed = 1;
+static int channels = 1;
+
+static int hop_len;		/* samples per hop */
+static int window_hops;		/* hops per window, one tone */
+static float *cos_table[NUM_TONES];
+static float *sin_table[NUM_TONES];
+static double phase_re[NUM_TONES], phase_im[NUM_TONES];
+static double step_re[NUM_TONES], step_im[NUM_TONES];
+
+/* The last 2 * window_hops hops. */
+static struct hop *hops;
+static long hop_count;
+static struct window older, newer;
+
+static float *hop_samples;
+static int hop_fill;
+
+/* Bit decoder state. */
+static int bitn = 7;
+static unsigned char c;
+static long last_bit = -1;
+static long skip_until;
+static int candidate = -1;
+static double candidate_score;
+static int candidate_age;
 
 static void
-read_sample (void)
+init_tables (void)
 {
-  amplitude -= abs (trame[ringpos]);
-  f1 -= pulse[ringpos];
-  f1 += pulse[(ringpos + SAMPLES_PER_TRAME) % (2 * SAMPLES_PER_TRAME)];
-  f2 -= pulse[(ringpos + SAMPLES_PER_TRAME) % (2 * SAMPLES_PER_TRAME)];
-  fread (trame + ringpos, 1, sizeof (trame[0]), stdin);
-  amplitude += abs (trame[ringpos]);
-
-  if (pos ? (trame[ringpos] < -THRESHOLD)
-      : (trame[ringpos] > +THRESHOLD))
-    {
-      pulse[ringpos] = 1;
-      pos = !pos;
-      f2++;
-    }
-  else
-    pulse[ringpos] = 0;
-  ringpos++;
-  ringpos %= 2 * SAMPLES_PER_TRAME;
-  lp++;
+  int f, n;
+
+  hop_len = rate / (TONE_RATE * speed * HOPS_PER_TONE);
+  if (hop_len < 1)
+    hop_len = 1;
+  window_hops = rate / (TONE_RATE * speed * hop_len);
+
+  hops = calloc (2 * window_hops, sizeof (*hops));
+  hop_samples = calloc (hop_len, sizeof (*hop_samples));
+  if (!hops || !hop_samples)
+    {
+      perror ("calloc");
+      exit (1);
+    }
+
+  for (f = 0; f < NUM_TONES; f++)
+    {
+      const double w = 2 * M_PI * tone_freq[f] / rate;
+
+      cos_table[f] = malloc (hop_len * sizeof (float));
+      sin_table[f] = malloc (hop_len * sizeof (float));
+      if (!cos_table[f] || !sin_table[f])
+	{
+	  perror ("malloc");
+	  exit (1);
+	}
+      for (n = 0; n < hop_len; n++)
+	{
+	  cos_table[f][n] = cos (w * n);
+	  sin_table[f][n] = sin (w * n);
+	}
+      phase_re[f] = 1;
+      phase_im[f] = 0;
+      step_re[f] = cos (w * hop_len);
+      step_im[f] = -sin (w * hop_len);
+    }
 }
 
-int
-main ()
+/* Correlates one hop with all tones, referenced to the stream start. */
+static void
+analyze_hop (const float *x, struct hop *h)
 {
-  int bitn = 7;
-  char c = 0;
-  int i;
-  int llp = 0;
-  while (!feof (stdin))
+  int f, n;
+
+  h->energy = 0;
+  for (n = 0; n < hop_len; n++)
+    h->energy += x[n] * x[n];
+
+  for (f = 0; f < NUM_TONES; f++)
     {
-      if (lp > 3 * SAMPLES_PER_TRAME)
+      const float *ct = cos_table[f], *st = sin_table[f];
+      float re = 0, im = 0;
+      double pr, pi, len;
+
+      for (n = 0; n < hop_len; n++)
 	{
-	  bitn = 7;
-	  c = 0;
-	  lp = 0;
-	  llp++;
+	  re += x[n] * ct[n];
+	  im -= x[n] * st[n];
 	}
-      if (llp == FLUSH_TIMEOUT)
-	fflush (stdout);
-      if (f2 > FREQ_SEP_MIN && f2 < FREQ_SEP_MAX
-	  && f1 > FREQ_DATA_MIN && f1 < FREQ_DATA_MAX)
+
+      /* Rotate by the phase of the first sample of this hop. */
+      h->re[f] = re * phase_re[f] - im * phase_im[f];
+      h->im[f] = re * phase_im[f] + im * phase_re[f];
+
+      pr = phase_re[f] * step_re[f] - phase_im[f] * step_im[f];
+      pi = phase_re[f] * step_im[f] + phase_im[f] * step_re[f];
+      len = sqrt (pr * pr + pi * pi);
+      phase_re[f] = pr / len;
+      phase_im[f] = pi / len;
+    }
+}
+
+static void
+window_add (struct window *w, const struct hop *h, int sign)
+{
+  int f;
+
+  for (f = 0; f < NUM_TONES; f++)
+    {
+      w->re[f] += sign * h->re[f];
+      w->im[f] += sign * h->im[f];
+    }
+  w->energy += sign * h->energy;
+}
+
+/* Returns the tone in a window and its share of the window energy. */
+static int
+classify (const struct window *w, double *ratio)
+{
+  const double len = (double) window_hops * hop_len;
+  int f, best = TONE_NONE;
+  double r;
+
+  *ratio = 0;
+  if (w->energy < len * THRESHOLD * THRESHOLD)
+    return TONE_NONE;
+
+  for (f = 0; f < NUM_TONES; f++)
+    {
+      r = (w->re[f] * w->re[f] + w->im[f] * w->im[f]) / (w->energy * len / 2);
+      if (r > *ratio)
 	{
+	  *ratio = r;
+	  best = f;
+	}
+    }
+
+  return *ratio >= MIN_TONE_RATIO ? best : TONE_NONE;
+}
+
+static void
+emit_bit (int bit)
+{
 #if DEBUG
-	  printf ("%d %d %d @%d\n", f1, f2, FREQ_DATA_THRESHOLD,
-		  ftell (stdin) - sizeof (trame));
+  printf ("[%d @%ld]", bit, hop_count * hop_len);
 #endif
-	  if (f1 < FREQ_DATA_THRESHOLD)
-	    c |= (1 << bitn);
-	  bitn--;
-	  if (bitn < 0)
-	    {
+  if (bit)
+    c |= 1 << bitn;
+  bitn--;
+  if (bitn < 0)
+    {
 #if DEBUG
-	      printf ("<%c, %x>", c, c);
+      printf ("<%c, %x>", c, c);
 #else
-	      printf ("%c", c);
+      printf ("%c", c);
 #endif
-	      bitn = 7;
-	      c = 0;
+      bitn = 7;
+      c = 0;
+    }
+  last_bit = hop_count;
+  /* The same data/separator pair stays visible for a while. */
+  skip_until = hop_count + window_hops;
+}
+
+static void
+decode_hop (void)
+{
+  const int ring = 2 * window_hops;
+  struct hop *slot = &hops[hop_count % ring];
+  int old_tone, new_tone, valid;
+  double old_ratio, new_ratio, score;
+
+  /* The oldest hop leaves, the middle one moves from newer to older. */
+  if (hop_count >= ring)
+    window_add (&older, slot, -1);
+  if (hop_count >= window_hops)
+    {
+      const struct hop *mid = &hops[(hop_count - window_hops) % ring];
+
+      window_add (&older, mid, 1);
+      window_add (&newer, mid, -1);
+    }
+  analyze_hop (hop_samples, slot);
+  window_add (&newer, slot, 1);
+  hop_count++;
+
+  /* No bit for 1.5 bit times: the 200 Hz frame tone between bytes. */
+  if (last_bit >= 0 && hop_count - last_bit > 3 * window_hops)
+    {
+      bitn = 7;
+      c = 0;
+      last_bit = -1;
+      fflush (stdout);
+    }
+
+  if (hop_count < ring || hop_count < skip_until)
+    return;
+
+  old_tone = classify (&older, &old_ratio);
+  new_tone = classify (&newer, &new_ratio);
+  valid = new_tone == TONE_SEP
+    && (old_tone == TONE_ONE || old_tone == TONE_ZERO);
+  score = old_ratio < new_ratio ? old_ratio : new_ratio;
+
+  /* Take the best aligned position within a run of valid windows. */
+  if (valid && (candidate < 0 || score > candidate_score))
+    {
+      candidate = old_tone == TONE_ONE;
+      candidate_score = score;
+    }
+  if (candidate >= 0 && (!valid || ++candidate_age > window_hops / 2))
+    {
+      emit_bit (candidate);
+      candidate = -1;
+      candidate_age = 0;
+    }
+}
+
+static void
+process_samples (const short *buf, size_t count)
+{
+  size_t i;
+
+  for (i = 0; i < count; i += channels)
+    {
+      hop_samples[hop_fill++] = buf[i];
+      if (hop_fill == hop_len)
+	{
+	  decode_hop ();
+	  hop_fill = 0;
+	}
+    }
+}
+
+static unsigned int
+le16 (const unsigned char *p)
+{
+  return p[0] | p[1] << 8;
+}
+
+static unsigned int
+le32 (const unsigned char *p)
+{
+  return le16 (p) | (unsigned int) le16 (p + 2) << 16;
+}
+
+/*
+ * Parses a WAV header if there is one. Returns the number of bytes read
+ * that are samples already.
+ */
+static size_t
+read_header (FILE *in, unsigned char *buf, size_t size)
+{
+  unsigned char chunk[8], fmt[16];
+  size_t n, len;
+
+  n = fread (buf, 1, 12, in);
+  if (n < 12 || memcmp (buf, "RIFF", 4) || memcmp (buf + 8, "WAVE", 4))
+    return n;
+
+  while (fread (chunk, 1, 8, in) == 8)
+    {
+      len = le32 (chunk + 4);
+      if (!memcmp (chunk, "data", 4))
+	return 0;
+      if (!memcmp (chunk, "fmt ", 4) && len >= sizeof (fmt))
+	{
+	  if (fread (fmt, 1, sizeof (fmt), in) != sizeof (fmt))
+	    break;
+	  len -= sizeof (fmt);
+	  if (le16 (fmt) != 1 || le16 (fmt + 14) != 16)
+	    {
+	      fprintf (stderr, "Only 16-bit PCM WAV files are supported\n");
+	      exit (1);
 	    }
-	  lp = 0;
-	  llp = 0;
-	  for (i = 0; i < SAMPLES_PER_TRAME; i++)
-	    read_sample ();
-	  continue;
+	  channels = le16 (fmt + 2);
+	  rate = le32 (fmt + 4);
+	}
+      /* Chunks are padded to an even size. */
+      for (len += len & 1; len; len -= n)
+	{
+	  n = fread (buf, 1, len < size ? len : size, in);
+	  if (!n)
+	    break;
 	}
-      read_sample ();
     }
+
+  fprintf (stderr, "No data in WAV file\n");
+  exit (1);
+}
+
+static void
+usage (const char *name)
+{
+  fprintf (stderr, "Usage: %s [-r rate] [-s speed] [file]\n\n"
+	   "Decodes a spkmodem console from signed 16-bit little endian mono\n"
+	   "samples or a WAV file, read from stdin by default.\n\n"
+	   "  -r rate   sample rate of raw input (default 48000)\n"
+	   "  -s speed  CONFIG_SPKMODEM_SPEED of the firmware (default 1)\n",
+	   name);
+  exit (1);
+}
+
+int
+main (int argc, char *argv[])
+{
+  static short buf[4096];
+  FILE *in = stdin;
+  size_t n, odd;
+  int opt;
+
+  while ((opt = getopt (argc, argv, "r:s:h")) != -1)
+    {
+      switch (opt)
+	{
+	case 'r':
+	  rate = atoi (optarg);
+	  break;
+	case 's':
+	  speed = atoi (optarg);
+	  break;
+	default:
+	  usage (argv[0]);
+	}
+    }
+
+  if (optind < argc)
+    {
+      in = fopen (argv[optind], "rb");
+      if (!in)
+	{
+	  perror (argv[optind]);
+	  return 1;
+	}
+    }
+
+  n = read_header (in, (unsigned char *) buf, sizeof (buf));
+  if (rate <= 0 || speed <= 0 || channels <= 0
+      || rate <= 2 * FREQ_ZERO || rate < TONE_RATE * speed * HOPS_PER_TONE)
+    {
+      fprintf (stderr, "Unsupported rate %d, speed %d or %d channels\n",
+	       rate, speed, channels);
+      return 1;
+    }
+  init_tables ();
+
+  /* Samples are assumed to be in host byte order, like parec gives them. */
+  odd = n % (sizeof (buf[0]) * channels);
+  process_samples (buf, n / sizeof (buf[0]) - odd / sizeof (buf[0]));
+  memmove (buf, (unsigned char *) buf + n - odd, odd);
+
+  while ((n = fread ((unsigned char *) buf + odd, 1, sizeof (buf) - odd, in)))
+    {
+      n += odd;
+      odd = n % (sizeof (buf[0]) * channels);
+      process_samples (buf, (n - odd) / sizeof (buf[0]));
+      memmove (buf, (unsigned char *) buf + n - odd, odd);
+    }
+
+  fflush (stdout);
   return 0;
 }
@@ -0,0 +1,50 @@
+#!/usr/bin/env sh
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+# Decodes synthesized recordings at several sample rates, speeds and
+# signal levels and checks that the text comes out unchanged.
+
+set -e
+
+RECV=${1:-./spkmodem-recv}
+GEN=${2:-./tests/spkmodem-gen}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+cat > "$TMP/text" <<TEXT
+coreboot-4.12 Fri Oct 18 00:00:00 UTC 2026 bootblock starting (log level: 7)...
+FMAP: area COREBOOT found @ 200 (8388096 bytes)
+CBFS: Locating 'fallback/romstage'
+\$%&'()*+,-./0123456789:;<=>?@[\\]^_\`{|}~ 	!"#
+TEXT
+
+fail=0
+for speed in 1 2; do
+	for rate in 44100 48000 96000; do
+		for level in 8000:0.05 2000:0.2 20000:0.02; do
+			amplitude=${level%:*}
+			noise=${level#*:}
+			name="rate $rate, speed $speed, amplitude $amplitude, noise $noise"
+			"$GEN" "$TMP/in.wav" $rate $speed $amplitude $noise < "$TMP/text"
+			"$RECV" -s $speed "$TMP/in.wav" > "$TMP/out"
+			if cmp -s "$TMP/text" "$TMP/out"; then
+				echo "PASS: $name"
+			else
+				echo "FAIL: $name"
+				diff "$TMP/text" "$TMP/out" || true
+				fail=1
+			fi
+		done
+	done
+done
+
+# Raw samples on stdin, like from parec.
+tail -c +45 "$TMP/in.wav" | "$RECV" -r 96000 -s 2 > "$TMP/out"
+if cmp -s "$TMP/text" "$TMP/out"; then
+	echo "PASS: raw input"
+else
+	echo "FAIL: raw input"
+	fail=1
+fi
+
+exit $fail
@@ -0,0 +1,185 @@
+/* spkmodem-gen.c - synthesize spkmodem recordings for testing */
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Writes a 16-bit mono WAV file of what a microphone next to a PC speaker
+ * would pick up while src/drivers/pc80/pc/spkmodem.c sends stdin: PIT
+ * square waves of the same half period counts, low pass filtered by the
+ * speaker, with some noise, hum and idle time between lines.
+ */
+
+#define SPEAKER_PIT_FREQUENCY 0x1234dd
+
+static int rate = 48000;
+static int speed = 1;
+static double amplitude = 8000;
+static double noise = 0.05;
+
+static double t;		/* current time in seconds */
+static double level = 1;	/* square wave output, -1 or 1 */
+static double filtered;
+static FILE *out;
+static unsigned long samples;
+
+static double
+rand_uniform (void)
+{
+  return rand () / (RAND_MAX + 1.0) * 2 - 1;
+}
+
+static void
+put_sample (double v)
+{
+  short s;
+
+  if (v > 32767)
+    v = 32767;
+  if (v < -32768)
+    v = -32768;
+  s = v;
+  fputc (s & 0xff, out);
+  fputc ((s >> 8) & 0xff, out);
+  samples++;
+}
+
+/* Plays `level` until time `end`. */
+static void
+play_until (double end)
+{
+  const double alpha = 1 - exp (-2 * M_PI * 6000.0 / rate);
+
+  while (samples < end * rate)
+    {
+      double v;
+
+      filtered += alpha * (level * amplitude - filtered);
+      v = filtered + noise * amplitude * rand_uniform ()
+	+ 0.05 * amplitude * sin (2 * M_PI * 50 * samples / rate);
+      put_sample (v);
+    }
+  t = end;
+}
+
+static void
+make_tone (unsigned int freq, unsigned int half_periods)
+{
+  const double half = (double) (SPEAKER_PIT_FREQUENCY / freq) / 2
+    / SPEAKER_PIT_FREQUENCY;
+
+  /* Like the PIT, at least one half period is always played. */
+  do
+    {
+      play_until (t + half);
+      level = -level;
+    }
+  while (half_periods-- > 1);
+}
+
+static void
+silence (double seconds)
+{
+  double saved = amplitude;
+
+  amplitude = 0;
+  play_until (t + seconds);
+  amplitude = saved;
+}
+
+static void
+tx_byte (unsigned char c)
+{
+  int i;
+
+  make_tone (200, 4 / speed);
+  for (i = 7; i >= 0; i--)
+    {
+      if ((c >> i) & 1)
+	make_tone (2000, 20 / speed);
+      else
+	make_tone (4000, 40 / speed);
+      make_tone (1000, 10 / speed);
+    }
+  /* The last tone keeps playing until the next byte. */
+  make_tone (200, 1 + rand () % 3);
+}
+
+static void
+write_header (unsigned long data_size)
+{
+  unsigned char h[44];
+
+  memcpy (h, "RIFF", 4);
+  h[4] = (data_size + 36) & 0xff;
+  h[5] = ((data_size + 36) >> 8) & 0xff;
+  h[6] = ((data_size + 36) >> 16) & 0xff;
+  h[7] = ((data_size + 36) >> 24) & 0xff;
+  memcpy (h + 8, "WAVEfmt ", 8);
+  h[16] = 16; h[17] = 0; h[18] = 0; h[19] = 0;
+  h[20] = 1; h[21] = 0;		/* PCM */
+  h[22] = 1; h[23] = 0;		/* mono */
+  h[24] = rate & 0xff;
+  h[25] = (rate >> 8) & 0xff;
+  h[26] = (rate >> 16) & 0xff;
+  h[27] = 0;
+  h[28] = (rate * 2) & 0xff;
+  h[29] = ((rate * 2) >> 8) & 0xff;
+  h[30] = ((rate * 2) >> 16) & 0xff;
+  h[31] = 0;
+  h[32] = 2; h[33] = 0;		/* block align */
+  h[34] = 16; h[35] = 0;	/* bits per sample */
+  memcpy (h + 36, "data", 4);
+  h[40] = data_size & 0xff;
+  h[41] = (data_size >> 8) & 0xff;
+  h[42] = (data_size >> 16) & 0xff;
+  h[43] = (data_size >> 24) & 0xff;
+  fwrite (h, 1, sizeof (h), out);
+}
+
+int
+main (int argc, char *argv[])
+{
+  int ch;
+
+  if (argc < 2 || argc > 6)
+    {
+      fprintf (stderr, "Usage: %s out.wav [rate [speed [amplitude [noise]]]] < text\n",
+	       argv[0]);
+      return 1;
+    }
+  if (argc > 2)
+    rate = atoi (argv[2]);
+  if (argc > 3)
+    speed = atoi (argv[3]);
+  if (argc > 4)
+    amplitude = atof (argv[4]);
+  if (argc > 5)
+    noise = atof (argv[5]);
+
+  out = fopen (argv[1], "wb");
+  if (!out)
+    {
+      perror (argv[1]);
+      return 1;
+    }
+  srand (rate + speed);
+
+  write_header (0);
+  silence (0.1);
+  while ((ch = getchar ()) != EOF)
+    {
+      tx_byte (ch);
+      if (ch == '\n')
+	silence (0.01 * (rand () % 10));
+    }
+  silence (0.1);
+
+  rewind (out);
+  write_header (samples * 2);
+  fclose (out);
+  return 0;
+}
@@ -42,12 +42,14 @@ static const struct superio_registers reg_table[] = {
 
 static void enter_conf_mode_ali(uint16_t port)
 {
+	conf_mode_enter(port, "5123");
 	OUTB(0x51, port);
 	OUTB(0x23, port);
 }
 
 static void exit_conf_mode_ali(uint16_t port)
 {
+	conf_mode_exit();
 	OUTB(0xbb, port);
 }
 
@@ -48,11 +48,13 @@ static const struct superio_registers reg_table[] = {
 /* same as serverengines */
 static void enter_conf_mode_ec(uint16_t port)
 {
+	conf_mode_enter(port, "5a");
 	OUTB(0x5a, port);
 }
 
 static void exit_conf_mode_ec(uint16_t port)
 {
+	conf_mode_exit();
 	OUTB(0xa5, port);
 }
 
@@ -50,12 +50,14 @@ static const struct superio_registers reg_table[] = {
 
 static void enter_conf_mode_ast(uint16_t port)
 {
+	conf_mode_enter(port, "a5a5");
 	OUTB(0xa5, port);
 	OUTB(0xa5, port);
 }
 
 static void exit_conf_mode_ast(uint16_t port)
 {
+	conf_mode_exit();
 	OUTB(0xaa, port);
 }
 
@@ -37,12 +37,14 @@ static const struct superio_registers reg_table[] = {
 
 void enter_conf_mode_exar(uint16_t port)
 {
+	conf_mode_enter(port, "6767");
 	OUTB(0x67, port);
 	OUTB(0x67, port);
 }
 
 void exit_conf_mode_exar(uint16_t port)
 {
+	conf_mode_exit();
 	OUTB(0xaa, port);
 }
 
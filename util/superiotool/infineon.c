@@ -20,11 +20,13 @@ static const struct superio_registers reg_table[] = {
 /* same as some SMSC */
 static void enter_conf_mode_infineon(uint16_t port)
 {
+	conf_mode_enter(port, "55");
 	OUTB(0x55, port);
 }
 
 static void exit_conf_mode_infineon(uint16_t port)
 {
+	conf_mode_exit();
 	OUTB(0xaa, port);
 }
 
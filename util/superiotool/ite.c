@@ -1458,10 +1458,13 @@ static const uint8_t initkey_mbpnp[] = {
 };
 
 /* Works for: IT8661F/IT8770F, IT8671F/IT8687R, IT8673F. */
-static void enter_conf_mode_ite_legacy(uint16_t port, const uint8_t init[][4])
+static void enter_conf_mode_ite_legacy(uint16_t port, const uint8_t init[][4],
+				       const char *key)
 {
 	int i, idx;
 
+	conf_mode_enter(port, key);
+
 	/* Determine Super I/O config port. */
 	idx = (port == 0x3f0) ? 0 : ((port == 0x3bd) ? 1 : 2);
 	for (i = 0; i < 4; i++)
@@ -1474,6 +1477,7 @@ static void enter_conf_mode_ite_legacy(uint16_t port, const uint8_t init[][4])
 
 static void enter_conf_mode_ite(uint16_t port)
 {
+	conf_mode_enter(port, "870155");
 	OUTB(0x87, port);
 	OUTB(0x01, port);
 	OUTB(0x55, port);
@@ -1482,6 +1486,7 @@ static void enter_conf_mode_ite(uint16_t port)
 
 static void enter_conf_mode_ite_it8502e(uint16_t port)
 {
+	conf_mode_enter(port, "850255");
 	OUTB(0x85, port);
 	OUTB(0x02, port);
 	OUTB(0x55, port);
@@ -1490,6 +1495,7 @@ static void enter_conf_mode_ite_it8502e(uint16_t port)
 
 static void enter_conf_mode_ite_it8761e(uint16_t port)
 {
+	conf_mode_enter(port, "876155");
 	OUTB(0x87, port);
 	OUTB(0x61, port);
 	OUTB(0x55, port);
@@ -1498,6 +1504,7 @@ static void enter_conf_mode_ite_it8761e(uint16_t port)
 
 static void enter_conf_mode_ite_it8228e(uint16_t port)
 {
+	conf_mode_enter(port, "822855");
 	OUTB(0x82, port);
 	OUTB(0x28, port);
 	OUTB(0x55, port);
@@ -1506,6 +1513,7 @@ static void enter_conf_mode_ite_it8228e(uint16_t port)
 
 static void enter_conf_mode_ite_it8987e(uint16_t port)
 {
+	conf_mode_enter(port, "898755");
 	OUTB(0x89, port);
 	OUTB(0x87, port);
 	OUTB(0x55, port);
@@ -1514,6 +1522,7 @@ static void enter_conf_mode_ite_it8987e(uint16_t port)
 
 static void exit_conf_mode_ite(uint16_t port)
 {
+	conf_mode_exit();
 	regwrite(port, 0x02, 0x02);
 }
 
@@ -1569,13 +1578,13 @@ void probe_idregs_ite(uint16_t port)
 	chip_found_at_port = 0;
 
 	if (port == 0x3f0 || port == 0x3bd || port == 0x370) {
-		enter_conf_mode_ite_legacy(port, initkey_it8661f);
+		enter_conf_mode_ite_legacy(port, initkey_it8661f, "it8661f");
 		probe_idregs_ite_helper("(init=legacy/it8661f) ", port);
 		exit_conf_mode_ite(port);
 		if (chip_found_at_port)
 			return;
 
-		enter_conf_mode_ite_legacy(port, initkey_it8671f);
+		enter_conf_mode_ite_legacy(port, initkey_it8671f, "it8671f");
 		probe_idregs_ite_helper("(init=legacy/it8671f) ", port);
 		exit_conf_mode_ite(port);
 		if (chip_found_at_port)
@@ -9,6 +9,10 @@ struct pci_dev *pci_dev_find(uint16_t vendor, uint16_t device)
 	struct pci_dev *temp;
 	struct pci_filter filter;
 
+	/* No PCI access when decoding a snapshot. */
+	if (!pacc)
+		return NULL;
+
 	pci_filter_init(NULL, &filter);
 	filter.vendor = vendor;
 	filter.device = device;
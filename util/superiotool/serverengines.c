@@ -50,11 +50,13 @@ static const struct superio_registers reg_table[] = {
 
 static void enter_conf_mode_serverengines(uint16_t port)
 {
+	conf_mode_enter(port, "5a");
 	OUTB(0x5a, port);
 }
 
 static void exit_conf_mode_serverengines(uint16_t port)
 {
+	conf_mode_exit();
 	OUTB(0xa5, port);
 }
 
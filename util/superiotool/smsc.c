@@ -997,12 +997,14 @@ static void enter_conf_mode_smsc(uint16_t port)
 	 * in the assumption that the extra 0x55 won't hurt the other
 	 * Super I/Os. This is verified to be true on (at least) the FDC37N769.
 	 */
+	conf_mode_enter(port, "5555");
 	OUTB(0x55, port);
 	OUTB(0x55, port);
 }
 
 static void exit_conf_mode_smsc(uint16_t port)
 {
+	conf_mode_exit();
 	OUTB(0xaa, port);
 }
 
@@ -13,6 +13,95 @@ int dump = 0, verbose = 0, extra_dump = 0, alternate_dump = 0;
 /* Global flag which indicates whether a chip was detected at all. */
 int chip_found = 0;
 
+/*
+ * Config mode snapshots.
+ *
+ * conf_mode_enter() names the key sequence that put the chip at a config port
+ * into config mode, and conf_mode_exit() ends it. Every config register read
+ * in between is recorded by port, key sequence, selected logical device and
+ * index, and -s saves these records to a file. With -o such a file is loaded
+ * instead, no I/O port is touched and config register reads are answered from
+ * it, so the registers of another machine can be decoded. All other port reads
+ * return 0xff then and are counted, so that main() can say what is missing.
+ */
+
+struct snapshot_reg {
+	uint16_t port;
+	char key[16];
+	uint8_t ldn;
+	uint8_t reg;
+	uint8_t val;
+};
+
+static struct {
+	uint16_t port;
+	const char *key;	/* NULL when not in config mode. */
+	uint8_t ldn;		/* 0xff until one is selected. */
+} conf_mode;
+
+static struct snapshot_reg *snapshot;
+static size_t snapshot_count, snapshot_max;
+
+/* Set when decoding a snapshot. */
+int offline = 0;
+
+/* Port reads the snapshot could not answer. */
+static unsigned int offline_misses;
+
+static struct snapshot_reg *snapshot_find(uint16_t port, const char *key,
+					  uint8_t ldn, uint8_t reg)
+{
+	size_t i;
+
+	for (i = 0; i < snapshot_count; i++) {
+		if (snapshot[i].port == port && snapshot[i].ldn == ldn &&
+		    snapshot[i].reg == reg && !strcmp(snapshot[i].key, key))
+			return &snapshot[i];
+	}
+	return NULL;
+}
+
+static void snapshot_add(uint16_t port, const char *key, uint8_t ldn,
+			 uint8_t reg, uint8_t val)
+{
+	struct snapshot_reg *r = snapshot_find(port, key, ldn, reg);
+
+	if (!r) {
+		if (snapshot_count == snapshot_max) {
+			snapshot_max = snapshot_max ? snapshot_max * 2 : 256;
+			snapshot = realloc(snapshot, snapshot_max * sizeof(*snapshot));
+			if (!snapshot) {
+				perror("realloc");
+				exit(1);
+			}
+		}
+		r = &snapshot[snapshot_count++];
+		r->port = port;
+		snprintf(r->key, sizeof(r->key), "%s", key);
+		r->ldn = ldn;
+		r->reg = reg;
+	}
+	r->val = val;
+}
+
+uint8_t offline_inb(uint16_t port)
+{
+	offline_misses++;
+	return 0xff;
+}
+
+void conf_mode_enter(uint16_t port, const char *key)
+{
+	conf_mode.port = port;
+	conf_mode.key = key;
+	conf_mode.ldn = 0xff;
+}
+
+void conf_mode_exit(void)
+{
+	conf_mode.key = NULL;
+}
+
 static void set_bank(uint16_t port, uint8_t bank)
 {
 	OUTB(0x4E, port);
@@ -27,39 +116,110 @@ static uint8_t datareg(uint16_t port, uint8_t reg)
 
 uint8_t regval(uint16_t port, uint8_t reg)
 {
+	const struct snapshot_reg *r;
+	uint8_t val;
+
+	if (!conf_mode.key || port != conf_mode.port) {
+		OUTB(reg, port);
+		return INB(port + ((port == 0x3bd) ? 2 : 1)); /* 0x3bd is special. */
+	}
+
+	if (offline) {
+		r = snapshot_find(port, conf_mode.key, conf_mode.ldn, reg);
+		return r ? r->val : offline_inb(port);
+	}
+
 	OUTB(reg, port);
-	return INB(port + ((port == 0x3bd) ? 2 : 1)); /* 0x3bd is special. */
+	val = INB(port + ((port == 0x3bd) ? 2 : 1)); /* 0x3bd is special. */
+	snapshot_add(port, conf_mode.key, conf_mode.ldn, reg, val);
+	return val;
 }
 
 void regwrite(uint16_t port, uint8_t reg, uint8_t val)
 {
+	if (conf_mode.key && port == conf_mode.port && reg == 0x07)
+		conf_mode.ldn = val;
+
 	OUTB(reg, port);
 	OUTB(val, port + 1);
 }
 
 void enter_conf_mode_winbond_fintek_ite_8787(uint16_t port)
 {
+	conf_mode_enter(port, "8787");
 	OUTB(0x87, port);
 	OUTB(0x87, port);
 }
 
 void exit_conf_mode_winbond_fintek_ite_8787(uint16_t port)
 {
+	conf_mode_exit();
 	OUTB(0xaa, port);		/* Fintek, Winbond */
 	regwrite(port, 0x02, 0x02);	/* ITE */
 }
 
 void enter_conf_mode_fintek_7777(uint16_t port)
 {
+	conf_mode_enter(port, "7777");
 	OUTB(0x77, port);
 	OUTB(0x77, port);
 }
 
 void exit_conf_mode_fintek_7777(uint16_t port)
 {
+	conf_mode_exit();
 	OUTB(0xaa, port);		/* Fintek */
 }
 
+static void save_snapshot(const char *filename)
+{
+	FILE *f;
+	size_t i;
+
+	f = fopen(filename, "w");
+	if (!f) {
+		perror(filename);
+		exit(1);
+	}
+
+	fprintf(f, "# superiotool snapshot: port key ldn index value\n");
+	for (i = 0; i < snapshot_count; i++) {
+		fprintf(f, "%04x %s %02x %02x %02x\n", snapshot[i].port,
+			snapshot[i].key, snapshot[i].ldn, snapshot[i].reg,
+			snapshot[i].val);
+	}
+
+	if (fclose(f)) {
+		perror(filename);
+		exit(1);
+	}
+}
+
+static void load_snapshot(const char *filename)
+{
+	FILE *f;
+	char line[80], key[16];
+	unsigned int port, ldn, reg, val;
+
+	f = fopen(filename, "r");
+	if (!f) {
+		perror(filename);
+		exit(1);
+	}
+
+	while (fgets(line, sizeof(line), f)) {
+		if (line[0] == '#' || line[0] == '\n')
+			continue;
+		if (sscanf(line, "%x %15s %x %x %x", &port, key, &ldn, &reg, &val) != 5 ||
+		    port > 0xffff || ldn > 0xff || reg > 0xff || val > 0xff) {
+			fprintf(stderr, "%s: invalid line: %s", filename, line);
+			exit(1);
+		}
+		snapshot_add(port, key, ldn, reg, val);
+	}
+	fclose(f);
+}
+
 int superio_unknown(const struct superio_registers reg_table[], uint16_t id)
 {
 	return !strncmp(get_superio_name(reg_table, id), "<unknown>", 9);
@@ -270,6 +430,7 @@ static void print_version(void)
 int main(int argc, char *argv[])
 {
 	int i, j, opt, option_index;
+	const char *snapshot_file = NULL;
 #if defined(__FreeBSD__)
 	int io_fd;
 #endif
@@ -278,6 +439,8 @@ int main(int argc, char *argv[])
 		{"dump",		no_argument, NULL, 'd'},
 		{"extra-dump",		no_argument, NULL, 'e'},
 		{"alternate-dump",	no_argument, NULL, 'a'},
+		{"snapshot",		required_argument, NULL, 's'},
+		{"offline",		required_argument, NULL, 'o'},
 		{"list-supported",	no_argument, NULL, 'l'},
 		{"verbose",		no_argument, NULL, 'V'},
 		{"version",		no_argument, NULL, 'v'},
@@ -285,7 +448,7 @@ int main(int argc, char *argv[])
 		{0, 0, 0, 0}
 	};
 
-	while ((opt = getopt_long(argc, argv, "dealVvh",
+	while ((opt = getopt_long(argc, argv, "deas:o:lVvh",
 				  long_options, &option_index)) != EOF) {
 		switch (opt) {
 		case 'd':
@@ -297,6 +460,13 @@ int main(int argc, char *argv[])
 		case 'a':
 			alternate_dump = 1;
 			break;
+		case 's':
+			snapshot_file = optarg;
+			break;
+		case 'o':
+			load_snapshot(optarg);
+			offline = 1;
+			break;
 		case 'l':
 			print_list_of_supported_chips();
 			exit(0);
@@ -310,6 +480,7 @@ int main(int argc, char *argv[])
 			break;
 		case 'h':
 			printf(USAGE);
+			printf(USAGE_MORE);
 			printf(USAGE_INFO);
 			exit(0);
 			break;
@@ -320,24 +491,28 @@ int main(int argc, char *argv[])
 		}
 	}
 
+	if (!offline) {
 #if defined(__FreeBSD__)
-	if ((io_fd = open("/dev/io", O_RDWR)) < 0) {
-		perror("/dev/io");
+		if ((io_fd = open("/dev/io", O_RDWR)) < 0) {
+			perror("/dev/io");
 #else
-	if (iopl(3) < 0) {
-		perror("iopl");
+		if (iopl(3) < 0) {
+			perror("iopl");
 #endif
-		printf("Superiotool must be run as root.\n");
-		exit(1);
+			printf("Superiotool must be run as root.\n");
+			exit(1);
+		}
 	}
 
 	print_version();
 
 #ifdef PCI_SUPPORT
-	/* Do some basic libpci init. */
-	pacc = pci_alloc();
-	pci_init(pacc);
-	pci_scan_bus(pacc);
+	/* Do some basic libpci init. PCI devices are not part of snapshots. */
+	if (!offline) {
+		pacc = pci_alloc();
+		pci_init(pacc);
+		pci_scan_bus(pacc);
+	}
 #endif
 
 	for (i = 0; i < ARRAY_SIZE(superio_ports_table); i++) {
@@ -349,8 +524,18 @@ int main(int argc, char *argv[])
 	if (!chip_found)
 		printf("No Super I/O found\n");
 
+	if (offline_misses)
+		fprintf(stderr, "Warning: %u port reads were not in the snapshot and "
+			"read as 0xff. Chips probed without a config mode key\n"
+			"(e.g. NSC) or through PCI can't be decoded offline.\n",
+			offline_misses);
+
+	if (snapshot_file)
+		save_snapshot(snapshot_file);
+
 #if defined(__FreeBSD__)
-	close(io_fd);
+	if (!offline)
+		close(io_fd);
 #endif
 	return 0;
 }
@@ -27,21 +27,25 @@
 #if defined(__FreeBSD__)
 #include <sys/types.h>
 #include <machine/cpufunc.h>
-#define OUTB(x, y) do { u_int tmp = (y); outb(tmp, (x)); } while (0)
+#define RAW_OUTB(x, y) do { u_int tmp = (y); outb(tmp, (x)); } while (0)
 #define OUTW(x, y) do { u_int tmp = (y); outw(tmp, (x)); } while (0)
 #define OUTL(x, y) do { u_int tmp = (y); outl(tmp, (x)); } while (0)
-#define INB(x) __extension__ ({ u_int tmp = (x); inb(tmp); })
+#define RAW_INB(x) __extension__ ({ u_int tmp = (x); inb(tmp); })
 #define INW(x) __extension__ ({ u_int tmp = (x); inw(tmp); })
 #define INL(x) __extension__ ({ u_int tmp = (x); inl(tmp); })
 #else
-#define OUTB outb
+#define RAW_OUTB outb
 #define OUTW outw
 #define OUTL outl
-#define INB  inb
+#define RAW_INB  inb
 #define INW  inw
 #define INL  inl
 #endif
 
+/* Decoding a snapshot (-o) never touches an I/O port. */
+#define OUTB(x, y)	do { if (!offline) RAW_OUTB(x, y); } while (0)
+#define INB(x)		(offline ? offline_inb(x) : RAW_INB(x))
+
 #if defined(__NetBSD__) && (defined(__i386__) || defined(__x86_64__))
 #include <sys/types.h>
 #include <machine/sysarch.h>
@@ -91,10 +95,14 @@ static __inline__ uint32_t inl(uint16_t port)
 }
 #endif
 
-#define USAGE "Usage: superiotool [-d] [-e] [-a] [-l] [-V] [-v] [-h]\n\n\
+#define USAGE "Usage: superiotool [-d] [-e] [-a] [-s file] [-o file] [-l] [-V] [-v] [-h]\n\n\
   -d | --dump            Dump Super I/O register contents\n\
   -e | --extra-dump      Dump secondary registers too (e.g. EC registers)\n\
   -a | --alternate-dump  Use alternative dump format, more suitable for diff\n\
+  -s | --snapshot <file> Save the config registers that were read to a file\n\
+  -o | --offline <file>  Decode a snapshot instead of accessing the hardware\n"
+
+#define USAGE_MORE "\
   -l | --list-supported  Show the list of supported Super I/O chips\n\
   -V | --verbose         Verbose mode\n\
   -v | --version         Show the superiotool version\n\
@@ -133,6 +141,7 @@ and print its vendor, name, ID, revision, and config port.\n"
 extern int dump, verbose, extra_dump;
 
 extern int chip_found;
+extern int offline;
 
 struct superio_registers {
 	int32_t superio_id;		/* Signed, as we need EOT. */
@@ -152,6 +161,9 @@ struct pci_dev *pci_dev_find(uint16_t vendor, uint16_t device);
 #endif
 
 /* superiotool.c */
+uint8_t offline_inb(uint16_t port);
+void conf_mode_enter(uint16_t port, const char *key);
+void conf_mode_exit(void);
 uint8_t regval(uint16_t port, uint8_t reg);
 void regwrite(uint16_t port, uint8_t reg, uint8_t val);
 void enter_conf_mode_winbond_fintek_ite_8787(uint16_t port);
@@ -944,16 +944,19 @@ static const struct superio_registers hwm_table[] = {
 
 static void enter_conf_mode_winbond_88(uint16_t port)
 {
+	conf_mode_enter(port, "88");
 	OUTB(0x88, port);
 }
 
 static void enter_conf_mode_winbond_89(uint16_t port)
 {
+	conf_mode_enter(port, "89");
 	OUTB(0x89, port);
 }
 
 static void enter_conf_mode_winbond_86(uint16_t port)
 {
+	conf_mode_enter(port, "8686");
 	OUTB(0x86, port);
 	OUTB(0x86, port);
 }